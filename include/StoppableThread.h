@@ -16,7 +16,10 @@
 #ifndef __CINT__
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <thread>
+
+#include "ThreadsafeQueue.h"
 #endif
 
 #include <sstream>
@@ -91,6 +94,18 @@ protected:
    static std::map<std::string, StoppableThread*> fThreadMap;
 
 #ifndef __CINT__
+   /// Lets this loop wait for new data in any of the given queues instead of polling them.
+   template <typename T>
+   void WakeOn(const std::shared_ptr<ThreadsafeQueue<T>>& queue)
+   {
+      queue->SetWakeup(fWakeup);
+   }
+   /// Waits until one of the queues passed to WakeOn got data or was finished, the thread was stopped,
+   /// or the time ran out.
+   bool WaitForInput(int millisecond_wait = 1000) { return fWakeup->Wait(millisecond_wait); }
+
+   std::shared_ptr<ThreadsafeQueueWakeup> fWakeup; ///< notified by the input queues and by Stop()
+
    std::atomic_size_t fItemsPopped{0}; ///< number of items popped from input queue
    std::atomic_long   fInputSize{0};   ///< number of items in the input (queue), only updated within Iteration(), so not
                                        ///< always fully up-to-date (signed to hold error from queue::pop)
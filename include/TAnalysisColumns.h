@@ -0,0 +1,101 @@
+#ifndef TANALYSISCOLUMNS_H
+#define TANALYSISCOLUMNS_H
+
+/** \addtogroup Loops
+ *  @{
+ */
+
+#include <map>
+#include <vector>
+#ifndef __CINT__
+#include <memory>
+#endif
+
+#include "TClass.h"
+#include "TTree.h"
+
+#include "TDetector.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \class TAnalysisColumns
+///
+/// Writes and reads the hits of the analysis tree as flat columns.
+///
+/// For each detector class the tree has a multiplicity branch (e.g.
+/// TGriffinMultiplicity) and one branch per hit value, each an array
+/// with one entry per hit: Address, Charge, KValue, Cfd, TimeStamp,
+/// Energy, and Time (e.g. TGriffinEnergy[TGriffinMultiplicity]).
+/// These are plain arrays, so no streamers are involved, and only the
+/// columns that are asked for are read:
+///
+/// \code
+/// TAnalysisColumns columns(tree);
+/// for(Long64_t entry = 0; entry < tree->GetEntries(); ++entry) {
+///    columns.SetEntry(entry);
+///    const Double_t* energy = columns.GetEnergy(TGriffin::Class());
+///    for(Int_t i = 0; i < columns.GetMultiplicity(TGriffin::Class()); ++i) {
+///       ...
+///    }
+/// }
+/// \endcode
+///
+/// GetDetector() rebuilds the detector of the current entry from the
+/// raw values (address, charge, k-value, cfd, and time stamp) the same
+/// way the detectors are built from fragments. Everything else (energy,
+/// position, addback, ...) is calculated by the detector as usual, but
+/// waveforms and pile-up information aren't part of the columns.
+///
+/// The columns are written by TAnalysisWriteLoop to the AnalysisColumns
+/// tree if --column-tree is set.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+class TAnalysisColumns {
+public:
+   explicit TAnalysisColumns(TTree* tree, bool write = false);
+   ~TAnalysisColumns();
+
+   // writing
+   void AddDetector(TClass* cls); ///< creates the columns of this class, filled with empty entries up to now
+#ifndef __CINT__
+   void Fill(const std::vector<std::shared_ptr<TDetector>>& detectors); ///< fills the hits of these detectors
+#endif
+
+   // reading
+   void SetEntry(Long64_t entry) { fEntry = entry; } ///< selects the entry, the columns are only read when used
+   Long64_t GetEntry() const { return fEntry; }
+
+   Int_t           GetMultiplicity(TClass* cls);
+   const UInt_t*   GetAddress(TClass* cls);
+   const Float_t*  GetCharge(TClass* cls);
+   const Short_t*  GetKValue(TClass* cls);
+   const Int_t*    GetCfd(TClass* cls);
+   const Long64_t* GetTimeStamp(TClass* cls);
+   const Double_t* GetEnergy(TClass* cls);
+   const Double_t* GetTime(TClass* cls);
+
+   TDetector* GetDetector(TClass* cls); ///< detector of the current entry, owned by this class
+   template <typename T>
+   T* GetDetector()
+   {
+      return static_cast<T*>(GetDetector(T::Class()));
+   }
+
+private:
+   struct TDetectorColumns;
+   TDetectorColumns* Columns(TClass* cls); ///< columns of this class, nullptr if there are none
+
+   TTree*   fTree;
+   bool     fWrite;
+   Long64_t fEntry;
+#ifndef __CINT__
+   std::map<TClass*, std::unique_ptr<TDetectorColumns>> fColumns;
+   std::shared_ptr<TFragment> fFragment; ///< used to rebuild the detectors
+#endif
+
+   ClassDef(TAnalysisColumns, 0);
+};
+
+/*! @} */
+#endif
@@ -13,6 +13,7 @@
 #include "StoppableThread.h"
 #include "ThreadsafeQueue.h"
 #include "TUnpackedEvent.h"
+#include "TAnalysisColumns.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
@@ -20,6 +21,15 @@
 ///
 /// This loop writes built events to file
 ///
+/// Before the first event is written, branches are created for the
+/// detector classes of all channels (and those given with
+/// --analysis-branches). A detector class that shows up later gets
+/// its branch then, but that branch has to be filled with empty
+/// detectors for all previous entries first.
+///
+/// With --column-tree the hits are also written as flat columns to
+/// the AnalysisColumns tree (see TAnalysisColumns).
+///
 ////////////////////////////////////////////////////////////////////////////////
 
 class TAnalysisWriteLoop : public StoppableThread {
@@ -50,10 +60,15 @@ protected:
 private:
    TAnalysisWriteLoop(std::string name, std::string output_filename);
    void AddBranch(TClass* cls);
+   void AddBranches();
 
    void WriteEvent(TUnpackedEvent& event);
    TFile* fOutputFile;
    TTree* fEventTree;
+   bool   fBranchesAdded; ///< whether AddBranches has been called
+
+   TTree*            fColumnTree;
+   TAnalysisColumns* fColumns;
 
    TTree*     fOutOfOrderTree;
    TFragment* fOutOfOrderFrag;
@@ -36,6 +36,9 @@ public:
    void Clear(Option_t* opt = "") override;
    void Print(Option_t* opt = "") const override;
 
+   // the BadFragmentTree has no waveform branch
+   bool WaveformInRecord() const override { return true; }
+
 private:
    std::vector<uint32_t> fData;
    int                   fFailedWord;
@@ -58,12 +58,17 @@ public:
 
    ~TChannel() override;
 
-   static int  GetNumberOfChannels() { return fChannelMap->size(); }
+   static int  GetNumberOfChannels();
    static void AddChannel(TChannel*, Option_t* opt = "");
    static int UpdateChannel(TChannel*, Option_t* opt = "");
 
-   static std::map<unsigned int, TChannel*>* GetChannelMap() { return fChannelMap; }
+   static std::map<unsigned int, TChannel*>* GetChannelMap();
    static void DeleteAllChannels();
+   static void BuildChannelTable();
+   static void BeginUpdate();
+   static int  EndUpdate();
+   static UInt_t GetGeneration();
+   static void ReaderCheckpoint();
 
    static bool CompareChannels(const TChannel&, const TChannel&);
 
@@ -99,6 +104,12 @@ private:
    double               fEFFChi2;          // Chi2 of Efficiency calibration
    std::vector<double> fCTCoefficients; // Cross talk coefficients
 
+   // energy calibration compiled by CompileCalibration
+   double fENGPolynomial[4]; //!<! a_0 to a_3 as doubles, unused ones are zero
+   double fENGSqrt;          //!<! a_4, the coefficient of the square root term
+   bool   fENGUseSqrt;       //!<! whether there is a square root term
+   bool   fENGCompiled;      //!<! whether the above match fENGCoefficients
+
    std::vector<double>  fResidualValues;
    std::vector<double>  fResidualEnergies;
    TSpline3             fResSpline; 
@@ -119,8 +130,16 @@ private:
    static void UpdateChannelMap();
    void        OverWriteChannel(TChannel*);
    void        AppendChannel(TChannel*);
+   bool        SameSettings(const TChannel*) const;
+   void        GetENGPolynomial(double* polynomial, double& sqrtCoefficient, bool& useSqrt) const;
+   int         Integration(int temp_int) const;
+   double      Dither(UInt_t stream, Long64_t timestamp, int value) const;
 
-   void SetENGCoefficients(std::vector<Float_t> tmp) { fENGCoefficients = std::move(tmp); }
+   void SetENGCoefficients(std::vector<Float_t> tmp)
+   {
+      fENGCoefficients = std::move(tmp);
+      fENGCompiled     = false;
+   }
    void SetCFDCoefficients(std::vector<double> tmp) { fCFDCoefficients = std::move(tmp); }
    void SetLEDCoefficients(std::vector<double> tmp) { fLEDCoefficients = std::move(tmp); }
    void SetTIMECoefficients(std::vector<double> tmp) { fTIMECoefficients = std::move(tmp); }
@@ -199,7 +218,11 @@ public:
    inline bool UseResiduals() const { return fUseResiduals; }
 
 
-   inline void AddENGCoefficient(Float_t temp) { fENGCoefficients.push_back(temp); }
+   inline void AddENGCoefficient(Float_t temp)
+   {
+      fENGCoefficients.push_back(temp);
+      fENGCompiled = false;
+   }
    inline void AddCFDCoefficient(double temp) { fCFDCoefficients.push_back(temp); }
    inline void AddLEDCoefficient(double temp) { fLEDCoefficients.push_back(temp); }
    inline void AddTIMECoefficient(double temp) { fTIMECoefficients.push_back(temp); }
@@ -243,12 +266,19 @@ public:
    double CalibrateENG(double);
    double CalibrateENG(double, int temp_int);
    double CalibrateENG(int, int temp_int = 0);
+   double CalibrateENG(int charge, int temp_int, Long64_t timestamp);
+   void CalibrateENG(const double* charges, double* energies, size_t n);
+   void CalibrateENG(const int* charges, const Long64_t* timestamps, double* energies, size_t n, int temp_int = 0);
+
+   void CompileCalibration();
 
    double CalibrateCFD(double);
    double CalibrateCFD(int);
+   double CalibrateCFD(int cfd, Long64_t timestamp);
 
    double CalibrateLED(double);
    double CalibrateLED(int);
+   double CalibrateLED(int led, Long64_t timestamp);
 
    double        CalibrateTIME(double);
    double        CalibrateTIME(int);
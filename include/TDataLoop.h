@@ -11,6 +11,13 @@
 ///
 /// This loop reads midas events from a midas file.
 ///
+/// Additional sources (the following subruns of the same run) can be added
+/// with AddSource. They are read back-to-back through the same pipeline, the
+/// ODB of each new midas file is only re-read if it differs from the
+/// previous one. The loop only moves on to the next source once the current
+/// one has been read to its end (empty sources are skipped), a read error or
+/// a corrupt event stops the loop.
+///
 ////////////////////////////////////////////////////////////////////////////////
 
 #ifndef __CINT__
@@ -23,6 +30,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <map>
+#include <vector>
 
 #include "StoppableThread.h"
 #include "ThreadsafeQueue.h"
@@ -55,6 +63,8 @@ public:
 
    void ReplaceSource(TRawFile* new_source);
    void ResetSource();
+   bool AddSource(TRawFile* source);
+   size_t GetNumberOfSources() const { return fSources.size(); }
 
    void SetSelfStopping(bool self_stopping) { fSelfStopping = self_stopping; }
    bool                      GetSelfStopping() const { return fSelfStopping; }
@@ -65,9 +75,16 @@ private:
    TDataLoop(const TDataLoop& other);
    TDataLoop& operator=(const TDataLoop& other);
 
+   bool NextSource();
+
    TRawFile* fSource;
    bool      fSelfStopping;
 
+   std::vector<TRawFile*> fSources;       ///< all sources, read in order
+   size_t                 fCurrentSource; ///< index of fSource in fSources
+   size_t                 fBytesDone;     ///< bytes read from all previous sources
+   size_t                 fOdbHash;       ///< hash of the last ODB we read
+
 #ifndef __CINT__
    std::shared_ptr<ThreadsafeQueue<std::shared_ptr<TRawEvent>>> fOutputQueue;
    std::mutex                                                   fSourceMutex;
@@ -77,7 +94,7 @@ private:
    TXMLOdb* fOdb;
 #endif
 
-   void SetFileOdb(uint32_t time, char* data, int size);
+   void SetFileOdb(uint32_t time, char* data, int size, bool firstFile = true);
    void SetRunInfo(uint32_t time);
    void SetEPICSOdb();
    void SetTIGOdb();
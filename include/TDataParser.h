@@ -36,6 +36,7 @@
 #include "TPPG.h"
 #include "TScaler.h"
 #include "TFragmentMap.h"
+#include "TFragmentPool.h"
 #include "ThreadsafeQueue.h"
 #include "TEpicsFrag.h"
 #include "TGRSIOptions.h"
@@ -104,7 +105,41 @@ public:
    void        SetFinished();
    std::string OutputQueueStatus();
 
+   /// Good fragments are collected in batches of up to BatchSize() fragments and pushed into the output
+   /// queues together, either once the batch is full or when Flush() is called (after each midas event/lst
+   /// chunk).
+   void   Flush();
+   void   SetBatchSize(size_t size) { fBatchSize = (size > 0) ? size : 1; }
+   size_t BatchSize() const { return fBatchSize; }
+
 #ifndef __CINT__
+   /// Type of the output of a parser in deferred mode, see TDeferredEntry.
+   enum class EDeferredType { kGood, kTigress, kReconstruct, kPileUp, kBad, kPPG, kEpics };
+
+   /// Output of a parser in deferred mode, i.e. what the parser would have pushed into the output queues or
+   /// handed to the TFragmentMap/TPPG. The entries of each midas event are applied by Release().
+   struct TDeferredEntry {
+      EDeferredType                 fType{EDeferredType::kGood};
+      std::shared_ptr<TFragment>    fFragment;
+      std::shared_ptr<TBadFragment> fBadFragment;
+      std::shared_ptr<TPPGData>     fPPGData;
+      std::shared_ptr<TEpicsFrag>   fEpicsFrag;
+      std::vector<Int_t>            fCharge;
+      std::vector<Short_t>          fIntLength;
+      bool fTimeStampReference{false}; ///< the time stamp of this fragment is used to reconstruct later time stamps
+      bool fGoodDiagnostics{false};    ///< the fragment is recorded as good by TParsingDiagnostics when it's released
+   };
+
+   /// In deferred mode the parser only decodes the data words of a midas event and collects the result in
+   /// DeferredEntries(). Everything that depends on previous midas events (fragment ids, entry numbers, the
+   /// time stamps used to reconstruct the high bits, the pile-up pairing of the TFragmentMap, and the
+   /// wrap-around of TIGRESS trigger ids) is left to the parser the entries are released to. This lets
+   /// several parsers decode midas events in parallel while one parser owns all the shared state.
+   void SetDeferredOutput(bool temp = true);
+   bool IsDeferred() const { return fDeferred; }
+   std::vector<TDeferredEntry>& DeferredEntries() { return fDeferredEntries; }
+   void Release(std::vector<TDeferredEntry>& entries);
+
    void SetStatusVariables(std::atomic_size_t* itemsPopped, std::atomic_long* inputSize)
    {
       fItemsPopped = itemsPopped;
@@ -137,7 +172,16 @@ private:
 
 	static TGRSIOptions* fOptions; ///< Static pointer to TGRSIOptions, gets set on the first call of GriffinDataToFragment
 
+   bool fDeferred; ///< Flag to collect the output in fDeferredEntries instead of pushing it
+
+   size_t fBatchSize; ///< maximum number of good fragments pushed at once
+
 #ifndef __CINT__
+   std::vector<TDeferredEntry> fDeferredEntries;
+
+   std::shared_ptr<TFragmentPool>                fFragmentPool; ///< recycles the fragments created by this parser
+   std::vector<std::shared_ptr<const TFragment>> fGoodBatch;    ///< good fragments not pushed yet
+
    std::atomic_size_t* fItemsPopped;
    std::atomic_long*   fInputSize;
 #endif
@@ -165,7 +209,7 @@ public:
                              time_t midasTime = 0);
    int FifoToFragment(unsigned short* data, int size, bool zerobuffer = false, unsigned int midasSerialNumber = 0,
                       time_t midasTime = 0);
-   int FippsToFragment(std::vector<char> data);
+   int FippsToFragment(const char* data, size_t size);
 
 private:
 // utility
@@ -176,6 +220,12 @@ private:
 
 private:
 #ifndef __CINT__
+   void Defer(EDeferredType type, const std::shared_ptr<TFragment>& frag, bool timeStampReference = false);
+   void AddPileUp(const std::shared_ptr<TFragment>& frag, const std::vector<Int_t>& charge,
+                  const std::vector<Short_t>& integrationLength);
+   void ReconstructHighTimeStamp(const std::shared_ptr<TFragment>& frag);
+   uint64_t UnwrapTIGTriggerId(uint32_t value);
+
    void SetTIGWave(uint32_t, const std::shared_ptr<TFragment>&);
    void SetTIGAddress(uint32_t, const std::shared_ptr<TFragment>&);
    void SetTIGCfd(uint32_t, const std::shared_ptr<TFragment>&);
@@ -0,0 +1,108 @@
+#ifndef TDECOMPRESSOR_H
+#define TDECOMPRESSOR_H
+
+/** \addtogroup Sorting
+ *  @{
+ */
+
+/////////////////////////////////////////////////////////////////
+///
+/// \class TDecompressor
+///
+/// Decompresses a gzip, bzip2, or zstd compressed file on its own
+/// threads, ahead of the thread reading from it.
+///
+/// A reader thread splits the input into blocks that can be
+/// decompressed independently (zstd frames, bgzf-style gzip
+/// members) and a pool of worker threads decompresses them into a
+/// ring of chunks. Read() hands out the decompressed data in the
+/// original order. If the input can't be split (plain gzip, bzip2,
+/// or a single huge zstd frame) the reader thread decompresses the
+/// stream itself, which still moves the decompression off the
+/// thread calling Read().
+///
+/////////////////////////////////////////////////////////////////
+
+#ifndef __CINT__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TDecompressor {
+public:
+   enum class EFormat { kGzip, kBzip2, kZstd };
+
+   TDecompressor(const char* filename, EFormat format, int nofThreads = 0, size_t ringSize = 32);
+   ~TDecompressor();
+
+   static bool IsSupported(EFormat format);
+   static bool FormatFromName(const std::string& filename, EFormat& format);
+
+   size_t Read(char* buffer, size_t length); ///< blocks until length bytes or the end of the data have been reached
+
+   bool        Good() const;         ///< false once an error occured, Read() only returns the data before the error
+   std::string GetLastError() const; ///< the first error that occured
+   size_t      GetCompressedBytesRead() const { return fCompressedBytesRead; }
+
+private:
+   enum class EChunkState { kEmpty, kCompressed, kDecompressing, kReady };
+
+   struct TChunk {
+      EChunkState       fState{EChunkState::kEmpty};
+      std::vector<char> fCompressed;
+      std::vector<char> fData;
+      size_t            fReadPosition{0};
+   };
+
+   void ReaderLoop();
+   void WorkerLoop();
+
+   // functions used by the reader thread
+   bool   ReadInput(std::vector<char>& buffer, size_t bytes);
+   bool   ReserveChunk(TChunk*& chunk);
+   void   PublishChunk(EChunkState state);
+   bool   SplitGzip(std::vector<char>& buffer);
+   bool   SplitZstd(std::vector<char>& buffer);
+   bool   StreamGzip(std::vector<char>& buffer);
+   bool   StreamBzip2(std::vector<char>& buffer);
+   bool   StreamZstd(std::vector<char>& buffer);
+   size_t GzipMemberSize(std::vector<char>& buffer);
+
+   // function used by the worker threads
+   bool Decompress(const std::vector<char>& input, std::vector<char>& output, std::string& error);
+
+   void SetError(const std::string& error);
+
+   std::FILE* fFile;
+   EFormat    fFormat;
+
+   std::vector<TChunk> fRing;
+   size_t              fWriteIndex; ///< next chunk to be filled by the reader
+   size_t              fReadIndex;  ///< next chunk to be handed out by Read()
+   bool                fEndOfInput; ///< reader thread is done
+
+   mutable std::mutex      fMutex;
+   std::condition_variable fChunkFree;       ///< signalled when Read() releases a chunk
+   std::condition_variable fChunkCompressed; ///< signalled when a compressed chunk is available to the workers
+   std::condition_variable fChunkReady;      ///< signalled when a chunk has been decompressed
+
+   std::atomic_bool   fStop;
+   std::atomic_size_t fCompressedBytesRead;
+   std::string        fError;
+
+   std::thread              fReader;
+   std::vector<std::thread> fWorkers;
+
+   static const size_t fStreamChunkSize; ///< size of decompressed chunks when decompressing a single stream
+   static const size_t fMaxBlockSize;    ///< maximum size of compressed blocks we buffer before falling back to streaming
+};
+
+#endif
+
+/*! @} */
+#endif // TDECOMPRESSOR_H
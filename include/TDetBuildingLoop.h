@@ -11,12 +11,22 @@
 ///
 /// This loop builds detectors from vectors of fragments.
 ///
+/// With more than one detector building thread (--det-building-threads),
+/// the events are built by a pool of worker threads. Each event gets a
+/// sequence number when it is taken from the input queue, and the built
+/// events are pushed to the output queues in that order by this loop, so
+/// the analysis tree is still written in time order.
+///
+/// The events (and their detectors) are taken from a TUnpackedEventPool
+/// per building thread and return to it once all loops are done with
+/// them.
+///
 ////////////////////////////////////////////////////////////////////////////////
 
 #ifndef __CINT__
-#include <condition_variable>
-#include <mutex>
-#include <queue>
+#include <memory>
+#include <vector>
+#include "TOrderedWorkers.h"
 #endif
 
 #include "StoppableThread.h"
@@ -26,6 +36,7 @@
 class TNSCLEvent;
 class TGEBEvent;
 class TUnpackedEvent;
+class TUnpackedEventPool;
 
 class TDetector;
 
@@ -47,6 +58,7 @@ public:
 
    bool Iteration() override;
    void ClearQueue() override;
+   void OnEnd() override;
 
    size_t GetItemsPushed() override
    {
@@ -65,10 +77,22 @@ private:
    TDetBuildingLoop& operator=(const TDetBuildingLoop& other);
 
 #ifndef __CINT__
+   std::shared_ptr<TUnpackedEvent> BuildEvent(const std::vector<std::shared_ptr<const TFragment>>& frags,
+                                              const std::shared_ptr<TUnpackedEventPool>&           pool);
+   void PushEvent(const std::shared_ptr<TUnpackedEvent>& event);
+
+   void StartWorkers();
+   bool ReleaseBuiltEvents();
+
    std::shared_ptr<ThreadsafeQueue<std::vector<std::shared_ptr<const TFragment>>>> fInputQueue;
    std::vector<std::shared_ptr<ThreadsafeQueue<std::shared_ptr<TUnpackedEvent>>>>  fOutputQueues;
+   std::shared_ptr<TUnpackedEventPool>                                             fEventPool; ///< events built on this loop's thread, each worker has its own pool
+
+   TOrderedWorkers<std::vector<std::shared_ptr<const TFragment>>, std::shared_ptr<TUnpackedEvent>> fWorkers; ///< build the events, each with its own pool
 #endif
 
+   int fNofWorkers; ///< number of detector building threads (1 = build on this loop's thread)
+
    ClassDefOverride(TDetBuildingLoop, 0);
 };
 
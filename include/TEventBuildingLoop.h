@@ -12,12 +12,50 @@
 /// This loop builds events (vectors of fragments) based on timestamps and a
 /// build windows.
 ///
+/// By default all fragments are sorted in a multiset holding up to the sort
+/// depth of fragments. When building on timestamps, the loop can instead
+/// merge the fragments channel by channel (SetMergeByChannel): as each
+/// channel sends its fragments in time order, it's enough to keep a queue
+/// per address and a heap of the first fragment of each queue. The earliest
+/// fragment is released as soon as no channel that is waiting for data could
+/// still send an earlier one. Channels that haven't sent anything within the
+/// last sort depth of fragments are not waited for, and the sort depth is
+/// still the limit on the number of fragments held.
+///
+/// The loop keeps track of how late fragments arrive, i.e. how many fragments
+/// and how many time stamps (or trigger ids) earlier they should have arrived.
+/// With SetAdaptiveSortDepth the sort depth is raised to twice the largest
+/// lateness seen (up to the maximum sort depth), and lowered again towards
+/// the sort depth it started with once the fragments arrive in order again.
+/// The final and largest sort depth are reported in TSortingDiagnostics.
+///
+/// With more than one event building thread (SetEventBuildingThreads), events
+/// built on timestamps are built in slices of time (SetSliceWidth) on a pool
+/// of worker threads. Each slice also gets the fragments from one build
+/// window before its start and from an overlap after its end. The boundary
+/// between two slices is the first fragment after the nominal boundary that
+/// follows a gap larger than the build window. Such a fragment always starts
+/// a new event, so both slices find the same boundary, and no event is split
+/// or built twice. Only if the overlap has no such gap is the boundary placed
+/// at the nominal one, which is counted as a split. The events of each slice
+/// are passed on in order. Fragments that arrive after their slice has been
+/// handed to a worker (i.e. later than the sort depth) are treated as out of
+/// order: they are sent to the out-of-order queue if SeparateOutOfOrder is
+/// set, otherwise they are built as an event of their own, passed on after
+/// the events of the slices handed to the workers so far.
+///
 ////////////////////////////////////////////////////////////////////////////////
 
 #ifndef __CINT__
 #include <memory>
 #include <functional>
 #include <set>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <map>
+#include <atomic>
+#include <thread>
 #endif
 
 #include "StoppableThread.h"
@@ -43,6 +81,7 @@ public:
    bool Iteration() override;
 
    void ClearQueue() override;
+   void OnEnd() override;
 
    size_t GetItemsPushed() override { return fOutputQueue->ItemsPushed(); }
    size_t GetItemsPopped() override { return fOutputQueue->ItemsPopped(); }
@@ -52,9 +91,26 @@ public:
    void SetBuildWindow(long clock_ticks) { fBuildWindow = clock_ticks; }
    unsigned long            GetBuildWindow() const { return fBuildWindow; }
 
-   void SetSortDepth(int num_events) { fSortingDepth = num_events; }
+   void SetSortDepth(int num_events)
+   {
+      fSortingDepth    = num_events;
+      fMinSortingDepth = num_events;
+   }
    unsigned int          GetSortDepth() const { return fSortingDepth; }
 
+   void SetMergeByChannel(bool val = true) { fMergeByChannel = val; }
+   bool GetMergeByChannel() const { return fMergeByChannel; }
+
+   void SetAdaptiveSortDepth(bool val = true) { fAdaptiveSortDepth = val; }
+   bool GetAdaptiveSortDepth() const { return fAdaptiveSortDepth; }
+   void SetMaxSortDepth(unsigned int num_events) { fMaxSortingDepth = num_events; }
+   unsigned int GetMaxSortDepth() const { return fMaxSortingDepth; }
+
+   void SetEventBuildingThreads(int threads);
+   int  GetEventBuildingThreads() const { return fNofWorkers; }
+   void SetSliceWidth(long clock_ticks) { fSliceWidth = clock_ticks; }
+   long GetSliceWidth() const { return fSliceWidth; }
+
    std::string EndStatus() override;
 
 private:
@@ -64,8 +120,27 @@ private:
 
 #ifndef __CINT__
    bool CheckBuildCondition(const std::shared_ptr<const TFragment>&);
-   bool CheckTimestampCondition(const std::shared_ptr<const TFragment>&);
+   bool CheckTimestampCondition(const std::shared_ptr<const TFragment>&, long timestamp);
    bool CheckTriggerIdCondition(const std::shared_ptr<const TFragment>&);
+   void AddToNextEvent(const std::shared_ptr<const TFragment>&, long timestamp);
+
+   bool IterationMerge();
+   void AddToMerge(const std::shared_ptr<const TFragment>&);
+   bool ReleaseFromMerge(bool force);
+
+   void UpdateSortDepth(const std::shared_ptr<const TFragment>&);
+   void ReportSortDepth();
+
+   struct TEventSlice;
+   bool   IterationSliced();
+   void   AddToSlices(const std::shared_ptr<const TFragment>&);
+   void   DispatchSlices(bool all);
+   void   ReleaseSlices();
+   void   StartWorkers();
+   void   StopWorkers();
+   void   WorkerLoop();
+   void   BuildSlice(TEventSlice& slice) const;
+   size_t SliceBoundary(const TEventSlice& slice, long boundary, bool& split) const;
 
    std::shared_ptr<ThreadsafeQueue<std::shared_ptr<const TFragment>>>              fInputQueue;
    std::shared_ptr<ThreadsafeQueue<std::vector<std::shared_ptr<const TFragment>>>> fOutputQueue;
@@ -76,9 +151,68 @@ private:
    unsigned int fSortingDepth;
    long         fBuildWindow;
    bool         fPreviousSortingDepthError;
+   bool         fMergeByChannel; ///< merge the fragments of all channels instead of sorting them
+
+   bool         fAdaptiveSortDepth;   ///< adapt the sort depth to the lateness of the fragments
+   unsigned int fMinSortingDepth;     ///< sort depth we started with, the adaptive depth doesn't go below this
+   unsigned int fMaxSortingDepth;     ///< the adaptive depth doesn't go above this
+   unsigned int fLargestSortingDepth; ///< largest sort depth used so far
+   long         fLatestKey;           ///< latest time stamp (or trigger id) seen so far
+   long         fMaxLateEntries;      ///< largest number of fragments a fragment arrived late
+   long         fMaxLateTime;         ///< largest time stamp (or trigger id) difference of a late fragment
+   long         fWindowLateEntries;   ///< largest number of fragments a fragment arrived late since fWindowStart
+   size_t       fWindowStart;         ///< fragment number at which we last checked if the sort depth can be lowered
+
+   int    fNofWorkers;    ///< number of event building threads (1 = build on this loop's thread)
+   long   fSliceWidth;    ///< width of the time slices built by the workers
+   long   fSliceOverlap;  ///< how far past its end a slice gets fragments to find its boundary
+   long   fNextSlice;     ///< first slice that hasn't been handed to the workers yet (LONG_MIN before the first one)
+   size_t fSplitSlices;   ///< number of slice boundaries without a gap in the overlap
+   size_t fLateFragments; ///< number of fragments that arrived after their slice was handed to the workers
+
+   long fNextEventStart; ///< time stamp of the first fragment in fNextEvent
+   long fNextEventLast;  ///< time stamp of the last fragment in fNextEvent
 
 #ifndef __CINT__
    std::vector<std::shared_ptr<const TFragment>> fNextEvent;
+   std::deque<std::pair<size_t, long>> fLatestKeys; ///< fragment number and latest key at that point, sampled
+
+   /// a fragment waiting in the queue of its channel, with its time stamp so we only get it once
+   struct TMergeEntry {
+      long                             fTimeStamp;
+      std::shared_ptr<const TFragment> fFragment;
+   };
+   struct TMergeChannel {
+      std::deque<TMergeEntry> fQueue;
+      long                    fLastTimeStamp{0}; ///< latest time stamp this channel sent
+      size_t                  fLastEntry{0};     ///< number of fragments merged when this channel last sent one
+   };
+   /// entry of the heaps, either the first fragment of a channel or the last time stamp of an empty channel
+   struct TMergeHead {
+      long   fTimeStamp;
+      UInt_t fAddress;
+      size_t fEntry;
+      bool   operator>(const TMergeHead& rhs) const { return fTimeStamp > rhs.fTimeStamp; }
+   };
+   std::unordered_map<UInt_t, TMergeChannel> fChannels;
+   std::priority_queue<TMergeHead, std::vector<TMergeHead>, std::greater<TMergeHead>> fHeads; ///< first fragment of each channel
+   std::priority_queue<TMergeHead, std::vector<TMergeHead>, std::greater<TMergeHead>> fIdle;  ///< channels without fragments
+   size_t fMergeSize;    ///< number of fragments waiting in the channel queues
+   size_t fMergeCounter; ///< number of fragments merged so far
+
+   /// fragments of one time slice and the events built from them
+   struct TEventSlice {
+      long                                                       fIndex;
+      size_t                                                     fCloseAt{0}; ///< fragment number at which to build it
+      std::vector<std::shared_ptr<const TFragment>>              fFragments;
+      std::vector<std::vector<std::shared_ptr<const TFragment>>> fEvents;
+      bool                                                       fSplit{false};
+      std::atomic_bool                                           fDone{false};
+   };
+   std::map<long, std::shared_ptr<TEventSlice>>                   fOpenSlices;     ///< slices still collecting fragments
+   std::deque<std::shared_ptr<TEventSlice>>                       fBuildingSlices; ///< slices handed to the workers, in order
+   std::shared_ptr<ThreadsafeQueue<std::shared_ptr<TEventSlice>>> fSliceQueue;
+   std::vector<std::thread>                                       fWorkers;
 
    std::multiset<std::shared_ptr<const TFragment>,
                  std::function<bool(std::shared_ptr<const TFragment>, std::shared_ptr<const TFragment>)>>
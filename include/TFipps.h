@@ -89,7 +89,7 @@ private:
 
    // static bool fSetBGOHits;                //!<!  Flag that determines if BGOHits are being measured
 
-   mutable TTransientBits<UChar_t> fFippsBits; // Transient member flags
+   mutable TTransientBits<UChar_t> fFippsBits; //!<! Transient member flags
 
    mutable std::vector<TFippsHit> fAddbackHits;  //!<! Used to create addback hits on the fly
    mutable std::vector<UShort_t>  fAddbackFrags; //!<! Number of crystals involved in creating in the addback hit
@@ -127,7 +127,7 @@ public:
    void Print(Option_t* opt = "") const override; //!<!
 
    /// \cond CLASSIMP
-   ClassDefOverride(TFipps, 5) // Fipps Physics structure
+   ClassDefOverride(TFipps, 6) // Fipps Physics structure
    /// \endcond
 };
 /*! @} */
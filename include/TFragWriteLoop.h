@@ -11,6 +11,10 @@
 ///
 /// This loop writes fragments to a root-file.
 ///
+/// The branches are pointed at the fragments from the input queue
+/// instead of copying them. With --write-threads ROOT's implicit
+/// multi-threading compresses the baskets of the branches in parallel.
+///
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <map>
@@ -70,6 +74,11 @@ private:
    TFragment*    fEventAddress;
    TBadFragment* fBadEventAddress;
    TEpicsFrag*   fScalerAddress;
+   TFragment*    fDefaultEvent;    ///< owned by the branch, restored after each fill
+   TBadFragment* fDefaultBadEvent; ///< owned by the branch, restored after each fill
+
+   std::vector<UChar_t>  fWaveform;        ///< packed waveform of the fragment being written
+   std::vector<UChar_t>* fWaveformAddress; ///< address of the waveform branch, nullptr if there is none
 
 #ifndef __CINT__
    std::shared_ptr<ThreadsafeQueue<std::shared_ptr<const TFragment>>> fInputQueue;
@@ -24,6 +24,17 @@
 /// This Class contains all of the information in an event
 /// fragment
 ///
+/// The trigger ids are stored in a small array inside the fragment,
+/// only fragments with more than two trigger ids use the extra vector.
+/// Version 6 and older stored all of them in a vector (fTriggerId),
+/// these are converted when reading (see LinkDef.h).
+///
+/// The FragmentTree written by TFragWriteLoop stores the packed
+/// waveforms in their own branch ("Waveform", a std::vector<UChar_t>
+/// per fragment, see GetPackedWaveform/SetPackedWaveform), so they
+/// are only read if that branch is. Older files have the waveform
+/// within the TFragment branch.
+///
 /////////////////////////////////////////////////////////////////
 
 class TFragment : public TGRSIDetectorHit {
@@ -31,6 +42,7 @@ public:
    TFragment();
    TFragment(const TFragment&);
    ~TFragment() override;
+   TFragment& operator=(const TFragment&);
 
    //////////////////// basic setter functions ////////////////////
 
@@ -52,9 +64,27 @@ public:
                <<std::endl;
    }
    void SetNumberOfPileups(UShort_t value) { fNumberOfPileups = value; }
+
+   /// if set, TFragments are written without their waveform, which the writer puts into a separate branch
+   static void SetWaveformBranch(bool value) { fWaveformBranch = value; }
+   bool        WaveformInRecord() const override { return !fWaveformBranch; }
    void SetNumberOfWords(UShort_t value) { fNumberOfWords = value; }
    void SetTriggerBitPattern(Int_t value) { fTriggerBitPattern = value; }
-   void SetTriggerId(Long_t value) { fTriggerId.push_back(value); }
+   void SetTriggerId(Long_t value)
+   {
+      // adds another trigger id
+      if(fNumberOfTriggerIds < kInlineTriggerIds) {
+         fTriggerIds[fNumberOfTriggerIds] = value;
+      } else {
+         fExtraTriggerIds.push_back(value);
+      }
+      ++fNumberOfTriggerIds;
+   }
+   void ClearTriggerIds()
+   {
+      fNumberOfTriggerIds = 0;
+      fExtraTriggerIds.clear();
+   }
    void SetZc(Int_t value) { fZc = value; }
 
    //////////////////// basic getter functions ////////////////////
@@ -78,11 +108,15 @@ public:
    Int_t    GetTriggerBitPattern() const { return fTriggerBitPattern; }
    Long_t GetTriggerId(size_t iter = 0) const
    {
-      if(iter < fTriggerId.size()) {
-         return fTriggerId[iter];
+      if(iter >= fNumberOfTriggerIds) {
+         return 0;
       }
-      return 0;
+      if(iter < kInlineTriggerIds) {
+         return fTriggerIds[iter];
+      }
+      return fExtraTriggerIds[iter - kInlineTriggerIds];
    }
+   size_t GetNumberOfTriggerIds() const { return fNumberOfTriggerIds; }
    Int_t GetZc() const { return fZc; }
 
    //////////////////// advanced getter functions ////////////////////
@@ -110,7 +144,10 @@ public:
    Int_t GetSharcMesyBoard() const;
 
 private:
+   enum { kInlineTriggerIds = 2 }; ///< size of fTriggerIds
+
    //////////////////// data members, sorted by size (as far as possible) to reduce padding ////////////////////
+   Long_t fTriggerIds[2];       ///< The first (usually only) MasterFilterIDs in Griffin DAQ
    time_t fMidasTimeStamp;      ///< Timestamp of the MIDAS event
    Int_t  fMidasId;             ///< MIDAS ID
    Int_t  fFragmentId;          ///< Channel Trigger ID ??? not needed anymore ???
@@ -125,8 +162,9 @@ private:
    UShort_t fModuleType;      ///< Data Type (GRIF-16, 4G, etc.)
    UShort_t fDetectorType;    ///< Detector Type (PACES,HPGe, etc.)
    UShort_t fNumberOfPileups; ///< Number of piled up hits 1-3
+   UShort_t fNumberOfTriggerIds; ///< Number of MasterFilterIDs (in fTriggerIds and fExtraTriggerIds)
 
-   std::vector<Long_t> fTriggerId; ///<  MasterFilterID in Griffin DAQ
+   std::vector<Long_t> fExtraTriggerIds; ///< MasterFilterIDs that don't fit into fTriggerIds
 
    //////////////////// transient members ////////////////////
    TPPG* fPPG; //!<! Programmable pattern generator value
@@ -138,12 +176,13 @@ private:
    UShort_t fNumberOfWords; //!<! Number of non-waveform words in fragment, only used for check while parsing the fragment
 
    static Long64_t fNumberOfFragments;
+   static bool     fWaveformBranch; ///< the waveforms are written to a separate branch, see SetWaveformBranch
 
    // int NumberOfHits;  //!<! transient member to count the number of pile-up hits in the original fragment
    // int HitIndex;    //!<! transient member indicating which pile-up hit this is in the original fragment
 
    /// \cond CLASSIMP
-   ClassDefOverride(TFragment, 6); // Event Fragments
+   ClassDefOverride(TFragment, 7); // Event Fragments
    /// \endcond
 };
 /*! @} */
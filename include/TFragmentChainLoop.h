@@ -65,6 +65,7 @@ private:
    TChain* fInputChain;
 #ifndef __CINT__
    TFragment*                                                                      fFragment;
+   std::vector<UChar_t>*                                                           fWaveform; ///< nullptr unless the waveform branch is read
    std::vector<std::shared_ptr<ThreadsafeQueue<std::shared_ptr<const TFragment>>>> fOutputQueues;
 #endif
 
@@ -40,6 +40,7 @@ public:
 private:
    static bool fDebug;
 #ifndef __CINT__
+   static Double_t Dither(const std::shared_ptr<TFragment>& frag, Int_t charge, size_t index);
    void Solve(std::vector<std::shared_ptr<TFragment>>, std::vector<Float_t>, std::vector<Long_t>, int situation = -1);
    void DropFragments(std::pair<std::multimap<UInt_t, std::tuple<std::shared_ptr<TFragment>, std::vector<Int_t>,
                                                                  std::vector<Short_t>>>::iterator,
@@ -0,0 +1,65 @@
+#ifndef TFRAGMENTPOOL_H
+#define TFRAGMENTPOOL_H
+
+/** \addtogroup Sorting
+ *  @{
+ */
+
+/////////////////////////////////////////////////////////////////
+///
+/// \class TFragmentPool
+///
+/// Recycles the TFragments created by a TDataParser.
+///
+/// Get() and Copy() hand out shared pointers to fragments from a
+/// free list. Once the last loop holding a fragment (fragment
+/// writing, event building, ...) releases it, the fragment is
+/// cleared and put back on the free list instead of being deleted,
+/// so the trigger id and waveform vectors keep their capacity and
+/// the parser doesn't allocate new fragments once the pipeline is
+/// filled.
+///
+/// Each parser has its own pool. Fragments can be returned from any
+/// thread, they are collected in a separate list that is swapped
+/// into the free list of the parser in one go once that runs empty.
+///
+/////////////////////////////////////////////////////////////////
+
+#ifndef __CINT__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TFragment.h"
+
+class TFragmentPool : public std::enable_shared_from_this<TFragmentPool> {
+public:
+   static std::shared_ptr<TFragmentPool> Create(size_t maxSize = 100000);
+   ~TFragmentPool();
+
+   std::shared_ptr<TFragment> Get();                       ///< get an empty fragment
+   std::shared_ptr<TFragment> Copy(const TFragment& frag); ///< get a copy of frag
+
+   size_t Allocated() const { return fAllocated; } ///< number of fragments allocated by this pool
+   size_t Recycled() const { return fRecycled; }   ///< number of fragments handed out again after being returned
+
+private:
+   explicit TFragmentPool(size_t maxSize);
+
+   TFragment* Take();
+   void       Return(TFragment* frag);
+
+   std::vector<TFragment*> fFree;        ///< fragments ready to be handed out (only used by the owning parser)
+   std::vector<TFragment*> fReturned;    ///< fragments returned by the other loops
+   std::mutex              fReturnMutex; ///< protects fReturned
+   size_t                  fMaxSize;     ///< maximum number of fragments kept for re-use
+
+   std::atomic_size_t fAllocated{0};
+   std::atomic_size_t fRecycled{0};
+};
+
+#endif
+/*! @} */
+#endif
@@ -42,6 +42,9 @@ class TGRSIDetector;
 ///
 /// 5. The waveform.       Since we are dealing with digital daqs, a waveform is a fairly common thing to have.  It
 ///                        may not always be present, put it is echoed enough that the storage for it belongs here.
+///                        The streamer writes it as the differences between samples, bit-packed in small blocks.
+///                        When reading, only the packed bytes are kept, they are decoded the first time
+///                        GetWaveform() is called, so hits whose waveforms aren't looked at never decode them.
 ///
 /////////////////////////////////////////////////////////////////
 
@@ -92,7 +95,7 @@ public:
    void Clear(Option_t* opt = "") override;          //!<!
    virtual void ClearTransients() const { fBitflags = 0; }
    void Print(Option_t* opt = "") const override;                                 //!<!
-   virtual bool HasWave() const { return (fWaveform.size() > 0) ? true : false; } //!<!
+   virtual bool HasWave() const { return !fWaveform.empty() || !fPackedWaveform.empty(); } //!<!
 
    static bool CompareEnergy(TGRSIDetectorHit* lhs, TGRSIDetectorHit* rhs);
    // We need a common function for all detectors in here
@@ -101,10 +104,29 @@ public:
    void SetAddress(const UInt_t& temp_address) { fAddress = temp_address; }                 //!<!
    void SetKValue(const Short_t& temp_kval) { fKValue = temp_kval; }                        //!<!
    void SetCharge(const Float_t& temp_charge) { fCharge = temp_charge; }                    //!<!
-   void SetCharge(const Int_t& temp_charge) { fCharge = temp_charge + gRandom->Uniform(); } //!<!
+   void SetCharge(const Int_t& temp_charge);                                                //!<!
    virtual void SetCfd(const Int_t& x) { fCfd = x; }                                        //!<!
-   void SetWaveform(const std::vector<Short_t>& x) { fWaveform = x; }                       //!<!
-   void AddWaveformSample(const Short_t& x) { fWaveform.push_back(x); }                     //!<!
+   void SetWaveform(const std::vector<Short_t>& x)                                          //!<!
+   {
+      fWaveform = x;
+      fPackedWaveform.clear();
+   }
+   void SetPackedWaveform(const std::vector<UChar_t>& packed)                               //!<!
+   {
+      fWaveform.clear();
+      fPackedWaveform = packed;
+   }
+   void GetPackedWaveform(std::vector<UChar_t>& packed) const; //!<!
+   /// whether the Streamer writes the waveform within the record of the hit (see TFragment::SetWaveformBranch)
+   virtual bool WaveformInRecord() const { return true; } //!<!
+   void AddWaveformSample(const Short_t& x)                                                 //!<!
+   {
+      // a packed waveform that hasn't been decoded yet is what we're adding to
+      if(!fPackedWaveform.empty()) {
+         UnpackWaveform();
+      }
+      fWaveform.push_back(x);
+   }
    virtual void SetTimeStamp(const Long64_t& x) { fTimeStamp = x; }                         //!<!
    virtual void AppendTimeStamp(const Long64_t& x) { fTimeStamp += x; }                     //!<!
 
@@ -134,11 +156,19 @@ public:
    virtual Float_t             GetCharge() const;                         //!<!
    virtual Float_t             Charge() const { return fCharge; }         //!<!
    virtual Short_t             GetKValue() const { return fKValue; }      //!<!
-   const std::vector<Short_t>* GetWaveform() const { return &fWaveform; } //!<!
+   const std::vector<Short_t>* GetWaveform() const                        //!<!
+   {
+      if(!fPackedWaveform.empty()) {
+         UnpackWaveform();
+      }
+      return &fWaveform;
+   }
    TChannel*                   GetChannel() const
    {
-      if(!IsChannelSet()) {
-         fChannel = TChannel::GetChannel(fAddress);
+      // the cached channel is only valid until the channels are updated
+      if(!IsChannelSet() || fChannelGeneration != TChannel::GetGeneration()) {
+         fChannel           = TChannel::GetChannel(fAddress);
+         fChannelGeneration = TChannel::GetGeneration();
          SetHitBit(kIsChannelSet, true);
       }
       return fChannel;
@@ -181,6 +211,8 @@ protected:
    Bool_t IsChannelSet() const { return (fBitflags.TestBit(kIsChannelSet)); }
    Bool_t IsTimeSet() const { return (fBitflags.TestBit(kIsTimeSet)); }
    Bool_t IsPPGSet() const { return (fBitflags.TestBit(kIsPPGSet)); }
+   Double_t Dither(UInt_t stream, Int_t value) const; ///< random number in [0,1) keyed on this hit, see TGRSIRandom
+   void     UnpackWaveform() const;                   ///< decodes fPackedWaveform into fWaveform
 
 public:
    void SetHitBit(enum EBitFlag, Bool_t set = true) const; // const here is dirty
@@ -192,7 +224,7 @@ protected:
    Short_t              fKValue{0};    ///< integration value.
    Int_t                fCfd{0};       ///< CFD time of the Hit
    Long64_t             fTimeStamp{0}; ///< Timestamp given to hit
-   std::vector<Short_t> fWaveform;     ///<
+   mutable std::vector<Short_t> fWaveform; //!<! written packed by the Streamer
 
 private:
    mutable Double_t fTime{0.}; //!<! Calibrated Time of the hit
@@ -201,17 +233,20 @@ private:
 
    mutable Long64_t  fCycleTimeStamp{0}; //!<!
    mutable TChannel* fChannel{nullptr};        //!<!
+   mutable UInt_t    fChannelGeneration{0};    //!<! TChannel::GetGeneration() when fChannel was set
+
+   mutable std::vector<UChar_t> fPackedWaveform; //!<! waveform as read from file, not decoded yet
 
 protected:
    static TPPG* fPPG;
 
 private:
    // flags
-   mutable TTransientBits<UChar_t> fBitflags;
+   mutable TTransientBits<UChar_t> fBitflags;      //!<! transient, so writing a hit doesn't change it
    static TVector3                 fBeamDirection; //!
 
    /// \cond CLASSIMP
-   ClassDefOverride(TGRSIDetectorHit, 10) // Stores the information for a detector hit
+   ClassDefOverride(TGRSIDetectorHit, 12) // Stores the information for a detector hit
    /// \endcond
 };
 /*! @} */
@@ -107,8 +107,23 @@ public:
 	size_t FragmentWriteQueueSize() const { return fFragmentWriteQueueSize; }
 	size_t AnalysisWriteQueueSize() const { return fAnalysisWriteQueueSize; }
 
+	int DecompressionThreads() const { return fDecompressionThreads; }
+	int UnpackingThreads() const { return fUnpackingThreads; }
+
+	bool WriteMidasIndex() const { return fWriteMidasIndex; }
+	int  MidasIndexInterval() const { return fMidasIndexInterval; }
+
 	bool TimeSortInput() const { return fTimeSortInput; }
 	int  SortDepth() const { return fSortDepth; }
+	bool MergeByChannel() const { return fMergeByChannel; }
+	bool AdaptiveSortDepth() const { return fAdaptiveSortDepth; }
+	int  MaxSortDepth() const { return fMaxSortDepth; }
+	int  EventBuildingThreads() const { return fEventBuildingThreads; }
+	long SliceWidth() const { return fSliceWidth; }
+	int  DetBuildingThreads() const { return fDetBuildingThreads; }
+	int  WriteThreads() const { return fWriteThreads; }
+	const std::vector<std::string>& AnalysisBranches() const { return fAnalysisBranches; }
+	bool ColumnTree() const { return fColumnTree; }
 
 	bool ShouldExitImmediately() const { return fShouldExit; }
 
@@ -195,8 +210,25 @@ private:
 	size_t fFragmentWriteQueueSize; ///< Size of the Fragment write Q
 	size_t fAnalysisWriteQueueSize; ///< Size of the analysis write Q
 
+	int fDecompressionThreads; ///< Number of threads used to decompress compressed input files (0 = all cores)
+	int fUnpackingThreads;     ///< Number of threads used to parse midas events (0 = all cores)
+
+	bool fWriteMidasIndex;    ///< Flag to write a .mid.idx index file when reading a midas file (--write-midas-index)
+	int  fMidasIndexInterval; ///< Number of events between entries of the midas index
+
 	bool fTimeSortInput; ///< Flag to sort on time or triggers
-	int  fSortDepth;     ///< Size of Q that stores fragments to be built into events
+	int  fSortDepth;         ///< Size of Q that stores fragments to be built into events
+	bool fMergeByChannel;    ///< Flag to build events by merging the time ordered fragments of each channel
+	bool fAdaptiveSortDepth; ///< Flag to adapt the sort depth to the observed out-of-order distance
+	int  fMaxSortDepth;      ///< Upper limit of the adaptive sort depth
+
+	int  fEventBuildingThreads; ///< Number of threads used to build events in time slices (0 = all cores)
+	long fSliceWidth;           ///< Width of the time slices built by each event building thread
+	int  fDetBuildingThreads;   ///< Number of threads used to build detectors from events (0 = all cores)
+	int  fWriteThreads;         ///< Number of threads used to compress the output trees (1 = no extra threads)
+
+	std::vector<std::string> fAnalysisBranches; ///< Detector classes to create analysis tree branches for before the first event
+	bool fColumnTree; ///< Flag to also write the hits as flat columns (see TAnalysisColumns)
 
 	static TAnalysisOptions* fAnalysisOptions; ///< contains all options for analysis
 
@@ -216,7 +248,7 @@ private:
 	bool fSelectorOnly; ///< Flag to turn PROOF off in grsiproof
 
 	/// \cond CLASSIMP
-	ClassDefOverride(TGRSIOptions, 3); ///< Class for storing options in GRSISort
+	ClassDefOverride(TGRSIOptions, 13); ///< Class for storing options in GRSISort
 	/// \endcond
 };
 /*! @} */
@@ -0,0 +1,101 @@
+#ifndef TGRSIRANDOM_H
+#define TGRSIRANDOM_H
+
+/** \addtogroup Sorting
+ *  @{
+ */
+
+/////////////////////////////////////////////////////////////////
+///
+/// \class TGRSIRandom
+///
+/// Counter based random numbers (Philox4x32-10) used to dither
+/// integer charges, CFDs, and time stamps.
+///
+/// Instead of drawing the next number from a shared generator like
+/// gRandom, each random number is a function of the hit it is used
+/// for: the address, the time stamp, the value being dithered, and
+/// a stream number that separates the different uses. This needs no
+/// locking, and a hit gets the same dithering no matter which thread
+/// builds it or in which order, so the output doesn't depend on the
+/// number of unpacking or detector building threads.
+///
+/// TChannel::CalibrateENG, CalibrateCFD, and CalibrateLED of integer
+/// values take the time stamp to key the random number on as well.
+/// Only their older overloads without a time stamp use
+/// Uniform(address), which counts up a separate stream for each
+/// thread. This is thread safe but not reproducible between runs
+/// with different numbers of threads.
+///
+/////////////////////////////////////////////////////////////////
+
+#ifndef __CINT__
+
+#include <atomic>
+#include <cstdint>
+
+class TGRSIRandom {
+public:
+   /// stream numbers for the different uses, the pile-up charges add the index of the charge
+   enum EStream : uint32_t { kCharge = 0x100, kCfd = 0x200, kTime = 0x300, kLed = 0x400, kPileUpCharge = 0x1000 };
+
+   /// returns a uniform random number in [0,1) for this address, time stamp, value, and stream
+   static double Uniform(uint32_t address, uint64_t timestamp, uint32_t value, uint32_t stream)
+   {
+      uint32_t counter[4] = {static_cast<uint32_t>(timestamp), static_cast<uint32_t>(timestamp >> 32), value, stream};
+      uint32_t key[2]     = {address, Seed()};
+      Philox(counter, key);
+      return ToDouble(counter[0], counter[1]);
+   }
+
+   /// returns a uniform random number in [0,1) from the stream of the calling thread
+   static double Uniform(uint32_t address = 0)
+   {
+      static std::atomic<uint32_t> threads{0};
+      thread_local uint32_t        thread = threads++;
+      thread_local uint64_t        count  = 0;
+      uint64_t                     n      = count++;
+      uint32_t counter[4] = {static_cast<uint32_t>(n), static_cast<uint32_t>(n >> 32), address, thread};
+      uint32_t key[2]     = {0x5eed5eed, Seed()};
+      Philox(counter, key);
+      return ToDouble(counter[0], counter[1]);
+   }
+
+   /// changes the seed for all random numbers, should only be called before sorting starts
+   static void SetSeed(uint32_t seed) { Seed() = seed; }
+
+   /// the Philox4x32 bijection with 10 rounds, counter is replaced by the random numbers
+   static void Philox(uint32_t* counter, uint32_t* key)
+   {
+      for(int round = 0; round < 10; ++round) {
+         uint64_t product0 = static_cast<uint64_t>(0xD2511F53) * counter[0];
+         uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57) * counter[2];
+         uint32_t result[4] = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                               static_cast<uint32_t>(product1),
+                               static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                               static_cast<uint32_t>(product0)};
+         for(int i = 0; i < 4; ++i) {
+            counter[i] = result[i];
+         }
+         key[0] += 0x9E3779B9;
+         key[1] += 0xBB67AE85;
+      }
+   }
+
+private:
+   static uint32_t& Seed()
+   {
+      static uint32_t seed = 0;
+      return seed;
+   }
+
+   /// uses the upper 53 bits of the two numbers, so the result is in [0,1)
+   static double ToDouble(uint32_t high, uint32_t low)
+   {
+      return static_cast<double>(((static_cast<uint64_t>(high) << 32) | low) >> 11) * (1. / 9007199254740992.);
+   }
+};
+
+#endif
+/*! @} */
+#endif
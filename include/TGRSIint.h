@@ -36,6 +36,7 @@
 #include "Globals.h"
 #include "TRawFile.h"
 #include "TMidasFile.h"
+#include "TMidasRing.h"
 #include "TLstFile.h"
 
 class TGRSIint : public TRint {
@@ -61,6 +62,7 @@ public:
    TFile* OpenRootFile(const std::string& filename, Option_t* opt = "read");
    TMidasFile* OpenMidasFile(const std::string& filename);
    TLstFile* OpenLstFile(const std::string& filename);
+   TMidasRing* OpenMidasRing(const std::string& name);
    void RunMacroFile(const std::string& filename);
 
    void Terminate(Int_t status = 0) override;
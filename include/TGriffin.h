@@ -103,7 +103,7 @@ private:
    // static bool fSetBGOWave;                //!<!  Flag for BGO Waveforms ON/OFF
 
    long                            fCycleStart; //!<!  The start of the cycle
-   mutable TTransientBits<UChar_t> fGriffinBits;  // Transient member flags
+   mutable TTransientBits<UChar_t> fGriffinBits;  //!<! Transient member flags
 
    mutable std::vector<TGriffinHit> fAddbackLowGainHits;  //!<! Used to create addback hits on the fly
    mutable std::vector<TGriffinHit> fAddbackHighGainHits; //!<! Used to create addback hits on the fly
@@ -188,7 +188,7 @@ public:
    void Print(Option_t* opt = "") const override; //!<!
 
    /// \cond CLASSIMP
-   ClassDefOverride(TGriffin, 5) // Griffin Physics structure
+   ClassDefOverride(TGriffin, 6) // Griffin Physics structure
    /// \endcond
 };
 /*! @} */
@@ -13,7 +13,9 @@
 ///
 /// \class TLstEvent
 ///
-/// C++ class representing one lst file.
+/// C++ class representing one chunk of a lst file. The data
+/// either is a copy held by the event, or points into a buffer
+/// (e.g. the memory mapped file) that is kept alive by an owner.
 ///
 /////////////////////////////////////////////////////////////////
 
@@ -38,14 +40,23 @@ public:
 
    char* GetData() override; ///< return pointer to the data buffer
 
-   void SetData(std::vector<char>& buffer); ///< set an externally allocated data buffer
+   void SetData(std::vector<char>& buffer); ///< copy the data from a buffer
+#ifndef __CINT__
+   void SetData(size_t size, char* data,
+                const std::shared_ptr<char>& owner); ///< set an external data buffer kept alive by owner
+#endif
 
    int SwapBytes(bool) override; ///< convert event data between little-endian (Linux-x86) and big endian (MacOS-PPC)
 
    int Process(TDataParser& parser) override;
 
 protected:
-   std::vector<char> fData; ///< event data buffer
+   std::vector<char> fData;         ///< event data buffer (if we own the data)
+   char*             fExternalData; //!<! external data buffer
+   size_t            fExternalSize; ///< size of the external data buffer
+#ifndef __CINT__
+   std::shared_ptr<char> fDataOwner; //!<! keeps the external data buffer alive
+#endif
 
    /// \cond CLASSIMP
    ClassDefOverride(TLstEvent, 0) // All of the data contained in a Midas Event
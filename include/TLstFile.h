@@ -12,9 +12,17 @@
 /// This Class is used to read and write LST files in the
 /// root framework.
 ///
+/// The file is memory mapped and handed out in chunks of
+/// fChunkSize bytes (a multiple of the 16 byte record size), each
+/// chunk becoming one TLstEvent that points into the mapping. This
+/// way the parsing can start with the first chunk, and the memory
+/// used doesn't depend on the size of the file, as the pages of a
+/// chunk are dropped once its event is gone.
+///
 /////////////////////////////////////////////////////////////////
 
 #include <string>
+#include <memory>
 
 #ifdef __APPLE__
 #include <_types/_uint32_t.h>
@@ -47,6 +55,11 @@ public:
 #endif
    std::string Status(bool long_file_description = true) override;
 
+   void Prefetch() override; ///< Ask the kernel to start reading the file
+
+   void   SetChunkSize(size_t size); ///< Set the number of bytes handed out per event (rounded to whole records)
+   size_t GetChunkSize() const { return fChunkSize; }
+
    int GetRunNumber() override;
    int GetSubRunNumber() override;
 
@@ -54,6 +67,14 @@ public:
    std::shared_ptr<TRawEvent> NewEvent() override { return std::make_shared<TLstEvent>(); }
 #endif
 
+private:
+#ifndef __CINT__
+   std::shared_ptr<char> fMappedFile; //!<! memory mapped input file, shared with the events pointing into it
+#endif
+   size_t fMappedSize{0};   ///< size of the memory mapped region
+   size_t fMappedOffset{0}; ///< current read position in the memory mapped region
+   size_t fChunkSize;       ///< number of bytes handed out per event
+
 protected:
    /// \cond CLASSIMP
    ClassDefOverride(TLstFile, 0) // Used to open and write Midas Files
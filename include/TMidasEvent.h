@@ -71,6 +71,10 @@ public:
 
    void AllocateData();                     ///< allocate data buffer using the existing event header
    void SetData(uint32_t size, char* data); ///< set an externally allocated data buffer
+#ifndef __CINT__
+   void SetData(uint32_t size, char* data,
+                const std::shared_ptr<char>& owner); ///< set an external data buffer kept alive by owner
+#endif
 
    int  SetBankList();      ///< create the list of data banks, return number of banks
    bool IsGoodSize() const; ///< validate the event length
@@ -90,6 +94,9 @@ protected:
    int                 fBanksN;        ///< number of banks in this event
    char*               fBankList;      ///< list of bank names in this event
    bool                fAllocatedByUs; ///< "true" if we own the data buffer
+#ifndef __CINT__
+   std::shared_ptr<char> fDataOwner; //!<! keeps an external (e.g. memory mapped) data buffer alive
+#endif
 
    /// \cond CLASSIMP
    ClassDefOverride(TMidasEvent, 0) // All of the data contained in a Midas Event
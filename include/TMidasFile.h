@@ -12,6 +12,21 @@
 /// This Class is used to read and write MIDAS files in the
 /// root framework. It reads and writes TMidasEvents.
 ///
+/// Uncompressed local files are memory mapped and the events
+/// reference their data inside the mapping (no copy). Pipes and
+/// compressed files fall back to buffered reads. Local gzip, bzip2,
+/// and zstd compressed files are decompressed on separate threads by
+/// a TDecompressor (if the library for the format is available).
+///
+/// Uncompressed local files can be positioned with Seek (by serial
+/// number), SeekTime, and SeekOffset. These use an index with the
+/// offset, serial number, time stamp, and event id of every N-th
+/// event. The index is read from a .mid.idx sidecar file if there is
+/// an up-to-date one, otherwise it is built by scanning the event
+/// headers. With --write-midas-index the sidecar is written once a
+/// file has been read completely, or it can be created with the
+/// MidasIndex utility. SetEndOffset limits reading to a byte range.
+///
 /////////////////////////////////////////////////////////////////
 
 #include <string>
@@ -26,6 +41,16 @@
 
 #include "TMidasEvent.h"
 
+class TDecompressor;
+
+/// One entry of the index of a midas file
+struct TMidasIndexEntry {
+   uint64_t fOffset;       ///< byte offset of the event in the file
+   uint32_t fSerialNumber; ///< serial number of the event
+   uint32_t fTimeStamp;    ///< midas time stamp of the event (unix time in seconds)
+   uint16_t fEventId;      ///< event id of the event
+};
+
 /// Reader for MIDAS .mid files
 
 class TMidasFile : public TRawFile {
@@ -62,6 +87,9 @@ public:
    const char* GetFilename() const override { return fFilename.c_str(); } ///< Get the name of this file
    int         GetLastErrno() const { return fLastErrno; }                ///< Get error value for the last file error
    const char* GetLastError() const { return fLastError.c_str(); }        ///< Get error text for the last file error
+   bool        IsMapped() const { return fMappedSize > 0; }               ///< Is the input file memory mapped?
+   void        Prefetch() override;                                       ///< Start reading the mapped file ahead
+   size_t      GetBytesRead() override;
 
 #ifndef __CINT__
    std::shared_ptr<TMidasEvent> GetFirstEvent() { return fFirstEvent; }
@@ -72,12 +100,36 @@ public:
 
    void SetMaxBufferSize(int maxsize);
 
+   // random access to uncompressed local files
+   bool   IsSeekable() const; ///< can we seek in this file?
+   size_t GetOffset() const;  ///< current byte offset in the file
+   bool   SeekOffset(size_t offset);
+   bool   Seek(uint32_t serialNumber, uint16_t eventId = 1); ///< go to the first event with at least this serial number
+   bool   SeekTime(uint32_t time); ///< go to the first event with at least this time stamp
+   void   SetEndOffset(size_t offset) { fEndOffset = offset; } ///< stop reading at this offset (0 = end of file)
+
+   bool        BuildIndex(int interval = 1000); ///< build the index by scanning the event headers
+   bool        ReadIndex();                     ///< read the index from the sidecar file
+   bool        WriteIndex();                    ///< write the index to the sidecar file
+   std::string IndexFilename() const { return fFilename + ".idx"; }
+#ifndef __CINT__
+   const std::vector<TMidasIndexEntry>& GetIndex() const { return fIndex; }
+#endif
+
 #ifndef __CINT__
    std::shared_ptr<TRawEvent> NewEvent() override { return std::make_shared<TMidasEvent>(); }
 #endif
 
 protected:
-   void ReadMoreBytes(size_t bytes);
+   bool ReadMoreBytes(size_t bytes); ///< returns false on a read or decompression error (but not at the end of the file)
+   bool MapFile();                          ///< memory map the open input file
+   void UnmapFile();                        ///< release our reference to the mapping
+   bool EnsureMapped(size_t bytes);         ///< make sure the next bytes are mapped, re-map if the file grew
+   int  ReadMapped(TMidasEvent* midasEvent); ///< read one event from the memory mapped file
+   bool ReadHeaderAt(size_t offset, TMidas_EVENT_HEADER& header); ///< read the event header at offset
+   void AddIndexEntry(size_t offset, TMidasEvent* midasEvent);    ///< add event to the index (every N-th event)
+   bool LoadIndex();                                              ///< read or build the index
+   void EndOfFile();                                              ///< reached the end of the file
 
 #ifndef __CINT__
    std::shared_ptr<TMidasEvent> fFirstEvent;
@@ -102,6 +154,21 @@ protected:
    int   fOutFile;   ///< open output file descriptor
    void* fOutGzFile; ///< zlib compressed output file reader
 
+   TDecompressor* fDecompressor; //!<! multi-threaded decompression of compressed input files
+
+#ifndef __CINT__
+   std::shared_ptr<char> fMappedFile; ///< memory mapped input file, shared with the events pointing into it
+#endif
+   size_t fMappedSize{0};   ///< size of the memory mapped region
+   size_t fMappedOffset{0}; ///< current read position in the memory mapped region
+
+#ifndef __CINT__
+   std::vector<TMidasIndexEntry> fIndex; ///< index of every fIndexInterval-th event
+#endif
+   int    fIndexInterval{1000}; ///< number of events between index entries
+   bool   fIndexing{false};     ///< index is being built while reading the file sequentially
+   size_t fEndOffset{0};        ///< offset at which to stop reading (0 = end of file)
+
    /// \cond CLASSIMP
    ClassDefOverride(TMidasFile, 0) // Used to open and write Midas Files
    /// \endcond
@@ -0,0 +1,117 @@
+#ifndef TMIDASRING_H
+#define TMIDASRING_H
+
+/** \addtogroup Sorting
+ *  @{
+ */
+
+/////////////////////////////////////////////////////////////////
+///
+/// \class TMidasRing
+///
+/// This Class reads MIDAS events from a POSIX shared memory ring
+/// buffer, so the data loop can sort data online while it is being
+/// taken (--input-ring <name>).
+///
+/// The ring consists of a small header followed by the data area.
+/// A single producer writes complete events (midas event header
+/// plus data) and only then advances the write position, a single
+/// reader copies the events out and advances the read position.
+/// The producer blocks while the ring is full. Once the producer is
+/// done it sets the finished flag, and the reader stops after it
+/// has read the remaining events.
+///
+/// If the first event in the ring is the begin-of-run ODB dump it
+/// is kept as first event (like for a TMidasFile) and the run
+/// number is taken from it.
+///
+/// The MidasRingReplay utility creates a ring and replays a midas
+/// file into it.
+///
+/////////////////////////////////////////////////////////////////
+
+#include <string>
+
+#ifdef __APPLE__
+#include <_types/_uint32_t.h>
+#else
+#include <cstdint>
+#endif
+
+#include "TRawFile.h"
+
+#include "TMidasEvent.h"
+
+#ifndef __CINT__
+struct TMidasRingHeader;
+#endif
+
+class TMidasRing : public TRawFile {
+public:
+   enum EOpenType { kRead, kWrite };
+
+   TMidasRing(); ///< default constructor
+   TMidasRing(const char* name, EOpenType open_type = kRead);
+   ~TMidasRing() override; ///< destructor
+
+   bool Open(const char* name) override;        ///< Attach to an existing ring as reader
+   bool Create(const char* name, size_t size); ///< Create a new ring as producer
+
+   void Close() override; ///< Detach from the ring (and remove it if we created it)
+
+   using TObject::Read;
+   using TObject::Write;
+#ifndef __CINT__
+   int  Read(std::shared_ptr<TRawEvent> event) override; ///< Read one event from the ring
+   int  Read(TMidasEvent* event);                        ///< Read one event from the ring
+   bool Write(const std::shared_ptr<TMidasEvent>& event); ///< Write one event to the ring, blocks while it is full
+#endif
+   void SetFinished(); ///< Tell the reader that no more events will be written
+
+   std::string Status(bool long_file_description = true) override;
+
+   bool IsLive() const override; ///< are there still events to come?
+
+   size_t GetFileSize() override; ///< number of bytes written to the ring so far
+   size_t GetBytesUnread() const; ///< number of bytes written to the ring that haven't been read yet
+
+   const char* GetLastError() const { return fLastError.c_str(); } ///< Get error text for the last error
+   void        SetTimeout(int milliseconds) { fTimeout = milliseconds; } ///< how long Read waits for new events
+
+#ifndef __CINT__
+   std::shared_ptr<TMidasEvent> GetFirstEvent() { return fFirstEvent; }
+#endif
+
+   int GetRunNumber() override;
+   int GetSubRunNumber() override { return -1; }
+
+#ifndef __CINT__
+   std::shared_ptr<TRawEvent> NewEvent() override { return std::make_shared<TMidasEvent>(); }
+#endif
+
+private:
+   bool Map(int fd, size_t size);
+   bool WaitForEvent();
+   void CopyIn(uint64_t position, const char* source, size_t size);
+   void CopyOut(uint64_t position, char* destination, size_t size) const;
+
+#ifndef __CINT__
+   TMidasRingHeader*            fRing;        //!<! the mapped ring header, the data follows it
+   std::shared_ptr<TMidasEvent> fFirstEvent;  //!<! begin-of-run event
+   std::shared_ptr<TMidasEvent> fPendingEvent; //!<! first event if it wasn't a begin-of-run event
+#endif
+   char*       fData;        ///< start of the data area
+   size_t      fMappedSize;  ///< size of the mapping (header plus data area)
+   bool        fOwner;       ///< did we create the ring?
+   bool        fBroken;      ///< did we find corrupted data in the ring?
+   int         fTimeout;     ///< time in ms Read waits for new events before returning
+   int         fRunNumber;   ///< run number from the begin-of-run event
+   int         fEventsRead;  ///< number of events read
+   std::string fLastError;   ///< error text of the last error
+
+   /// \cond CLASSIMP
+   ClassDefOverride(TMidasRing, 0) // Used to read midas events from a shared memory ring
+   /// \endcond
+};
+/*! @} */
+#endif // TMidasRing.h
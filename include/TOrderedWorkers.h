@@ -0,0 +1,221 @@
+#ifndef TORDEREDWORKERS_H
+#define TORDEREDWORKERS_H
+
+/** \addtogroup Loops
+ *  @{
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \class TOrderedWorkers
+///
+/// A pool of worker threads that process the items of an input queue in
+/// parallel, while their output is released in the order of the input.
+///
+/// Each item gets a sequence number when a worker pops it from the input
+/// queue. The output of the worker is kept (keyed by that number) until all
+/// earlier outputs have been handed out by Release(), which is called by the
+/// loop owning the workers. To keep the workers from getting too far ahead of
+/// an item that is stuck in a slow worker, they wait while more than
+/// maxPending outputs can't be released yet.
+///
+/// Start() gets a function that is called once on each worker thread and
+/// returns the function processing the items of that worker, so each worker
+/// can have its own state (parser, event pool, ...):
+///
+/// \code
+/// fWorkers.Start(fInputQueue, fNofWorkers, 64 * fNofWorkers, [this]() {
+///    std::shared_ptr<TUnpackedEventPool> pool = TUnpackedEventPool::Create();
+///    return [this, pool](std::vector<std::shared_ptr<const TFragment>>& frags) { return BuildEvent(frags, pool); };
+/// });
+/// \endcode
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CINT__
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ThreadsafeQueue.h"
+
+template <typename TInput, typename TOutput>
+class TOrderedWorkers {
+public:
+   typedef std::function<TOutput(TInput&)> TProcess;
+
+   TOrderedWorkers()
+      : fRunningWorkers(0), fStop(false), fNextSequence(0), fMaxPending(0), fNextRelease(0), fItemsPopped(nullptr),
+        fInputSize(nullptr)
+   {
+   }
+   ~TOrderedWorkers() { Stop(); }
+
+   /// The workers count the items they pop in itemsPopped and store the size of the input queue in inputSize, like
+   /// the loop would.
+   void SetStatusVariables(std::atomic_size_t* itemsPopped, std::atomic_long* inputSize)
+   {
+      fItemsPopped = itemsPopped;
+      fInputSize   = inputSize;
+   }
+
+   void Start(const std::shared_ptr<ThreadsafeQueue<TInput>>& input, int nofWorkers, size_t maxPending,
+              const std::function<TProcess()>& makeProcess);
+   void Stop();
+   bool IsStarted() const { return !fWorkers.empty(); }
+
+   bool Release(std::vector<TOutput>& output, int millisecond_wait = 10);
+   void Clear();
+
+private:
+   void WorkerLoop(std::function<TProcess()> makeProcess);
+
+   std::shared_ptr<ThreadsafeQueue<TInput>> fInput;
+
+   std::vector<std::thread> fWorkers;
+   std::atomic_int          fRunningWorkers;
+   std::atomic_bool         fStop;
+
+   std::mutex               fInputMutex;     ///< makes popping an item and numbering it one step
+   size_t                   fNextSequence;   ///< sequence number of the next item popped by a worker
+   std::mutex               fReorderMutex;
+   std::condition_variable  fOutputAdded;    ///< signalled when a worker has added an output to fPending
+   std::condition_variable  fOutputReleased; ///< signalled when outputs have been released
+   std::map<size_t, TOutput> fPending;       ///< outputs that can't be released yet, keyed by sequence number
+   size_t                   fMaxPending;     ///< maximum size of fPending before the workers wait
+   size_t                   fNextRelease;    ///< sequence number of the next output to be released
+
+   std::atomic_size_t* fItemsPopped;
+   std::atomic_long*   fInputSize;
+};
+
+template <typename TInput, typename TOutput>
+void TOrderedWorkers<TInput, TOutput>::Start(const std::shared_ptr<ThreadsafeQueue<TInput>>& input, int nofWorkers,
+                                             size_t maxPending, const std::function<TProcess()>& makeProcess)
+{
+   fInput          = input;
+   fMaxPending     = maxPending;
+   fStop           = false;
+   fRunningWorkers = nofWorkers;
+   for(int i = 0; i < nofWorkers; ++i) {
+      fWorkers.emplace_back(&TOrderedWorkers::WorkerLoop, this, makeProcess);
+   }
+}
+
+template <typename TInput, typename TOutput>
+void TOrderedWorkers<TInput, TOutput>::Stop()
+{
+   fStop = true;
+   fOutputReleased.notify_all();
+   for(auto& worker : fWorkers) {
+      if(worker.joinable()) {
+         worker.join();
+      }
+   }
+}
+
+template <typename TInput, typename TOutput>
+void TOrderedWorkers<TInput, TOutput>::WorkerLoop(std::function<TProcess()> makeProcess)
+{
+   TProcess process = makeProcess();
+   while(!fStop) {
+      // don't get too far ahead of the release, the item we're waiting for might be stuck in a slow worker
+      {
+         std::unique_lock<std::mutex> lock(fReorderMutex);
+         fOutputReleased.wait(lock, [this] { return fPending.size() < fMaxPending || fStop; });
+      }
+      if(fStop) {
+         break;
+      }
+
+      TInput input;
+      size_t sequence;
+      {
+         std::lock_guard<std::mutex> lock(fInputMutex);
+         long                        size = fInput->Pop(input, 100);
+         if(size < 0) {
+            if(fInputSize != nullptr) {
+               *fInputSize = 0;
+            }
+            if(fInput->IsFinished()) {
+               break;
+            }
+            continue;
+         }
+         if(fInputSize != nullptr) {
+            *fInputSize = size;
+         }
+         if(fItemsPopped != nullptr) {
+            ++(*fItemsPopped);
+         }
+         sequence = fNextSequence++;
+      }
+
+      TOutput output = process(input);
+
+      {
+         std::lock_guard<std::mutex> lock(fReorderMutex);
+         // the item was popped before a Clear(), its output is dropped like the ones that were pending then
+         if(sequence < fNextRelease) {
+            continue;
+         }
+         fPending[sequence] = std::move(output);
+      }
+      fOutputAdded.notify_one();
+   }
+
+   --fRunningWorkers;
+   fOutputAdded.notify_one();
+}
+
+template <typename TInput, typename TOutput>
+bool TOrderedWorkers<TInput, TOutput>::Release(std::vector<TOutput>& output, int millisecond_wait)
+{
+   /// Appends all outputs that are next in line to output, waits up to millisecond_wait ms if there are none.
+   /// Returns false once all workers are done and all their outputs have been released.
+   size_t                       released = 0;
+   std::unique_lock<std::mutex> lock(fReorderMutex);
+   while(!fPending.empty() && fPending.begin()->first == fNextRelease) {
+      output.push_back(std::move(fPending.begin()->second));
+      fPending.erase(fPending.begin());
+      ++fNextRelease;
+      ++released;
+   }
+
+   if(released == 0) {
+      if(fRunningWorkers == 0) {
+         // the workers only stop once the input is finished (or they were told to stop)
+         return false;
+      }
+      fOutputAdded.wait_for(lock, std::chrono::milliseconds(millisecond_wait));
+      return true;
+   }
+   lock.unlock();
+   fOutputReleased.notify_all();
+
+   return true;
+}
+
+template <typename TInput, typename TOutput>
+void TOrderedWorkers<TInput, TOutput>::Clear()
+{
+   /// Drops all outputs that haven't been released yet, as well as the ones of items that are being processed right
+   /// now. The release continues with the next item popped from the input.
+   {
+      std::lock_guard<std::mutex> inputLock(fInputMutex);
+      std::lock_guard<std::mutex> reorderLock(fReorderMutex);
+      fPending.clear();
+      fNextRelease = fNextSequence;
+   }
+   fOutputReleased.notify_all();
+}
+#endif
+
+/*! @} */
+#endif /* TORDEREDWORKERS_H */
@@ -22,16 +22,31 @@
 /// The TPPG is designed to hold all of the information about the
 /// PPG status.
 ///
+/// The status lookups (GetStatus, GetLastStatusTime, GetTimeInCycle)
+/// don't search the map. They use a flat copy of it (TPPGTimeline) that
+/// is rebuilt whenever the map changes, and each thread keeps a cursor
+/// into it. Hits come in nearly time ordered, so the cursor usually
+/// only has to move ahead by a word or two, and only jumps back in time
+/// need a binary search.
+///
 //////////////////////////////////////////////////////////////////////////
 
 #include <map>
 #include <utility>
+#ifndef __CINT__
+#include <atomic>
+#include <memory>
+#endif
 
 #include "TObject.h"
 #include "TCollection.h"
 
 #include "Globals.h"
 
+#ifndef __CINT__
+struct TPPGTimeline;
+#endif
+
 class TPPGData : public TObject {
 public:
    TPPGData();
@@ -144,6 +159,13 @@ public:
    void Clear(Option_t* opt = "") override;
 
 private:
+#ifndef __CINT__
+   const TPPGTimeline* Timeline() const;
+   size_t FindIndex(const TPPGTimeline* timeline, ULong64_t time) const;
+   std::shared_ptr<const TPPGTimeline> BuildTimeline(size_t version) const;
+#endif
+   void InvalidateTimeline();
+
    static TPPG*       fPPG; //< static pointer to TPPG
    PPGMap_t::iterator MapBegin() const { return ++(fPPGStatusMap->begin()); }
    PPGMap_t::iterator MapEnd() const { return fPPGStatusMap->end(); }
@@ -156,6 +178,11 @@ private:
    std::vector<short> fOdbPPGCodes;  ///< ppg state codes read from odb
    std::vector<int>   fOdbDurations; ///< duration of ppg state as read from odb
 
+#ifndef __CINT__
+   std::atomic_size_t                          fTimelineVersion{0}; //!<! changes every time the map changes
+   mutable std::shared_ptr<const TPPGTimeline> fTimeline;           //!<! flat copy of the map for the lookups
+#endif
+
    /// \cond CLASSIMP
    ClassDefOverride(TPPG, 3) // Contains PPG information
    /// \endcond
@@ -79,8 +79,8 @@ public:
 #ifndef __CINT__
    void GoodFragment(const std::shared_ptr<const TFragment>&);
 #endif
-   void GoodFragment(Short_t detType) { fNumberOfGoodFragments[detType]++; }
-   void BadFragment(Short_t detType) { fNumberOfBadFragments[detType]++; }
+   void GoodFragment(Short_t detType);
+   void BadFragment(Short_t detType);
 
    void ReadPPG(TPPG*);
 
@@ -53,6 +53,10 @@ public:
    virtual int GetRunNumber()    = 0;
    virtual int GetSubRunNumber() = 0;
 
+   virtual void Prefetch() {} ///< Hint that this file is going to be read soon
+   virtual bool IsLive() const { return false; } ///< Can more events arrive later (online input)?
+   bool IsEndOfFile() const { return fEndOfFile; } ///< Did a read stop at the end of the file (and not on an error)?
+
    virtual size_t GetBytesRead() { return fBytesRead; }
    virtual size_t GetFileSize() { return fFileSize; }
 
@@ -67,6 +71,7 @@ protected:
 
    size_t fBytesRead{0};
    size_t fFileSize{0};
+   bool   fEndOfFile{false}; ///< set by Read once all events have been read
 
    /// \cond CLASSIMP
    ClassDefOverride(TRawFile, 0) // Used to open and write Midas Files
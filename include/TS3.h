@@ -114,7 +114,7 @@ private:
    std::vector<TS3Hit> fS3Hits; //!<!
    std::vector<TS3Hit> fS3RingHits, fS3SectorHits;
 
-   TTransientBits<UChar_t> fS3Bits; // flags for transient members
+   TTransientBits<UChar_t> fS3Bits; //!<! flags for transient members
    void                    ClearStatus() { fS3Bits = 0; }
    void SetBitNumber(enum ES3Bits bit, Bool_t set = true);
    Bool_t TestBitNumber(enum ES3Bits bit) const { return (fS3Bits.TestBit(bit)); }
@@ -138,7 +138,7 @@ private:
    static double fFrontBackEnergy; //!
 
    /// \cond CLASSIMP
-   ClassDefOverride(TS3, 4)
+   ClassDefOverride(TS3, 5)
    /// \endcond
 };
 /*! @} */
@@ -21,10 +21,18 @@
 /// The TScaler is designed to hold all of the information about the
 /// scaler status.
 ///
+/// Once loaded (loadIntoMap, or the first Draw), the scaler data of
+/// each address is kept as two flat arrays (TScalerValues): the sorted
+/// time stamps and the scaler values of each readout. The lookups are
+/// binary searches in these arrays, and only GetScaler(address, time)
+/// allocates memory (for the vector it returns).
+///
 //////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <vector>
 
 #include "TObject.h"
 #include "Globals.h"
@@ -95,6 +103,20 @@ private:
    /// \endcond
 };
 
+#ifndef __CINT__
+/// Scaler readouts of one address, sorted by time stamp.
+struct TScalerValues {
+   std::vector<ULong64_t> fTimes;    ///< time stamps of the readouts
+   std::vector<UInt_t>    fValues;   ///< fWidth scaler values for each readout
+   size_t                 fWidth{0}; ///< number of scaler values per readout
+
+   size_t Size() const { return fTimes.size(); }
+   /// index of the first readout at or after time (Size() if there is none)
+   size_t Find(ULong64_t time) const { return std::lower_bound(fTimes.begin(), fTimes.end(), time) - fTimes.begin(); }
+   UInt_t Value(size_t readout, size_t index) const { return index < fWidth ? fValues[readout * fWidth + index] : 0; }
+};
+#endif
+
 class TScaler : public TObject {
 public:
    TScaler(bool loadIntoMap = false);
@@ -123,12 +145,19 @@ public:
 
    void ListHistograms();
 
+   void LoadScalers(); ///< loads all scaler data from the tree into memory
+
 private:
+#ifndef __CINT__
+   void FillDifferences(TH1D* hist, const TScalerValues& values, size_t index, bool timeInCycle);
+#endif
+
    TTree*       fTree;
    TScalerData* fScalerData;
    Long64_t     fEntries;
-   std::map<UInt_t, std::map<ULong64_t, std::vector<UInt_t>>>
-      fScalerMap; //!<! an address-map of timestamp mapped scaler values
+#ifndef __CINT__
+   std::map<UInt_t, TScalerValues> fScalers; //!<! the scaler readouts of each address
+#endif
    std::map<UInt_t, ULong64_t>
       fTimePeriod; //!<! a map between addresses and time differences (used to calculate the time period)
    std::map<UInt_t, std::map<ULong64_t, int>> fNumberOfTimePeriods; //!<!
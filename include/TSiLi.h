@@ -112,9 +112,9 @@ public:
 	
 private:
    std::vector<TSiLiHit> fSiLiHits;
-   std::vector<TSiLiHit> fAddbackHits;
+   std::vector<TSiLiHit> fAddbackHits; //!<! Used to create addback hits on the fly
 
-   TTransientBits<UChar_t> fSiLiBits;
+   TTransientBits<UChar_t> fSiLiBits; //!<!
 
    void SortCluster(std::vector<unsigned>&);
 
@@ -127,7 +127,7 @@ private:
    static double fTargetDistance; //!<!
 
    /// \cond CLASSIMP
-   ClassDefOverride(TSiLi, 5);
+   ClassDefOverride(TSiLi, 6);
    /// \endcond
 };
 /*! @} */
@@ -45,6 +45,10 @@ private:
    std::map<long, std::pair<long, long>> fFragmentsOutOfOrder;
    std::vector<Long_t> fPreviousTimeStamps; ///< timestamps of previous fragments, saved every 'BuildWindow' entries
    long                fMaxEntryDiff{0};
+   long                fSortDepth{0};       ///< sort depth at the end of the event building
+   long                fMaxSortDepth{0};    ///< largest sort depth used during the event building
+   long                fMaxLateEntries{0};  ///< largest number of fragments a fragment arrived after its place
+   long                fMaxLateTime{0};     ///< largest time stamp (or trigger id) difference of a late fragment
 
    static TSortingDiagnostics* fSortingDiagnostics;
 
@@ -52,11 +56,16 @@ public:
    //"setter" functions
    void OutOfOrder(long newFragTS, long oldFragTS, long newEntry);
    void AddTimeStamp(Long_t val) { fPreviousTimeStamps.push_back(val); }
+   void SortDepth(long finalDepth, long maxDepth, long lateEntries, long lateTime);
 
    // getter functions
    size_t NumberOfFragmentsOutOfOrder() const { return fFragmentsOutOfOrder.size(); }
    std::map<long, std::pair<long, long>> FragmentsOutOfOrder() { return fFragmentsOutOfOrder; }
    long MaxEntryDiff() const { return fMaxEntryDiff; }
+   long FinalSortDepth() const { return fSortDepth; }
+   long MaxSortDepth() const { return fMaxSortDepth; }
+   long MaxLateEntries() const { return fMaxLateEntries; }
+   long MaxLateTime() const { return fMaxLateTime; }
 
    // other functions
    void WriteToFile(const char*) const;
@@ -67,7 +76,7 @@ public:
    void Draw(Option_t* opt = "") override;
 
    /// \cond CLASSIMP
-   ClassDefOverride(TSortingDiagnostics, 1);
+   ClassDefOverride(TSortingDiagnostics, 2);
    /// \endcond
 };
 /*! @} */
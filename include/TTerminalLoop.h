@@ -57,14 +57,15 @@ protected:
    bool Iteration() override
    {
       std::shared_ptr<T> event;
-      fInputQueue->Pop(event);
+      fInputQueue->Pop(event, 0);
 
       if(event) {
          return true;
       } else if(fInputQueue->IsFinished()) {
          return false;
       } else {
-         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+         WakeOn(fInputQueue);
+         WaitForInput();
          return true;
       }
    }
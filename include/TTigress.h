@@ -111,7 +111,7 @@ private:
    static std::function<bool(TTigressHit&, TBgoHit&)>     fSuppressionCriterion;
 #endif
    static TTransientBits<UShort_t> fgTigressBits; //!
-   TTransientBits<UShort_t>        fTigressBits;
+   TTransientBits<UShort_t>        fTigressBits; //!<!
 
    std::vector<TTigressHit> fTigressHits;
 
@@ -187,7 +187,7 @@ public:
    void Copy(TObject&) const override;            //!<!
 
    /// \cond CLASSIMP
-   ClassDefOverride(TTigress, 7) // Tigress Physics structure
+   ClassDefOverride(TTigress, 8) // Tigress Physics structure
    /// \endcond
 };
 /*! @} */
@@ -12,6 +12,20 @@
 
 class TFragment;
 
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \class TUnpackedEvent
+///
+/// Holds the detectors built from the fragments of one event.
+///
+/// Each detector class is mapped once to a slot number (see Slot), so finding
+/// the detector of a fragment is an array access instead of a search through
+/// all detectors of the event. Clear() keeps the detector objects in their
+/// slots, so an event that is re-used (see TUnpackedEventPool) doesn't need
+/// to create new detectors.
+///
+////////////////////////////////////////////////////////////////////////////////
+
 class TUnpackedEvent {
 public:
    TUnpackedEvent();
@@ -23,21 +37,27 @@ public:
    std::shared_ptr<TDetector> GetDetector(TClass* cls, bool make_if_not_found = false);
 
    std::vector<std::shared_ptr<TDetector>>& GetDetectors() { return fDetectors; }
-   void AddDetector(const std::shared_ptr<TDetector>& det) { fDetectors.push_back(det); }
+   void AddDetector(const std::shared_ptr<TDetector>& det);
    void AddRawData(const std::shared_ptr<const TFragment>& frag);
 #endif
    void ClearRawData();
+   void Clear(); ///< removes all fragments and detectors, keeping the detectors for re-use
 
    void Build();
 
    int Size() { return fDetectors.size(); }
 
+   static size_t Slot(TClass* cls); ///< slot number of this detector class
+
 private:
    void BuildHits();
+   void CalculateHits(); ///< fills the cached energies and times of the hits (for the column tree)
 
 #ifndef __CINT__
    std::vector<std::shared_ptr<const TFragment>> fFragments;
-   std::vector<std::shared_ptr<TDetector>>       fDetectors;
+   std::vector<std::shared_ptr<TDetector>>       fDetectors; ///< detectors of this event
+   std::vector<std::shared_ptr<TDetector>>       fSlots;     ///< detectors of this event, indexed by slot number
+   std::vector<std::shared_ptr<TDetector>>       fSpare;     ///< cleared detectors for re-use, indexed by slot number
 #endif
 };
 
@@ -46,20 +66,7 @@ template <typename T>
 std::shared_ptr<T> TUnpackedEvent::GetDetector(bool make_if_not_found)
 {
    static_assert(std::is_base_of<TDetector, T>::value, "T must be a subclass of TDetector");
-   for(const auto& det : fDetectors) {
-      std::shared_ptr<T> output = std::static_pointer_cast<T>(det);
-      if(output) {
-         return output;
-      }
-   }
-
-   if(make_if_not_found) {
-      std::shared_ptr<T> output = std::make_shared<T>();
-      fDetectors.push_back(output);
-      return output;
-   } else {
-      return nullptr;
-   }
+   return std::static_pointer_cast<T>(GetDetector(T::Class(), make_if_not_found));
 }
 #endif
 
@@ -0,0 +1,63 @@
+#ifndef TUNPACKEDEVENTPOOL_H
+#define TUNPACKEDEVENTPOOL_H
+
+/** \addtogroup Loops
+ *  @{
+ */
+
+/////////////////////////////////////////////////////////////////
+///
+/// \class TUnpackedEventPool
+///
+/// Recycles the TUnpackedEvents created by the TDetBuildingLoop.
+///
+/// Get() hands out shared pointers to events from a free list. Once
+/// the last loop holding an event (analysis writing, histogramming)
+/// releases it, the event is cleared and put back on the free list.
+/// The event keeps its detectors (see TUnpackedEvent::Clear), so
+/// once the pipeline is filled no new events or detectors are
+/// created.
+///
+/// Each detector building thread has its own pool. Events can be
+/// returned from any thread, they are collected in a separate list
+/// that is swapped into the free list once that runs empty.
+///
+/////////////////////////////////////////////////////////////////
+
+#ifndef __CINT__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TUnpackedEvent.h"
+
+class TUnpackedEventPool : public std::enable_shared_from_this<TUnpackedEventPool> {
+public:
+   static std::shared_ptr<TUnpackedEventPool> Create(size_t maxSize = 10000);
+   ~TUnpackedEventPool();
+
+   std::shared_ptr<TUnpackedEvent> Get(); ///< get an empty event
+
+   size_t Allocated() const { return fAllocated; } ///< number of events allocated by this pool
+   size_t Recycled() const { return fRecycled; }   ///< number of events handed out again after being returned
+
+private:
+   explicit TUnpackedEventPool(size_t maxSize);
+
+   TUnpackedEvent* Take();
+   void            Return(TUnpackedEvent* event);
+
+   std::vector<TUnpackedEvent*> fFree;        ///< events ready to be handed out (only used by the owning thread)
+   std::vector<TUnpackedEvent*> fReturned;    ///< events returned by the other loops
+   std::mutex                   fReturnMutex; ///< protects fReturned
+   size_t                       fMaxSize;     ///< maximum number of events kept for re-use
+
+   std::atomic_size_t fAllocated{0};
+   std::atomic_size_t fRecycled{0};
+};
+
+#endif
+/*! @} */
+#endif
@@ -11,11 +11,19 @@
 ///
 /// This loop parses Midas events into fragments.
 ///
+/// With more than one unpacking thread (--unpacking-threads), the midas
+/// events are decoded by a pool of worker threads, each with its own
+/// TDataParser in deferred mode. The output of each midas event is then
+/// released in the original order by this loop to fParser, which owns
+/// all state shared between midas events (see TDataParser::SetDeferredOutput).
+///
 ////////////////////////////////////////////////////////////////////////////////
 
 #ifndef __CINT__
 #include <memory>
+#include <vector>
 #include "ThreadsafeQueue.h"
+#include "TOrderedWorkers.h"
 #endif
 
 #include "StoppableThread.h"
@@ -31,8 +39,16 @@ public:
    static TUnpackingLoop* Get(std::string name = "");
    ~TUnpackingLoop() override;
 
-   void SetNoWaveForms(bool temp = true) { fParser.SetNoWaveForms(temp); }
-   void SetRecordDiag(bool temp = true) { fParser.SetRecordDiag(temp); }
+   void SetNoWaveForms(bool temp = true)
+   {
+      fNoWaveforms = temp;
+      fParser.SetNoWaveForms(temp);
+   }
+   void SetRecordDiag(bool temp = true)
+   {
+      fRecordDiag = temp;
+      fParser.SetRecordDiag(temp);
+   }
 
 #ifndef __CINT__
    std::shared_ptr<ThreadsafeQueue<std::shared_ptr<TRawEvent>>>&       InputQueue() { return fInputQueue; }
@@ -53,6 +69,7 @@ public:
    bool Iteration() override;
 
    void ClearQueue() override;
+   void OnEnd() override;
 
    size_t GetItemsPushed() override { return fParser.ItemsPushed(); }
    size_t GetItemsPopped() override { return 0; }  // fParser.GoodOutputQueue()->ItemsPopped(); }
@@ -64,6 +81,18 @@ public:
 private:
 #ifndef __CINT__
    std::shared_ptr<ThreadsafeQueue<std::shared_ptr<TRawEvent>>> fInputQueue;
+
+   /// The deferred output of one midas event, waiting to be released in order.
+   struct TParsedEvent {
+      std::vector<TDataParser::TDeferredEntry> fEntries;
+      int                                      fFrags{0};
+      int                                      fGoodFrags{0};
+   };
+
+   void StartWorkers();
+   bool ReleaseParsedEvents();
+
+   TOrderedWorkers<std::shared_ptr<TRawEvent>, TParsedEvent> fWorkers; ///< parse the midas events, each with its own parser
 #endif
 
    TDataParser fParser;
@@ -73,6 +102,10 @@ private:
    bool   fEvaluateDataType;
    UInt_t fDataType;
 
+   int    fNofWorkers;  ///< number of unpacking threads (1 = parse on this loop's thread)
+   bool   fNoWaveforms; ///< passed on to the parsers of the workers
+   bool   fRecordDiag;  ///< passed on to the parsers of the workers
+
    TUnpackingLoop(std::string name);
    TUnpackingLoop(const TUnpackingLoop& other);
    TUnpackingLoop& operator=(const TUnpackingLoop& other);
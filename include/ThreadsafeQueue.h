@@ -6,23 +6,101 @@
 /// \class ThreadsafeQueue
 /// Template for all queues used to send data from one thread/loop to the next.
 ///
+/// The queue is a bounded lock-free ring buffer (following D. Vyukov's bounded
+/// MPMC queue): every slot carries a sequence number that tells producers and
+/// consumers whether the slot is free to be written or holds data ready to be
+/// read, and the positions of the producers and consumers are claimed with a
+/// single compare-and-swap. This covers our single producer/single consumer
+/// queues as well as the fan-in cases, and clearing a queue from another
+/// thread is still safe.
+///
+/// The push and pop positions sit on separate cache lines, and as they count
+/// all items pushed/popped so far, ItemsPushed(), ItemsPopped(), and Size()
+/// are simple atomic loads. A mutex and condition variables are only used to
+/// put a thread to sleep when the queue is full (Push) or empty (Pop), and are
+/// only notified if a thread actually waits.
+///
+/// The ring is allocated up front, so it has at most kMaxRingSize slots. Queues
+/// with a larger maximum size (like the fragment write queue) put the items that
+/// don't fit into the ring into an overflow deque instead, which only grows as
+/// far as it is used. While there are items in the overflow, all pushes go there
+/// (under a mutex), and the consumers move them into the ring once it is empty.
+/// Size() and ItemsPushed() take the mutex as well while the overflow isn't
+/// empty, so an item being moved into the ring isn't counted twice.
+///
+/// Push blocks while the queue holds maxSize items. A loop that pushes into
+/// several queues (e.g. the data loop feeding the fragment writer and the event
+/// builder) therefore slows down to the pace of the slowest of its consumers
+/// once that consumer's queue is full.
+///
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <cassert>
 #include <iostream>
 
 #ifndef __CINT__
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <queue>
 #include <utility>
+#include <vector>
 #endif
 
 class TDetector;
 
+#ifndef __CINT__
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \class ThreadsafeQueueWakeup
+/// Lets a loop sleep until any of several queues has new data or is finished.
+/// The queues call Notify() after each push (and when they are finished), Wait()
+/// returns right away if there was a notification since the last call.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+class ThreadsafeQueueWakeup {
+public:
+   void Notify()
+   {
+      if(!notified.load(std::memory_order_relaxed)) {
+         notified.store(true, std::memory_order_relaxed);
+      }
+      // pairs with the fence in Wait, either we see the waiter or it sees the notification
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(waiters.load(std::memory_order_relaxed) > 0) {
+         std::lock_guard<std::mutex> lock(mutex);
+         wakeup.notify_all();
+      }
+   }
+
+   bool Wait(int millisecond_wait)
+   {
+      if(notified.exchange(false)) {
+         return true;
+      }
+      ++waiters;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         wakeup.wait_for(lock, std::chrono::milliseconds(millisecond_wait), [this] { return notified.load(); });
+      }
+      --waiters;
+      return notified.exchange(false);
+   }
+
+private:
+   std::mutex              mutex;
+   std::condition_variable wakeup;
+   std::atomic_bool        notified{false};
+   std::atomic_int         waiters{0};
+};
+#endif
+
 template <typename T>
 class ThreadsafeQueue {
 public:
@@ -30,7 +108,9 @@ public:
    ~ThreadsafeQueue();
 #ifndef __CINT__
    int Push(T obj);
+   int PushN(const std::vector<T>& objs);
    long Pop(T& output, int millisecond_wait = 1000);
+   size_t PopN(std::vector<T>& output, size_t maxItems, int millisecond_wait = 1000);
 
    size_t ItemsPushed() const;
    size_t ItemsPopped() const;
@@ -43,94 +123,328 @@ public:
    bool IsFinished() const;
    void SetFinished(bool finished = true);
 
+   /// Set a wakeup that is notified after every push and when the queue is finished, so the consumer can wait
+   /// for several queues at once.
+   void SetWakeup(const std::shared_ptr<ThreadsafeQueueWakeup>& wakeup);
+
 private:
+   struct Slot {
+      std::atomic<size_t> sequence; ///< == position: free to write, == position + 1: ready to read
+      T                   data;
+   };
+
+   bool TryPush(T& obj);
+   bool TryPop(T& output);
+   bool TryPushOverflow(T& obj);
+   bool TryPopOverflow(T& output);
+   bool CanPush() const;
+   bool CanPop() const;
+   void NotifyPop();
+   void NotifyPush();
+
+   static const size_t kCacheLine   = 64;
+   static const size_t kMaxRingSize = 1 << 16;
+
    std::string             fName;
-   mutable std::mutex      mutex;
-   std::queue<T>           queue;
-   std::condition_variable can_push;
-   std::condition_variable can_pop;
+   std::unique_ptr<Slot[]> slots;
+   size_t                  mask;
+   size_t                  max_size;  ///< the ring plus the overflow never hold more than this
+   size_t                  ring_size; ///< the ring never holds more than this (the power of two it has might be more)
 
-   std::atomic_int num_writers{0};
+   mutable std::mutex  overflow_mutex;
+   std::deque<T>       overflow;      ///< items that didn't fit into the ring, protected by overflow_mutex
+   std::atomic<size_t> overflow_size; ///< overflow.size(), so it can be checked without the mutex
 
-   size_t max_queue_size;
+   char                pad0[kCacheLine];
+   std::atomic<size_t> push_position; ///< number of items pushed (claimed by producers)
+   char                pad1[kCacheLine - sizeof(std::atomic<size_t>)];
+   std::atomic<size_t> pop_position; ///< number of items popped (claimed by consumers)
+   char                pad2[kCacheLine - sizeof(std::atomic<size_t>)];
 
-   size_t items_in_queue;
-   size_t items_pushed;
-   size_t items_popped;
+   std::mutex              wait_mutex;
+   std::condition_variable can_push;
+   std::condition_variable can_pop;
+   std::atomic_int         push_waiters{0};
+   std::atomic_int         pop_waiters{0};
 
    std::atomic_bool is_finished;
+
+   std::shared_ptr<ThreadsafeQueueWakeup> wakeup_owner; ///< keeps the wakeup alive
+   std::atomic<ThreadsafeQueueWakeup*>    wakeup{nullptr};
 #endif
 };
 
 #ifndef __CINT__
 template <typename T>
 ThreadsafeQueue<T>::ThreadsafeQueue(std::string name, size_t maxSize)
-   : fName(std::move(name)), max_queue_size(maxSize), items_in_queue(0), items_pushed(0), items_popped(0),
-     is_finished(false)
+   : fName(std::move(name)), mask(0), max_size(std::max(maxSize, static_cast<size_t>(1))), ring_size(0),
+     overflow_size(0), push_position(0), pop_position(0), is_finished(false)
 {
+   // the ring needs a power of two number of slots, anything above kMaxRingSize goes to the overflow
+   size_t capacity = 2;
+   while(capacity < maxSize && capacity < kMaxRingSize) {
+      capacity <<= 1;
+   }
+   ring_size = std::min(max_size, capacity);
+   slots.reset(new Slot[capacity]);
+   for(size_t i = 0; i < capacity; ++i) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+   }
+   mask = capacity - 1;
 }
 
 template <typename T>
 ThreadsafeQueue<T>::~ThreadsafeQueue() = default;
 
 template <typename T>
-int ThreadsafeQueue<T>::Push(T obj)
+bool ThreadsafeQueue<T>::TryPush(T& obj)
 {
-   std::unique_lock<std::mutex> lock(mutex);
-   if(queue.size() > max_queue_size) {
-      can_push.wait(lock);
+   size_t position = push_position.load(std::memory_order_relaxed);
+   while(true) {
+      Slot&  slot     = slots[position & mask];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if(sequence == position) {
+         // a ring that is larger than the maximum size can have a free slot while the queue is full (the pop
+         // position we read might be old, but that only makes us stop early)
+         if(ring_size <= mask) {
+            size_t popped = pop_position.load(std::memory_order_acquire);
+            if(position >= popped && position - popped >= ring_size) {
+               return false;
+            }
+         }
+         if(push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            slot.data = std::move(obj);
+            slot.sequence.store(position + 1, std::memory_order_release);
+            return true;
+         }
+      } else if(sequence < position) {
+         // the slot still holds the item from the last round, the queue is full
+         return false;
+      } else {
+         position = push_position.load(std::memory_order_relaxed);
+      }
    }
+}
 
-   items_pushed++;
-   items_in_queue++;
+template <typename T>
+bool ThreadsafeQueue<T>::TryPop(T& output)
+{
+   size_t position = pop_position.load(std::memory_order_relaxed);
+   while(true) {
+      Slot&  slot     = slots[position & mask];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if(sequence == position + 1) {
+         if(pop_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            output = std::move(slot.data);
+            // reset the slot, so it doesn't keep the object alive
+            slot.data = T();
+            slot.sequence.store(position + mask + 1, std::memory_order_release);
+            return true;
+         }
+      } else if(sequence < position + 1) {
+         // nothing has been written to this slot yet, the queue is empty
+         return false;
+      } else {
+         position = pop_position.load(std::memory_order_relaxed);
+      }
+   }
+}
 
-   queue.push(obj);
-   can_pop.notify_one();
-   return 1;
+template <typename T>
+bool ThreadsafeQueue<T>::TryPushOverflow(T& obj)
+{
+   /// Called when the ring was full (or the overflow wasn't empty). Pushes into the ring if there is room by now
+   /// and the overflow is empty, otherwise into the overflow, unless the queue already holds max_size items.
+   if(max_size <= ring_size) {
+      return false;
+   }
+   std::lock_guard<std::mutex> lock(overflow_mutex);
+   if(overflow.empty() && TryPush(obj)) {
+      return true;
+   }
+   if(overflow.size() + ring_size >= max_size) {
+      return false;
+   }
+   overflow.push_back(std::move(obj));
+   overflow_size.store(overflow.size(), std::memory_order_release);
+   return true;
 }
 
 template <typename T>
-long ThreadsafeQueue<T>::Pop(T& output, int millisecond_wait)
+bool ThreadsafeQueue<T>::TryPopOverflow(T& output)
+{
+   /// Called when the ring was empty. Moves as many items from the overflow into the ring as fit (they are all
+   /// newer than what was in the ring) and pops the first one.
+   if(overflow_size.load(std::memory_order_acquire) == 0) {
+      return false;
+   }
+   {
+      std::lock_guard<std::mutex> lock(overflow_mutex);
+      while(!overflow.empty() && TryPush(overflow.front())) {
+         overflow.pop_front();
+      }
+      overflow_size.store(overflow.size(), std::memory_order_release);
+   }
+   return TryPop(output);
+}
+
+template <typename T>
+bool ThreadsafeQueue<T>::CanPush() const
+{
+   if(overflow_size.load(std::memory_order_relaxed) > 0 || max_size > mask + 1 || ring_size <= mask) {
+      return Size() < max_size;
+   }
+   size_t position = push_position.load(std::memory_order_relaxed);
+   return slots[position & mask].sequence.load(std::memory_order_acquire) >= position;
+}
+
+template <typename T>
+bool ThreadsafeQueue<T>::CanPop() const
 {
-   std::unique_lock<std::mutex> lock(mutex);
-   if(!queue.size() && millisecond_wait) {
-      can_pop.wait_for(lock, std::chrono::milliseconds(millisecond_wait));
+   if(overflow_size.load(std::memory_order_relaxed) > 0) {
+      return true;
    }
+   size_t position = pop_position.load(std::memory_order_relaxed);
+   return slots[position & mask].sequence.load(std::memory_order_acquire) >= position + 1;
+}
 
-   if(!queue.size()) {
-      return -1;
+template <typename T>
+void ThreadsafeQueue<T>::NotifyPop()
+{
+   // only take the mutex if a consumer is (about to go) asleep, the fence pairs with the one in Pop
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if(pop_waiters.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(wait_mutex);
+      can_pop.notify_all();
+   }
+   ThreadsafeQueueWakeup* consumer = wakeup.load(std::memory_order_acquire);
+   if(consumer != nullptr) {
+      consumer->Notify();
    }
+}
 
-   output = queue.front();
-   queue.pop();
+template <typename T>
+void ThreadsafeQueue<T>::NotifyPush()
+{
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if(push_waiters.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(wait_mutex);
+      can_push.notify_all();
+   }
+}
 
-   items_popped++;
-   items_in_queue--;
+template <typename T>
+int ThreadsafeQueue<T>::Push(T obj)
+{
+   /// Pushes obj into the queue, waits while the queue is full.
+   while((overflow_size.load(std::memory_order_acquire) > 0 || !TryPush(obj)) && !TryPushOverflow(obj)) {
+      ++push_waiters;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      {
+         std::unique_lock<std::mutex> lock(wait_mutex);
+         can_push.wait_for(lock, std::chrono::milliseconds(100), [this] { return CanPush(); });
+      }
+      --push_waiters;
+   }
+   NotifyPop();
+   return 1;
+}
 
-   can_push.notify_one();
-   return queue.size();
+template <typename T>
+int ThreadsafeQueue<T>::PushN(const std::vector<T>& objs)
+{
+   /// Pushes all objects, waking up a waiting consumer only once.
+   if(objs.empty()) {
+      return 0;
+   }
+   for(auto obj : objs) {
+      while((overflow_size.load(std::memory_order_acquire) > 0 || !TryPush(obj)) && !TryPushOverflow(obj)) {
+         // let the consumer start on what we have pushed so far
+         NotifyPop();
+         ++push_waiters;
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+         {
+            std::unique_lock<std::mutex> lock(wait_mutex);
+            can_push.wait_for(lock, std::chrono::milliseconds(100), [this] { return CanPush(); });
+         }
+         --push_waiters;
+      }
+   }
+   NotifyPop();
+   return objs.size();
+}
+
+template <typename T>
+long ThreadsafeQueue<T>::Pop(T& output, int millisecond_wait)
+{
+   /// Pops the next object, waits up to millisecond_wait ms if the queue is empty.
+   /// Returns the number of objects left in the queue, or -1 if the queue was empty.
+   if(!TryPop(output) && !TryPopOverflow(output)) {
+      if(millisecond_wait <= 0) {
+         return -1;
+      }
+      ++pop_waiters;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      {
+         std::unique_lock<std::mutex> lock(wait_mutex);
+         can_pop.wait_for(lock, std::chrono::milliseconds(millisecond_wait),
+                          [this] { return CanPop() || is_finished.load(); });
+      }
+      --pop_waiters;
+      if(!TryPop(output) && !TryPopOverflow(output)) {
+         return -1;
+      }
+   }
+
+   NotifyPush();
+   return Size();
    // return ObjectSize(output);
 }
 
+template <typename T>
+size_t ThreadsafeQueue<T>::PopN(std::vector<T>& output, size_t maxItems, int millisecond_wait)
+{
+   /// Pops up to maxItems objects and appends them to output, waits up to millisecond_wait ms for
+   /// the first one. Returns the number of objects popped.
+   T      obj;
+   size_t popped = 0;
+   if(maxItems == 0 || Pop(obj, millisecond_wait) < 0) {
+      return 0;
+   }
+   do {
+      output.push_back(std::move(obj));
+      ++popped;
+   } while(popped < maxItems && (TryPop(obj) || TryPopOverflow(obj)));
+   if(popped > 1) {
+      NotifyPush();
+   }
+   return popped;
+}
+
 template <typename T>
 size_t ThreadsafeQueue<T>::Size() const
 {
-   std::unique_lock<std::mutex> lock(mutex);
-   return items_in_queue;
+   size_t popped = pop_position.load(std::memory_order_relaxed);
+   size_t pushed = ItemsPushed();
+   return (pushed > popped) ? pushed - popped : 0;
 }
 
 template <typename T>
 size_t ThreadsafeQueue<T>::ItemsPushed() const
 {
-   std::unique_lock<std::mutex> lock(mutex);
-   return items_pushed;
+   // items in the overflow are counted by push_position once they are moved into the ring, which happens under
+   // the overflow mutex (and overflow_size is only reset to 0 after they have been moved)
+   if(overflow_size.load(std::memory_order_acquire) > 0) {
+      std::lock_guard<std::mutex> lock(overflow_mutex);
+      return push_position.load(std::memory_order_relaxed) + overflow.size();
+   }
+   return push_position.load(std::memory_order_relaxed);
 }
 
 template <typename T>
 size_t ThreadsafeQueue<T>::ItemsPopped() const
 {
-   std::unique_lock<std::mutex> lock(mutex);
-   return items_popped;
+   return pop_position.load(std::memory_order_relaxed);
 }
 
 template <typename T>
@@ -144,6 +458,25 @@ void ThreadsafeQueue<T>::SetFinished(bool finished)
 {
    // std::cout<<std::endl<<fName<<": finished = "<<finished<<std::endl;
    is_finished = finished;
+   // wake up the consumer, so it sees that the queue is finished right away
+   {
+      std::lock_guard<std::mutex> lock(wait_mutex);
+      can_pop.notify_all();
+   }
+   ThreadsafeQueueWakeup* consumer = wakeup.load(std::memory_order_acquire);
+   if(consumer != nullptr) {
+      consumer->Notify();
+   }
+}
+
+template <typename T>
+void ThreadsafeQueue<T>::SetWakeup(const std::shared_ptr<ThreadsafeQueueWakeup>& consumer)
+{
+   if(wakeup.load(std::memory_order_relaxed) == consumer.get()) {
+      return;
+   }
+   wakeup_owner = consumer;
+   wakeup.store(consumer.get(), std::memory_order_release);
 }
 #endif /* __CINT__ */
 
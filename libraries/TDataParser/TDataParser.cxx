@@ -23,9 +23,11 @@ TDataParser::TDataParser()
      fScalerOutputQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<TEpicsFrag>>>("scaler_queue")),
      fNoWaveforms(false), fRecordDiag(true), fMaxTriggerId(1024 * 1024 * 16), fLastMidasId(0), fLastTriggerId(0),
      fLastNetworkPacket(0), fFragmentHasWaveform(false), fFragmentMap(fGoodOutputQueues, fBadOutputQueue),
-     fItemsPopped(nullptr), fInputSize(nullptr)
+     fDeferred(false), fBatchSize(1024), fFragmentPool(TFragmentPool::Create()), fItemsPopped(nullptr),
+     fInputSize(nullptr)
 {
    gChannel = new TChannel;
+   fGoodBatch.reserve(fBatchSize);
 }
 
 TDataParser::~TDataParser()
@@ -35,6 +37,7 @@ TDataParser::~TDataParser()
 
 void TDataParser::ClearQueue()
 {
+   fGoodBatch.clear();
    std::shared_ptr<const TFragment> frag;
    for(const auto& outQueue : fGoodOutputQueues) {
       while(outQueue->Size() != 0u) {
@@ -51,8 +54,98 @@ void TDataParser::ClearQueue()
    }
 }
 
+void TDataParser::SetDeferredOutput(bool temp)
+{
+   fDeferred = temp;
+   // set the options here so the parsing threads don't have to
+   if(fOptions == nullptr) {
+      fOptions = TGRSIOptions::Get();
+   }
+}
+
+void TDataParser::Release(std::vector<TDeferredEntry>& entries)
+{
+   /// Applies the output of a parser in deferred mode for one midas event. This has to be called in the order
+   /// of the midas events, as this is where all the state shared between midas events is updated. This is also
+   /// where the good fragments are recorded in the parsing diagnostics, so they see them in order and with the
+   /// reconstructed time stamps.
+   for(auto& entry : entries) {
+      switch(entry.fType) {
+      case EDeferredType::kGood:
+         if(entry.fTimeStampReference) {
+            fLastTimeStampMap[entry.fFragment->GetAddress()] = entry.fFragment->GetTimeStamp();
+         }
+         Push(fGoodOutputQueues, entry.fFragment);
+         break;
+      case EDeferredType::kTigress:
+         entry.fFragment->SetTriggerId(UnwrapTIGTriggerId(static_cast<uint32_t>(entry.fFragment->GetTriggerId())));
+         Push(fGoodOutputQueues, entry.fFragment);
+         break;
+      case EDeferredType::kReconstruct:
+         ReconstructHighTimeStamp(entry.fFragment);
+         Push(fGoodOutputQueues, entry.fFragment);
+         break;
+      case EDeferredType::kPileUp:
+         Flush();
+         fFragmentMap.Add(entry.fFragment, entry.fCharge, entry.fIntLength);
+         break;
+      case EDeferredType::kBad: Push(*fBadOutputQueue, entry.fBadFragment); break;
+      case EDeferredType::kPPG: TPPG::Get()->AddData(entry.fPPGData.get()); break;
+      case EDeferredType::kEpics: fScalerOutputQueue->Push(entry.fEpicsFrag); break;
+      }
+      if(entry.fGoodDiagnostics && fRecordDiag) {
+         if(entry.fBadFragment != nullptr) {
+            TParsingDiagnostics::Get()->GoodFragment(entry.fBadFragment);
+         } else {
+            TParsingDiagnostics::Get()->GoodFragment(entry.fFragment);
+         }
+      }
+   }
+   entries.clear();
+   Flush();
+}
+
+void TDataParser::Defer(EDeferredType type, const std::shared_ptr<TFragment>& frag, bool timeStampReference)
+{
+   TDeferredEntry entry;
+   entry.fType               = type;
+   entry.fFragment           = frag;
+   entry.fTimeStampReference = timeStampReference;
+   fDeferredEntries.push_back(entry);
+}
+
+void TDataParser::AddPileUp(const std::shared_ptr<TFragment>& frag, const std::vector<Int_t>& charge,
+                            const std::vector<Short_t>& integrationLength)
+{
+   /// The charges of piled-up hits can only be calculated once all fragments of the pile-up have been found,
+   /// which might be in a later midas event, so in deferred mode this is left to the parser owning the
+   /// TFragmentMap.
+   if(!fDeferred) {
+      // the fragment map pushes directly into the output queues, so the batch has to go first
+      Flush();
+      fFragmentMap.Add(frag, charge, integrationLength);
+      return;
+   }
+   Defer(EDeferredType::kPileUp, frag);
+   fDeferredEntries.back().fCharge    = charge;
+   fDeferredEntries.back().fIntLength = integrationLength;
+}
+
+void TDataParser::ReconstructHighTimeStamp(const std::shared_ptr<TFragment>& frag)
+{
+   /// Reconstructs the high bits of the time stamp from the high bits of the last time stamp of the same address.
+   if((frag->GetTimeStamp() & 0x0fffffff) < (fLastTimeStampMap[frag->GetAddress()] & 0x0fffffff)) {
+      // we had a wrap-around of the low time stamp, so we need to set the high bits to the old
+      // high bits plus one
+      frag->AppendTimeStamp(((fLastTimeStampMap[frag->GetAddress()] >> 28) + 1)<<28);
+   } else {
+      frag->AppendTimeStamp(fLastTimeStampMap[frag->GetAddress()] & 0x3fff0000000);
+   }
+}
+
 void TDataParser::SetFinished()
 {
+   Flush();
    for(const auto& outQueue : fGoodOutputQueues) {
       outQueue->SetFinished();
    }
@@ -64,7 +157,7 @@ int TDataParser::TigressDataToFragment(uint32_t* data, int size, unsigned int mi
 {
    /// Converts A MIDAS File from the Tigress DAQ into a TFragment.
    int                        NumFragsFound = 0;
-   std::shared_ptr<TFragment> eventFrag     = std::make_shared<TFragment>();
+   std::shared_ptr<TFragment> eventFrag     = fFragmentPool->Get();
    eventFrag->SetMidasTimeStamp(midasTime);
    eventFrag->SetMidasId(midasSerialNumber);
 
@@ -114,14 +207,18 @@ int TDataParser::TigressDataToFragment(uint32_t* data, int size, unsigned int mi
          /// check whether the fragment is 'good'
 
          if(((*(data + x + 1)) & 0xf0000000) != 0xe0000000) {
-            std::shared_ptr<TFragment> transferfrag = std::make_shared<TFragment>(*eventFrag);
-            eventFrag                               = std::make_shared<TFragment>();
+            std::shared_ptr<TFragment> transferfrag = fFragmentPool->Copy(*eventFrag);
+            eventFrag                               = fFragmentPool->Get();
             eventFrag->SetMidasTimeStamp(transferfrag->GetMidasTimeStamp());
             eventFrag->SetMidasId(transferfrag->GetMidasId());
             eventFrag->SetTriggerId(transferfrag->GetTriggerId());
             eventFrag->SetTimeStamp(transferfrag->GetTimeStamp());
 
-            Push(fGoodOutputQueues, transferfrag);
+            if(fDeferred) {
+               Defer(EDeferredType::kTigress, transferfrag);
+            } else {
+               Push(fGoodOutputQueues, transferfrag);
+            }
             NumFragsFound++;
 
             // printf("transferfrag = 0x%08x\n",transferfrag); fflush(stdout);
@@ -129,8 +226,12 @@ int TDataParser::TigressDataToFragment(uint32_t* data, int size, unsigned int mi
             // printf("eventFrag: = 0x%08x\n",eventFrag); fflush(stdout);
             // printf("eventFrag->GetTimeStamp() = %lu\n",eventFrag->GetTimeStamp()); fflush(stdout);
          } else {
-            std::shared_ptr<TFragment> transferfrag = std::make_shared<TFragment>(*eventFrag);
-            Push(fGoodOutputQueues, transferfrag);
+            std::shared_ptr<TFragment> transferfrag = fFragmentPool->Copy(*eventFrag);
+            if(fDeferred) {
+               Defer(EDeferredType::kTigress, transferfrag);
+            } else {
+               Push(fGoodOutputQueues, transferfrag);
+            }
             NumFragsFound++;
             eventFrag = nullptr;
             return NumFragsFound;
@@ -279,34 +380,47 @@ bool TDataParser::SetTIGTriggerID(uint32_t value, const std::shared_ptr<TFragmen
    if((value & 0xf0000000) != 0x80000000) {
       return false;
    }
-   value                            = value & 0x0fffffff;
+   value = value & 0x0fffffff;
+   if(fDeferred) {
+      // the wrap-around depends on the previous midas events, so we leave it to the parser we release to
+      currentFrag->SetTriggerId(static_cast<uint64_t>(value));
+      return true;
+   }
+   currentFrag->SetTriggerId(UnwrapTIGTriggerId(value));
+   return true;
+}
+
+uint64_t TDataParser::UnwrapTIGTriggerId(uint32_t value)
+{
+   /// Calculates the full trigger id from the reported value and the last trigger id.
+   uint64_t     triggerId;
    unsigned int LastTriggerIdHiBits = fLastTriggerId & 0xFF000000; // highest 8 bits, remainder will be
    unsigned int LastTriggerIdLoBits = fLastTriggerId & 0x00FFFFFF; // determined by the reported value
    if(value < fMaxTriggerId / 10) {                                // the trigger id has wrapped around
       if(LastTriggerIdLoBits > fMaxTriggerId * 9 / 10) {
-         currentFrag->SetTriggerId((uint64_t)(LastTriggerIdHiBits + value + fMaxTriggerId));
+         triggerId = (uint64_t)(LastTriggerIdHiBits + value + fMaxTriggerId);
          printf(DBLUE "We are looping new trigger id = %lu, last trigger hi bits = %d,"
                       " last trigger lo bits = %d, value = %d,             midas = %d" RESET_COLOR "\n",
-                currentFrag->GetTriggerId(), LastTriggerIdHiBits, LastTriggerIdLoBits, value, 0); // midasSerialNumber);
+                static_cast<unsigned long>(triggerId), LastTriggerIdHiBits, LastTriggerIdLoBits, value, 0); // midasSerialNumber);
       } else {
-         currentFrag->SetTriggerId(static_cast<uint64_t>(LastTriggerIdHiBits + value));
+         triggerId = static_cast<uint64_t>(LastTriggerIdHiBits + value);
       }
    } else if(value < fMaxTriggerId * 9 / 10) {
-      currentFrag->SetTriggerId(static_cast<uint64_t>(LastTriggerIdHiBits + value));
+      triggerId = static_cast<uint64_t>(LastTriggerIdHiBits + value);
    } else {
       if(LastTriggerIdLoBits < fMaxTriggerId / 10) {
-         currentFrag->SetTriggerId((uint64_t)(LastTriggerIdHiBits + value - fMaxTriggerId));
+         triggerId = (uint64_t)(LastTriggerIdHiBits + value - fMaxTriggerId);
          printf(DRED "We are backwards looping new trigger id = %lu, last trigger hi bits = %d,"
                      " last trigger lo bits = %d, value = %d, midas = %d" RESET_COLOR "\n",
-                currentFrag->GetTriggerId(), LastTriggerIdHiBits, LastTriggerIdLoBits, value, 0); // midasSerialNumber);
+                static_cast<unsigned long>(triggerId), LastTriggerIdHiBits, LastTriggerIdLoBits, value, 0); // midasSerialNumber);
       } else {
-         currentFrag->SetTriggerId(static_cast<uint64_t>(LastTriggerIdHiBits + value));
+         triggerId = static_cast<uint64_t>(LastTriggerIdHiBits + value);
       }
    }
    // fragment_id_map[value]++;
    // currentFrag->FragmentId = fragment_id_map[value];
-   fLastTriggerId = static_cast<unsigned long>(currentFrag->GetTriggerId());
-   return true;
+   fLastTriggerId = static_cast<unsigned long>(triggerId);
+   return triggerId;
 }
 
 bool TDataParser::SetTIGTimeStamp(uint32_t* data, const std::shared_ptr<TFragment>& currentFrag)
@@ -447,7 +561,7 @@ std::vector<TFragment> TDataParser::GriffinDataToFragment(TMidasEvent *event) {
 
    /// Converts a Griffin flavoured MIDAS file into a TFragment and returns the number of words processed (or the
    /// negative index of the word it failed on)
-   std::shared_ptr<TFragment> eventFrag = std::make_shared<TFragment>();
+   std::shared_ptr<TFragment> eventFrag = fFragmentPool->Get();
    //TFragment *eventFrag = new TFragment;
    // no need to delete eventFrag, it's a shared_ptr and gets deleted when it goes out of scope
    fFragmentHasWaveform = false;
@@ -1008,7 +1122,7 @@ int TDataParser::GriffinDataToFragment(uint32_t* data, int size, EBank bank, uns
 {
    /// Converts a Griffin flavoured MIDAS file into a TFragment and returns the number of words processed (or the
    /// negative index of the word it failed on)
-   std::shared_ptr<TFragment> eventFrag = std::make_shared<TFragment>();
+   std::shared_ptr<TFragment> eventFrag = fFragmentPool->Get();
    // no need to delete eventFrag, it's a shared_ptr and gets deleted when it goes out of scope
    fFragmentHasWaveform = false;
    fState               = EDataParserState::kGood;
@@ -1202,10 +1316,13 @@ int TDataParser::GriffinDataToFragment(uint32_t* data, int size, EBank bank, uns
                   throw TDataParserException(fState, failedWord, multipleErrors);
                }
                eventFrag->SetCfd(tmpCfd[0]);
-               if(fRecordDiag) {
+               if(fRecordDiag && !fDeferred) {
                   TParsingDiagnostics::Get()->GoodFragment(eventFrag);
                }
-               fFragmentMap.Add(eventFrag, tmpCharge, tmpIntLength);
+               AddPileUp(eventFrag, tmpCharge, tmpIntLength);
+               if(fDeferred) {
+                  fDeferredEntries.back().fGoodDiagnostics = true;
+               }
                return x;
             }
             if(tmpCharge.size() != tmpIntLength.size() || tmpCharge.size() != tmpCfd.size()) {
@@ -1225,36 +1342,40 @@ int TDataParser::GriffinDataToFragment(uint32_t* data, int size, EBank bank, uns
                eventFrag->SetCharge(tmpCharge[h]);
                eventFrag->SetKValue(tmpIntLength[h]);
                eventFrag->SetCfd(tmpCfd[h]);
-               if(fRecordDiag) {
+               if(fRecordDiag && !fDeferred) {
                   TParsingDiagnostics::Get()->GoodFragment(eventFrag);
                }
                if(fState == EDataParserState::kGood) {
-                  if(fOptions->ReconstructTimeStamp()) {
-                     fLastTimeStampMap[eventFrag->GetAddress()] = eventFrag->GetTimeStamp();
+                  if(fDeferred) {
+                     Defer(EDeferredType::kGood, fFragmentPool->Copy(*eventFrag), fOptions->ReconstructTimeStamp());
+                  } else {
+                     if(fOptions->ReconstructTimeStamp()) {
+                        fLastTimeStampMap[eventFrag->GetAddress()] = eventFrag->GetTimeStamp();
+                     }
+                     Push(fGoodOutputQueues, fFragmentPool->Copy(*eventFrag));
                   }
-                  Push(fGoodOutputQueues, std::make_shared<TFragment>(*eventFrag));
                } else {
                   if(fOptions->ReconstructTimeStamp() && fState == EDataParserState::kBadHighTS && !multipleErrors) {
-                     // std::cout<<"reconstructing timestamp from 0x"<<std::hex<<eventFrag->GetTimeStamp()<<" using
-                     // 0x"<<fLastTimeStampMap[eventFrag->GetAddress()];
                      // reconstruct the high bits of the timestamp from the high bits of the last time stamp of the
-                     // same address
-                     if((eventFrag->GetTimeStamp() & 0x0fffffff) <
-                        (fLastTimeStampMap[eventFrag->GetAddress()] & 0x0fffffff)) {
-                        // we had a wrap-around of the low time stamp, so we need to set the high bits to the old
-                        // high bits plus one
-                        eventFrag->AppendTimeStamp(((fLastTimeStampMap[eventFrag->GetAddress()] >> 28) + 1)<<28);
+                     // same address (on a copy, so the next charge of this fragment starts from the original
+                     // time stamp again)
+                     std::shared_ptr<TFragment> reconstructed = fFragmentPool->Copy(*eventFrag);
+                     if(fDeferred) {
+                        Defer(EDeferredType::kReconstruct, reconstructed);
                      } else {
-                        eventFrag->AppendTimeStamp(fLastTimeStampMap[eventFrag->GetAddress()] & 0x3fff0000000);
+                        ReconstructHighTimeStamp(reconstructed);
+                        Push(fGoodOutputQueues, reconstructed);
                      }
-                     // std::cout<<" => 0x"<<eventFrag->GetTimeStamp()<<std::dec<<std::endl;
-                     Push(fGoodOutputQueues, std::make_shared<TFragment>(*eventFrag));
                   } else {
                      // std::cout<<"Can't reconstruct time stamp, "<<fOptions->ReconstructTimeStamp()<<",
                      // state "<<fState<<" = "<<EDataParserState::kBadHighTS<<", "<<multipleErrors<<std::endl;
                      Push(*fBadOutputQueue, std::make_shared<TBadFragment>(*eventFrag, data, size, failedWord, multipleErrors));
                   }
                }
+               if(fDeferred) {
+                  // each of the cases above deferred exactly one entry for this fragment
+                  fDeferredEntries.back().fGoodDiagnostics = true;
+               }
             }
             return x;
          } else {
@@ -1759,7 +1880,15 @@ int TDataParser::GriffinDataToPPGEvent(uint32_t* data, int size, unsigned int, t
       case 0xb0000000: SetPPGHighTimeStamp(value, ppgEvent); break;
       case 0xe0000000:
          // if((value & 0xFFFF) == (ppgEvent->GetNewPPG())){
-         TPPG::Get()->AddData(ppgEvent);
+         if(fDeferred) {
+            TDeferredEntry entry;
+            entry.fType    = EDeferredType::kPPG;
+            entry.fPPGData = std::shared_ptr<TPPGData>(ppgEvent);
+            fDeferredEntries.push_back(entry);
+         } else {
+            TPPG::Get()->AddData(ppgEvent);
+            delete ppgEvent;
+         }
          TParsingDiagnostics::Get()->GoodFragment(-2); // use detector type -2 for PPG
          return x;
          //} else  {
@@ -2063,19 +2192,21 @@ int TDataParser::FifoToFragment(unsigned short*, int, bool, unsigned int, time_t
    return 1;
 }
 
-int TDataParser::FippsToFragment(std::vector<char> data)
+int TDataParser::FippsToFragment(const char* data, size_t size)
 {
-   uint32_t* ptr = reinterpret_cast<uint32_t*>(data.data());
+   /// Parses one chunk of lst data, i.e. size / 16 records of four 32-bit words each.
+   /// The items popped keep counting over all chunks, the input size is the number of
+   /// records left in this chunk.
+   const uint32_t* ptr = reinterpret_cast<const uint32_t*>(data);
 
    int                        totalEventsRead = 0;
-   std::shared_ptr<TFragment> eventFrag       = std::make_shared<TFragment>();
+   std::shared_ptr<TFragment> eventFrag       = fFragmentPool->Get();
    Long64_t                   tmpTimestamp;
    if(fItemsPopped != nullptr && fInputSize != nullptr) {
-      *fItemsPopped = 0;
-      *fInputSize   = data.size() / 16;
+      *fInputSize = size / 16;
    }
 
-   for(size_t i = 0; i + 3 < data.size() / 4; i += 4) {
+   for(size_t i = 0; i + 3 < size / 4; i += 4) {
       if(fItemsPopped != nullptr && fInputSize != nullptr) {
          ++(*fItemsPopped);
          --(*fInputSize);
@@ -2090,14 +2221,14 @@ int TDataParser::FippsToFragment(std::vector<char> data)
          if(fRecordDiag) {
             TParsingDiagnostics::Get()->BadFragment(99);
          }
-         // Push(*fBadOutputQueue, std::make_shared<TBadFragment>(*eventFrag, ptr, data.size() / 4, i + 2, false));
+         // Push(*fBadOutputQueue, std::make_shared<TBadFragment>(*eventFrag, ptr, size / 4, i + 2, false));
          continue;
       }
       eventFrag->SetCharge(static_cast<int32_t>(ptr[i + 2] & 0x7fff));
       if(fRecordDiag) {
          TParsingDiagnostics::Get()->GoodFragment(eventFrag);
       }
-      Push(fGoodOutputQueues, std::make_shared<TFragment>(*eventFrag));
+      Push(fGoodOutputQueues, fFragmentPool->Copy(*eventFrag));
       // std::cout<<totalEventsRead<<": "<<eventFrag->Charge()<<", "<<eventFrag->GetTimeStamp()<<std::endl;
    }
 
@@ -2107,16 +2238,45 @@ int TDataParser::FippsToFragment(std::vector<char> data)
 void TDataParser::Push(std::vector<std::shared_ptr<ThreadsafeQueue<std::shared_ptr<const TFragment>>>>& queues,
                        const std::shared_ptr<TFragment>&                                                frag)
 {
+   if(fDeferred) {
+      Defer(EDeferredType::kGood, frag);
+      return;
+   }
    frag->SetFragmentId(fFragmentIdMap[frag->GetTriggerId()]);
    fFragmentIdMap[frag->GetTriggerId()]++;
    frag->SetEntryNumber();
-   for(const auto& queue : queues) {
-      queue->Push(frag);
+   if(&queues != &fGoodOutputQueues) {
+      for(const auto& queue : queues) {
+         queue->Push(frag);
+      }
+      return;
+   }
+   fGoodBatch.push_back(frag);
+   if(fGoodBatch.size() >= fBatchSize) {
+      Flush();
    }
 }
 
+void TDataParser::Flush()
+{
+   if(fGoodBatch.empty()) {
+      return;
+   }
+   for(const auto& queue : fGoodOutputQueues) {
+      queue->PushN(fGoodBatch);
+   }
+   fGoodBatch.clear();
+}
+
 void TDataParser::Push(ThreadsafeQueue<std::shared_ptr<const TBadFragment>>& queue, const std::shared_ptr<TBadFragment>& frag)
 {
+   if(fDeferred) {
+      TDeferredEntry entry;
+      entry.fType        = EDeferredType::kBad;
+      entry.fBadFragment = frag;
+      fDeferredEntries.push_back(entry);
+      return;
+   }
    frag->SetFragmentId(fFragmentIdMap[frag->GetTriggerId()]);
    fFragmentIdMap[frag->GetTriggerId()]++;
    frag->SetEntryNumber();
@@ -2155,6 +2315,13 @@ int TDataParser::EPIXToScalar(float* data, int size, unsigned int midasSerialNum
       EXfrag->fName.push_back(TEpicsFrag::GetEpicsVariableName(x));
    }
 
-   fScalerOutputQueue->Push(EXfrag);
+   if(fDeferred) {
+      TDeferredEntry entry;
+      entry.fType      = EDeferredType::kEpics;
+      entry.fEpicsFrag = EXfrag;
+      fDeferredEntries.push_back(entry);
+   } else {
+      fScalerOutputQueue->Push(EXfrag);
+   }
    return NumFragsFound;
 }
@@ -2,6 +2,8 @@
 
 #include <iterator>
 
+#include "TGRSIRandom.h"
+
 bool TFragmentMap::fDebug = false;
 
 TFragmentMap::TFragmentMap(
@@ -11,6 +13,14 @@ TFragmentMap::TFragmentMap(
 {
 }
 
+Double_t TFragmentMap::Dither(const std::shared_ptr<TFragment>& frag, Int_t charge, size_t index)
+{
+   /// Returns the charge plus a random number between 0 and 1. The random number only depends on the fragment, the
+   /// charge, and the index of the charge, so the debug output shows the same value that is used.
+   return charge + TGRSIRandom::Uniform(frag->GetAddress(), frag->GetRawTimeStamp(), static_cast<UInt_t>(charge),
+                                        TGRSIRandom::kPileUpCharge + static_cast<UInt_t>(index));
+}
+
 bool TFragmentMap::Add(std::shared_ptr<TFragment> frag, std::vector<Int_t> charge,
                        std::vector<Short_t> integrationLength)
 {
@@ -118,10 +128,10 @@ bool TFragmentMap::Add(std::shared_ptr<TFragment> frag, std::vector<Int_t> charg
       int dropped = -1;
       for(size_t i = 0; i < std::get<1>((*(range.first)).second).size(); ++i) {
          if(k2[i] > 0) {
-            c.push_back((std::get<1>((*(range.first)).second)[i] + gRandom->Uniform()) / k2[i]);
+            c.push_back(Dither(frags[0], std::get<1>((*(range.first)).second)[i], i) / k2[i]);
             if(fDebug) {
                std::cout<<"2, "<<i<<std::hex<<": 0x"<<std::get<1>((*(range.first)).second)[i]<<"/0x"
-                        <<k2[i]<<std::dec<<" = "<<(std::get<1>((*(range.first)).second)[i] + gRandom->Uniform())
+                        <<k2[i]<<std::dec<<" = "<<Dither(frags[0], std::get<1>((*(range.first)).second)[i], i)
                         <<"/"<<k2[i]<<" = "<<c.back()<<std::endl;
             }
          } else {
@@ -182,10 +192,10 @@ bool TFragmentMap::Add(std::shared_ptr<TFragment> frag, std::vector<Int_t> charg
          frags[1]->SetNumberOfPileups(-201);
          break;
       default: // dropped none
-         c.push_back((charge[0] + gRandom->Uniform()) / integrationLength[0]);
+         c.push_back(Dither(frag, charge[0], 0) / integrationLength[0]);
          if(fDebug) {
             std::cout<<std::hex<<"2, -: 0x"<<charge[0]<<"/0x"<<integrationLength[0]<<std::dec<<" = "
-                     <<(charge[0] + gRandom->Uniform())<<"/"<<integrationLength[0]<<" = "<<c.back()
+                     <<Dither(frag, charge[0], 0)<<"/"<<integrationLength[0]<<" = "<<c.back()
                      <<std::endl;
          }
          // all k's are needed squared so we square all elements of k
@@ -232,10 +242,10 @@ bool TFragmentMap::Add(std::shared_ptr<TFragment> frag, std::vector<Int_t> charg
       std::vector<int> dropped;
       for(size_t i = 0; i < std::get<1>((*(range.first)).second).size(); ++i) {
          if(k2[i] > 0) {
-            c.push_back((std::get<1>((*(range.first)).second)[i] + gRandom->Uniform()) / k2[i]);
+            c.push_back(Dither(frags[0], std::get<1>((*(range.first)).second)[i], i) / k2[i]);
             if(fDebug) {
                std::cout<<"3, "<<i<<std::hex<<": 0x"<<std::get<1>((*(range.first)).second)[i]<<"/0x"
-                        <<k2[i]<<std::dec<<" = "<<(std::get<1>((*(range.first)).second)[i] + gRandom->Uniform())
+                        <<k2[i]<<std::dec<<" = "<<Dither(frags[0], std::get<1>((*(range.first)).second)[i], i)
                         <<"/"<<k2[i]<<" = "<<c.back()<<std::endl;
             }
          } else {
@@ -247,11 +257,11 @@ bool TFragmentMap::Add(std::shared_ptr<TFragment> frag, std::vector<Int_t> charg
       }
       for(size_t i = 0; i < std::get<1>((*std::next(range.first)).second).size(); ++i) {
          if(k2[i + situation] > 0) {
-            c.push_back((std::get<1>((*std::next(range.first)).second)[i] + gRandom->Uniform()) / k2[i + situation]);
+            c.push_back(Dither(frags[1], std::get<1>((*std::next(range.first)).second)[i], i) / k2[i + situation]);
             if(fDebug) {
                std::cout<<"3, "<<i + situation<<std::hex<<": 0x"
                         <<std::get<1>((*std::next(range.first)).second)[i]<<"/0x"<<k2[i + situation]<<std::dec
-                        <<" = "<<(std::get<1>((*std::next(range.first)).second)[i] + gRandom->Uniform())<<"/"
+                        <<" = "<<Dither(frags[1], std::get<1>((*std::next(range.first)).second)[i], i)<<"/"
                         <<k2[i + situation]<<" = "<<c.back()<<std::endl;
             }
          } else {
@@ -266,10 +276,10 @@ bool TFragmentMap::Add(std::shared_ptr<TFragment> frag, std::vector<Int_t> charg
       }
       switch(dropped.size()) {
       case 0: // dropped none
-         c.push_back((charge[0] + gRandom->Uniform()) / integrationLength[0]);
+         c.push_back(Dither(frag, charge[0], 0) / integrationLength[0]);
          if(fDebug) {
             std::cout<<std::hex<<"3, -: 0x"<<charge[0]<<"/0x"<<integrationLength[0]<<std::dec<<" = "
-                     <<(charge[0] + gRandom->Uniform())<<"/"<<integrationLength[0]<<" = "<<c.back()
+                     <<Dither(frag, charge[0], 0)<<"/"<<integrationLength[0]<<" = "<<c.back()
                      <<std::endl;
          }
          // all k's are needed squared so we square all elements of k
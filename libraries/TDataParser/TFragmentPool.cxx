@@ -0,0 +1,65 @@
+#include "TFragmentPool.h"
+
+std::shared_ptr<TFragmentPool> TFragmentPool::Create(size_t maxSize)
+{
+   // the fragments handed out keep a reference to the pool, so it has to be owned by a shared pointer
+   return std::shared_ptr<TFragmentPool>(new TFragmentPool(maxSize));
+}
+
+TFragmentPool::TFragmentPool(size_t maxSize) : fMaxSize(maxSize)
+{
+   fFree.reserve(fMaxSize);
+}
+
+TFragmentPool::~TFragmentPool()
+{
+   for(auto* frag : fFree) {
+      delete frag;
+   }
+   for(auto* frag : fReturned) {
+      delete frag;
+   }
+}
+
+TFragment* TFragmentPool::Take()
+{
+   if(fFree.empty()) {
+      std::lock_guard<std::mutex> lock(fReturnMutex);
+      fFree.swap(fReturned);
+   }
+   if(fFree.empty()) {
+      ++fAllocated;
+      return new TFragment;
+   }
+   TFragment* frag = fFree.back();
+   fFree.pop_back();
+   ++fRecycled;
+   return frag;
+}
+
+void TFragmentPool::Return(TFragment* frag)
+{
+   // clearing the fragment here moves the work to the thread releasing it
+   frag->Clear();
+   {
+      std::lock_guard<std::mutex> lock(fReturnMutex);
+      if(fReturned.size() < fMaxSize) {
+         fReturned.push_back(frag);
+         return;
+      }
+   }
+   delete frag;
+}
+
+std::shared_ptr<TFragment> TFragmentPool::Get()
+{
+   std::shared_ptr<TFragmentPool> pool = shared_from_this();
+   return std::shared_ptr<TFragment>(Take(), [pool](TFragment* frag) { pool->Return(frag); });
+}
+
+std::shared_ptr<TFragment> TFragmentPool::Copy(const TFragment& frag)
+{
+   std::shared_ptr<TFragment> result = Get();
+   *result                           = frag;
+   return result;
+}
@@ -9,6 +9,7 @@
 #include "TGRSIOptions.h"
 #include "TChannel.h"
 #include "GValue.h"
+#include "TGRSIRandom.h"
 
 /// \cond CLASSIMP
 ClassImp(TDescantHit)
@@ -140,7 +141,7 @@ Int_t TDescantHit::GetRemainder() const
 
 Double_t TDescantHit::GetTime(const UInt_t&, Option_t*) const
 {
-   Double_t  dTime = GetTimeStamp() * 10. + GetRemainder() + (GetCfd() + gRandom->Uniform()) / 256.;
+   Double_t  dTime = GetTimeStamp() * 10. + GetRemainder() + (GetCfd() + Dither(TGRSIRandom::kTime, GetCfd())) / 256.;
    TChannel* chan  = GetChannel();
    if(chan == nullptr) {
       Error("GetTime", "No TChannel exists for address 0x%08x", GetAddress());
@@ -181,7 +182,7 @@ bool TDescantHit::AnalyzeWaveform()
 {
    bool error = false;
 
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return false; // Error!
    }
    std::vector<Int_t>   baselineCorrections(8, 0);
@@ -241,7 +242,7 @@ Int_t TDescantHit::CalculateCfdAndMonitor(double attenuation, unsigned int delay
    bool    armed      = false;
 
    Int_t cfd = 0;
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return INT_MAX; // Error!
    }
    std::vector<Short_t> smoothedWaveform;
@@ -298,7 +299,7 @@ Int_t TDescantHit::CalculateCfdAndMonitor(double attenuation, unsigned int delay
 std::vector<Short_t> TDescantHit::CalculateSmoothedWaveform(unsigned int halfSmoothingWindow)
 {
 
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return std::vector<Short_t>(); // Error!
    }
 
@@ -318,7 +319,7 @@ std::vector<Short_t> TDescantHit::CalculateCfdMonitor(double attenuation, unsign
                                                       unsigned int halfSmoothingWindow)
 {
 
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return std::vector<Short_t>(); // Error!
    }
    std::vector<Short_t> smoothedWaveform;
@@ -341,7 +342,7 @@ std::vector<Short_t> TDescantHit::CalculateCfdMonitor(double attenuation, unsign
 std::vector<Int_t> TDescantHit::CalculatePartialSum()
 {
 
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return std::vector<Int_t>(); // Error!
    }
 
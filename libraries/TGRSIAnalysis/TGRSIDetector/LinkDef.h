@@ -9,6 +9,9 @@
 //#pragma link C++ class std::vector<Short_t>+;
 
 #pragma link C++ class TGRSIDetectorHit-;
+// version 11 and older stored the waveform as a plain vector, version 12 writes it packed in the streamer
+#pragma read sourceClass="TGRSIDetectorHit" targetClass="TGRSIDetectorHit" version="[-11]" \
+   source="std::vector<Short_t> fWaveform" target="fWaveform" code="{ fWaveform = onfile.fWaveform; }"
 #pragma link C++ class std::vector<TGRSIDetectorHit>+;
 #pragma link C++ class std::vector<TGRSIDetectorHit*>+;
 #pragma link C++ class TGRSIDetector+;
@@ -1,8 +1,13 @@
 #include "TGRSIDetectorHit.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "TClass.h"
+#include "TVirtualStreamerInfo.h"
+#include "TStreamerInfoActions.h"
+
+#include "TGRSIRandom.h"
 
 /// \cond CLASSIMP
 ClassImp(TGRSIDetectorHit)
@@ -12,6 +17,139 @@ TPPG* TGRSIDetectorHit::fPPG = nullptr;
 
 TVector3 TGRSIDetectorHit::fBeamDirection(0, 0, 1);
 
+namespace {
+/// The packed waveform starts with one of these, followed by the number of samples (4 bytes, little endian).
+enum EWaveformEncoding : UChar_t { kRawWaveform = 0, kDeltaWaveform = 1 };
+/// Number of differences that share one bit width.
+const size_t kWaveformBlock = 32;
+/// Largest bit width of a block, the zig-zag encoded difference of two Short_t needs at most 17 bits.
+const int kMaxWaveformWidth = 17;
+
+void AppendBytes(std::vector<UChar_t>& packed, UInt_t value, int bytes)
+{
+   for(int i = 0; i < bytes; ++i) {
+      packed.push_back(static_cast<UChar_t>(value >> (8 * i)));
+   }
+}
+
+UInt_t ReadBytes(const std::vector<UChar_t>& packed, size_t pos, int bytes)
+{
+   UInt_t value = 0;
+   for(int i = 0; i < bytes; ++i) {
+      value |= static_cast<UInt_t>(packed[pos + i]) << (8 * i);
+   }
+   return value;
+}
+
+void EncodeWaveform(const std::vector<Short_t>& waveform, std::vector<UChar_t>& packed)
+{
+   /// Packs the waveform as the first sample followed by the differences between neighbouring samples. The
+   /// differences are zig-zag encoded (so small negative differences become small numbers) and bit-packed in blocks
+   /// of kWaveformBlock, using the bit width of the largest difference in the block. Since the samples of a waveform
+   /// change slowly, this needs a few bits per sample instead of 16. Should this not be smaller (e.g. pure noise),
+   /// the raw samples are stored instead.
+   packed.clear();
+   if(waveform.empty()) {
+      return;
+   }
+   packed.push_back(kDeltaWaveform);
+   AppendBytes(packed, static_cast<UInt_t>(waveform.size()), 4);
+   AppendBytes(packed, static_cast<UShort_t>(waveform[0]), 2);
+   UInt_t differences[kWaveformBlock];
+   for(size_t begin = 1; begin < waveform.size(); begin += kWaveformBlock) {
+      size_t n    = std::min(kWaveformBlock, waveform.size() - begin);
+      UInt_t used = 0;
+      for(size_t i = 0; i < n; ++i) {
+         Int_t difference = static_cast<Int_t>(waveform[begin + i]) - static_cast<Int_t>(waveform[begin + i - 1]);
+         differences[i]   = (static_cast<UInt_t>(difference) << 1) ^ static_cast<UInt_t>(difference >> 31);
+         used |= differences[i];
+      }
+      int width = 0;
+      while((used >> width) != 0) {
+         ++width;
+      }
+      packed.push_back(static_cast<UChar_t>(width));
+      ULong64_t bits  = 0;
+      int       nBits = 0;
+      for(size_t i = 0; i < n; ++i) {
+         bits |= static_cast<ULong64_t>(differences[i]) << nBits;
+         nBits += width;
+         for(; nBits >= 8; nBits -= 8) {
+            packed.push_back(static_cast<UChar_t>(bits));
+            bits >>= 8;
+         }
+      }
+      if(nBits > 0) {
+         packed.push_back(static_cast<UChar_t>(bits));
+      }
+   }
+
+   if(packed.size() >= 5 + 2 * waveform.size()) {
+      packed.resize(5);
+      packed[0] = kRawWaveform;
+      for(auto sample : waveform) {
+         AppendBytes(packed, static_cast<UShort_t>(sample), 2);
+      }
+   }
+}
+
+void DecodeWaveform(const std::vector<UChar_t>& packed, std::vector<Short_t>& waveform)
+{
+   /// Reverses EncodeWaveform, a truncated buffer results in a shorter waveform. A buffer EncodeWaveform can't have
+   /// written (unknown encoding or bit width) results in no waveform at all.
+   waveform.clear();
+   if(packed.size() < 5) {
+      return;
+   }
+   size_t size = ReadBytes(packed, 1, 4);
+   if(packed[0] == kRawWaveform) {
+      size = std::min(size, (packed.size() - 5) / 2);
+      waveform.resize(size);
+      for(size_t i = 0; i < size; ++i) {
+         waveform[i] = static_cast<Short_t>(ReadBytes(packed, 5 + 2 * i, 2));
+      }
+      return;
+   }
+   if(packed[0] != kDeltaWaveform || packed.size() < 7 || size == 0) {
+      return;
+   }
+   // each block takes at least its width byte, so a corrupt size doesn't make us allocate more than that
+   size = std::min(size, 1 + kWaveformBlock * (packed.size() - 7));
+   waveform.resize(size);
+   waveform[0] = static_cast<Short_t>(ReadBytes(packed, 5, 2));
+   size_t pos  = 7;
+   for(size_t begin = 1; begin < size; begin += kWaveformBlock) {
+      size_t n = std::min(kWaveformBlock, size - begin);
+      if(pos >= packed.size()) {
+         waveform.resize(begin);
+         return;
+      }
+      int width = packed[pos++];
+      if(width > kMaxWaveformWidth) {
+         waveform.clear();
+         return;
+      }
+      UInt_t    mask  = (1u << width) - 1;
+      ULong64_t bits  = 0;
+      int       nBits = 0;
+      for(size_t i = 0; i < n; ++i) {
+         for(; nBits < width; nBits += 8) {
+            if(pos >= packed.size()) {
+               waveform.resize(begin + i);
+               return;
+            }
+            bits |= static_cast<ULong64_t>(packed[pos++]) << nBits;
+         }
+         auto zigzag = static_cast<UInt_t>(bits) & mask;
+         bits >>= width;
+         nBits -= width;
+         Int_t difference    = static_cast<Int_t>(zigzag >> 1) ^ -static_cast<Int_t>(zigzag & 1);
+         waveform[begin + i] = static_cast<Short_t>(waveform[begin + i - 1] + difference);
+      }
+   }
+}
+}
+
 TGRSIDetectorHit::TGRSIDetectorHit(const int& Address) : TObject()
 {
    /// Default constructor
@@ -45,12 +183,82 @@ TGRSIDetectorHit::~TGRSIDetectorHit()
 void TGRSIDetectorHit::Streamer(TBuffer& R__b)
 {
    /// Stream an object of class TGRSIDetectorHit.
+   /// The transient flags aren't written, so the write loops can stream hits that are shared with other threads.
+   /// Since version 12 the waveform is written after the other members, packed by EncodeWaveform, within the same
+   /// versioned record (i.e. covered by its byte count). When reading, the packed bytes are only decoded once
+   /// GetWaveform() is called. If WaveformInRecord() is false, an empty waveform is written instead, the waveform
+   /// is then written to a separate branch (see TFragment::SetWaveformBranch).
    if(R__b.IsReading()) {
-      R__b.ReadClassBuffer(TGRSIDetectorHit::Class(), this);
-   } else {
+      UInt_t    start   = 0;
+      UInt_t    count   = 0;
+      Version_t version = R__b.ReadVersion(&start, &count);
+      // for older versions the read rule in LinkDef.h fills fWaveform
+      fWaveform.clear();
+      fPackedWaveform.clear();
+      // no byte count, the record isn't complete before the packed waveform has been read
+      R__b.ReadClassBuffer(TGRSIDetectorHit::Class(), this, version, start, 0);
+      // the object might be re-used, so the calculated values of the previous hit are no longer valid
       fBitflags = 0;
-      R__b.WriteClassBuffer(TGRSIDetectorHit::Class(), this);
+      if(version > 11) {
+         UInt_t size = 0;
+         R__b>>size;
+         fPackedWaveform.resize(size);
+         if(size > 0) {
+            R__b.ReadFastArray(fPackedWaveform.data(), size);
+         }
+      }
+      R__b.CheckByteCount(start, count, TGRSIDetectorHit::Class());
+   } else {
+      // what WriteClassBuffer does, with the packed waveform added before the byte count is set
+      UInt_t count = R__b.WriteVersion(TGRSIDetectorHit::Class(), kTRUE);
+      R__b.ApplySequence(*(TGRSIDetectorHit::Class()->GetStreamerInfo()->GetWriteObjectWiseActions()), this);
+      // a waveform that has been read but never decoded can be written as it is
+      thread_local std::vector<UChar_t> buffer;
+      const std::vector<UChar_t>*       packed = &fPackedWaveform;
+      if(!WaveformInRecord()) {
+         buffer.clear();
+         packed = &buffer;
+      } else if(fPackedWaveform.empty()) {
+         EncodeWaveform(fWaveform, buffer);
+         packed = &buffer;
+      }
+      R__b<<static_cast<UInt_t>(packed->size());
+      if(!packed->empty()) {
+         R__b.WriteFastArray(packed->data(), static_cast<Int_t>(packed->size()));
+      }
+      R__b.SetByteCount(count, kTRUE);
+   }
+}
+
+void TGRSIDetectorHit::SetCharge(const Int_t& temp_charge)
+{
+   /// Sets the charge, adding a random number between 0 and 1 to avoid binning issues.
+   fCharge = temp_charge + Dither(TGRSIRandom::kCharge, temp_charge);
+}
+
+Double_t TGRSIDetectorHit::Dither(UInt_t stream, Int_t value) const
+{
+   /// Returns a random number in [0,1) that only depends on the address and raw time stamp of this hit, the
+   /// value being dithered, and the stream, so it is the same no matter which thread calls this or when.
+   return TGRSIRandom::Uniform(fAddress, fTimeStamp, static_cast<UInt_t>(value), stream);
+}
+
+void TGRSIDetectorHit::GetPackedWaveform(std::vector<UChar_t>& packed) const
+{
+   /// Fills packed with the waveform in the format written by the Streamer, which SetPackedWaveform accepts.
+   if(!fPackedWaveform.empty()) {
+      packed = fPackedWaveform;
+      return;
    }
+   EncodeWaveform(fWaveform, packed);
+}
+
+void TGRSIDetectorHit::UnpackWaveform() const
+{
+   /// Decodes the waveform read by the streamer. Like the other calculated values this changes mutable members, so
+   /// the first call on a hit read from file shouldn't happen from several threads at once.
+   DecodeWaveform(fPackedWaveform, fWaveform);
+   fPackedWaveform.clear();
 }
 
 Double_t TGRSIDetectorHit::GetTime(const UInt_t&, Option_t*) const
@@ -62,19 +270,19 @@ Double_t TGRSIDetectorHit::GetTime(const UInt_t&, Option_t*) const
    TChannel* channel = GetChannel();
    if(channel == nullptr) {
       Error("GetTime", "No TChannel exists for address 0x%08x", GetAddress());
-      return SetTime(10. * (static_cast<Double_t>((GetTimeStamp()) + gRandom->Uniform())));
+      return SetTime(10. * (static_cast<Double_t>((GetTimeStamp()) + Dither(TGRSIRandom::kTime, GetCfd()))));
    }
    switch(channel->GetDigitizerType()) {
       Double_t dTime;
    case TMnemonic::kGRF16:
       dTime = (GetTimeStamp() & (~0x3ffff)) * 10. +
-              (GetCfd() + gRandom->Uniform()) / 1.6; // CFD is in 10/16th of a nanosecond
+              (GetCfd() + Dither(TGRSIRandom::kTime, GetCfd())) / 1.6; // CFD is in 10/16th of a nanosecond
       return SetTime(dTime - 10. * (channel->GetTZero(GetEnergy())));
    case TMnemonic::kGRF4G:
-      dTime = GetTimeStamp() * 10. + (fCfd >> 22) + ((fCfd & 0x3fffff) + gRandom->Uniform()) / 256.;
+      dTime = GetTimeStamp() * 10. + (fCfd >> 22) + ((fCfd & 0x3fffff) + Dither(TGRSIRandom::kTime, fCfd)) / 256.;
       return SetTime(dTime - 10. * (channel->GetTZero(GetEnergy())));
    default:
-      dTime = static_cast<Double_t>((GetTimeStamp()) + gRandom->Uniform());
+      dTime = static_cast<Double_t>((GetTimeStamp()) + Dither(TGRSIRandom::kTime, GetCfd()));
       return SetTime(10. * (dTime - channel->GetTZero(GetEnergy())));
    }
    return 0.;
@@ -145,7 +353,8 @@ void TGRSIDetectorHit::Copy(TObject& rhs) const
 
 void TGRSIDetectorHit::CopyWave(TObject& rhs) const
 {
-   static_cast<TGRSIDetectorHit&>(rhs).fWaveform = fWaveform;
+   static_cast<TGRSIDetectorHit&>(rhs).fWaveform       = fWaveform;
+   static_cast<TGRSIDetectorHit&>(rhs).fPackedWaveform = fPackedWaveform;
 }
 
 void TGRSIDetectorHit::Copy(TObject& rhs, bool copywave) const
@@ -178,6 +387,7 @@ void TGRSIDetectorHit::Clear(Option_t*)
    fAddress = 0xffffffff; // -1
    // fPosition.SetXYZ(0,0,1);  // unit vector along the beam.
    fWaveform.clear(); // reset size to zero.
+   fPackedWaveform.clear();
    fCharge    = 0;
    fKValue    = 0;
    fCfd       = -1;
@@ -134,7 +134,7 @@ bool TSceptarHit::AnalyzeWaveform()
 {
 	// Calculates the cfd time from the waveform
 	bool error = false;
-	if(fWaveform.empty()) {
+	if(GetWaveform()->empty()) {
 		return false; // Error!
 	}
 
@@ -188,7 +188,7 @@ Int_t TSceptarHit::CalculateCfdAndMonitor(double attenuation, unsigned int delay
 
 	std::vector<Short_t> smoothedWaveform;
 
-	if(fWaveform.empty()) {
+	if(GetWaveform()->empty()) {
 		return INT_MAX; // Error!
 	}
 
@@ -237,7 +237,7 @@ std::vector<Short_t> TSceptarHit::CalculateSmoothedWaveform(unsigned int halfsmo
 {
 	// Used when calculating the CFD from the waveform
 
-	if(fWaveform.empty()) {
+	if(GetWaveform()->empty()) {
 		return std::vector<Short_t>(); // Error!
 	}
 
@@ -257,7 +257,7 @@ std::vector<Short_t> TSceptarHit::CalculateCfdMonitor(double attenuation, int de
 {
 	// Used when calculating the CFD from the waveform
 
-	if(fWaveform.empty()) {
+	if(GetWaveform()->empty()) {
 		return std::vector<Short_t>(); // Error!
 	}
 
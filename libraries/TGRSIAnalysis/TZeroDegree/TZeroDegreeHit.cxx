@@ -9,6 +9,7 @@
 #include "TGRSIOptions.h"
 #include "TChannel.h"
 #include "GValue.h"
+#include "TGRSIRandom.h"
 
 /// \cond CLASSIMP
 ClassImp(TZeroDegreeHit)
@@ -91,7 +92,7 @@ Int_t TZeroDegreeHit::GetRemainder() const
 
 Double_t TZeroDegreeHit::GetTime(const UInt_t&, Option_t*) const
 {
-   Double_t  dTime = GetTimeStamp() * 10. + GetRemainder() + (GetCfd() + gRandom->Uniform()) / 256.;
+   Double_t  dTime = GetTimeStamp() * 10. + GetRemainder() + (GetCfd() + Dither(TGRSIRandom::kTime, GetCfd())) / 256.;
    TChannel* chan  = GetChannel();
    if(chan == nullptr) {
       Error("GetTime", "No TChannel exists for address 0x%08x", GetAddress());
@@ -133,7 +134,7 @@ bool TZeroDegreeHit::AnalyzeWaveform()
 {
    /// Calculates the cfd time from the waveform
    bool error = false;
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return false; // Error!
    }
 
@@ -189,7 +190,7 @@ Int_t TZeroDegreeHit::CalculateCfdAndMonitor(double attenuation, unsigned int de
 
    std::vector<Short_t> smoothedWaveform;
 
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return INT_MAX; // Error!
    }
 
@@ -246,7 +247,7 @@ std::vector<Short_t> TZeroDegreeHit::CalculateSmoothedWaveform(unsigned int half
 {
    /// Used when calculating the CFD from the waveform
 
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return std::vector<Short_t>(); // Error!
    }
 
@@ -266,7 +267,7 @@ std::vector<Short_t> TZeroDegreeHit::CalculateCfdMonitor(double attenuation, int
 {
    /// Used when calculating the CFD from the waveform
 
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return std::vector<Short_t>(); // Error!
    }
 
@@ -290,7 +291,7 @@ std::vector<Short_t> TZeroDegreeHit::CalculateCfdMonitor(double attenuation, int
 std::vector<Int_t> TZeroDegreeHit::CalculatePartialSum()
 {
 
-   if(fWaveform.empty()) {
+   if(GetWaveform()->empty()) {
       return std::vector<Int_t>(); // Error!
    }
 
@@ -13,6 +13,10 @@
 //#pragma link C++ class std::vector<UShort_t>+;
 
 #pragma link C++ class TFragment+;
+// version 6 and older stored all trigger ids in a vector
+#pragma read sourceClass="TFragment" targetClass="TFragment" version="[-6]" \
+   source="std::vector<Long_t> fTriggerId" target="fTriggerIds,fNumberOfTriggerIds,fExtraTriggerIds" \
+   code="{ newObj->ClearTriggerIds(); for(auto id : onfile.fTriggerId) { newObj->SetTriggerId(id); } }"
 #pragma link C++ class TBadFragment+;
 
 #pragma link C++ class TEpicsFrag+;
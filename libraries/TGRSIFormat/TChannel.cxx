@@ -10,10 +10,15 @@
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
 
 #include "TFile.h"
 #include "TKey.h"
 
+#include "TGRSIRandom.h"
+
 /*
  * Author:  P.C. Bender, <pcbend@gmail.com>
  *
@@ -33,6 +38,171 @@ std::map<int, TChannel*>* TChannel::fChannelNumberMap = new std::map<int, TChann
 std::string TChannel::fFileName;
 std::string TChannel::fFileData;
 
+namespace {
+/// A frozen copy of fChannelMap for the look-ups in GetChannel, see TChannel::BuildChannelTable.
+/// If the addresses in use span a small enough range, the channels are stored in a dense array
+/// indexed by the address, otherwise in an open addressing hash table. The copies of the channel
+/// map and the channel number map are used by GetChannelMap, GetChannelByNumber, and
+/// FindChannelByName, so they don't read fChannelMap while EndUpdate changes it.
+struct TChannelTable {
+   static const unsigned int kMaxDenseSize = 1 << 20;
+
+   unsigned int                                    fMinAddress{0};
+   std::vector<TChannel*>                          fDense;
+   std::vector<std::pair<unsigned int, TChannel*>> fHashed;
+   unsigned int                                    fShift{32};
+   std::map<unsigned int, TChannel*>               fChannelMap;
+   std::map<int, TChannel*>                        fChannelNumberMap;
+
+   void Build(const std::map<unsigned int, TChannel*>& channelMap)
+   {
+      fDense.clear();
+      fHashed.clear();
+      fChannelMap = channelMap;
+      fChannelNumberMap.clear();
+      for(const auto& iter : channelMap) {
+         fChannelNumberMap.insert(std::make_pair(iter.second->GetNumber(), iter.second));
+      }
+      if(channelMap.empty()) {
+         return;
+      }
+      fMinAddress = channelMap.begin()->first;
+      // 64 bit, so the span of all 32 bit addresses doesn't overflow
+      uint64_t span = static_cast<uint64_t>(channelMap.rbegin()->first) - fMinAddress + 1;
+      if(span <= kMaxDenseSize) {
+         fDense.assign(span, nullptr);
+         for(const auto& iter : channelMap) {
+            fDense[iter.first - fMinAddress] = iter.second;
+         }
+         return;
+      }
+      // at least twice as many slots as channels keeps the probe sequences short
+      unsigned int bits = 1;
+      while((1u << bits) < 2 * channelMap.size()) {
+         ++bits;
+      }
+      fShift = 32 - bits;
+      fHashed.assign(1u << bits, std::make_pair(0u, nullptr));
+      for(const auto& iter : channelMap) {
+         size_t slot = Hash(iter.first);
+         while(fHashed[slot].second != nullptr) {
+            slot = (slot + 1) & (fHashed.size() - 1);
+         }
+         fHashed[slot] = iter;
+      }
+   }
+
+   size_t Hash(unsigned int address) const { return static_cast<uint32_t>(address * 2654435761u) >> fShift; }
+
+   TChannel* Find(unsigned int address) const
+   {
+      if(!fDense.empty()) {
+         unsigned int index = address - fMinAddress;
+         return (index < fDense.size()) ? fDense[index] : nullptr;
+      }
+      if(fHashed.empty()) {
+         return nullptr;
+      }
+      for(size_t slot = Hash(address); fHashed[slot].second != nullptr; slot = (slot + 1) & (fHashed.size() - 1)) {
+         if(fHashed[slot].first == address) {
+            return fHashed[slot].second;
+         }
+      }
+      return nullptr;
+   }
+};
+
+/// The table used by GetChannel, nullptr until TChannel::BuildChannelTable is called. Once it is set, the channels
+/// are only changed via copies that are swapped in by TChannel::EndUpdate, which publishes a new table.
+std::atomic<TChannelTable*> gChannelTable(nullptr);
+/// Counts the updates of the channels, see TChannel::GetGeneration and TChannel::ReaderCheckpoint.
+std::atomic<uint64_t> gChannelGeneration(0);
+/// Serializes all changes of the channel map and the table, locked from TChannel::BeginUpdate to TChannel::EndUpdate.
+std::mutex gChannelMutex;
+/// Copies of the channels this thread is updating, see TChannel::BeginUpdate.
+thread_local std::map<unsigned int, TChannel*>* gStagedChannels = nullptr;
+
+/// A table and the channels replaced by the update that started generation fGeneration.
+struct TRetiredChannels {
+   uint64_t               fGeneration;
+   TChannelTable*         fTable;
+   std::vector<TChannel*> fChannels;
+};
+/// Tables and channels that have been replaced, but might still be used by other threads.
+std::vector<TRetiredChannels> gRetired;
+
+/// The generation a thread has last seen in TChannel::ReaderCheckpoint, the maximum if it doesn't use channels.
+struct TChannelReader {
+   std::atomic<uint64_t> fGeneration{std::numeric_limits<uint64_t>::max()};
+};
+std::mutex                   gReaderMutex;
+std::vector<TChannelReader*> gReaders;
+
+/// Registers the reader of this thread on first use and removes it when the thread ends.
+struct TChannelReaderSlot {
+   TChannelReader* fReader{nullptr};
+
+   TChannelReader* Get()
+   {
+      if(fReader == nullptr) {
+         fReader = new TChannelReader;
+         std::lock_guard<std::mutex> lock(gReaderMutex);
+         gReaders.push_back(fReader);
+      }
+      return fReader;
+   }
+
+   ~TChannelReaderSlot()
+   {
+      if(fReader != nullptr) {
+         std::lock_guard<std::mutex> lock(gReaderMutex);
+         gReaders.erase(std::find(gReaders.begin(), gReaders.end(), fReader));
+         delete fReader;
+      }
+   }
+};
+thread_local TChannelReaderSlot gReaderSlot;
+
+void PublishChannelTable(const std::map<unsigned int, TChannel*>& channelMap, std::vector<TChannel*>& retiredChannels)
+{
+   /// Publishes a new table (if there is one already) and starts a new generation, the old table and the
+   /// retiredChannels are deleted once all readers have seen the new generation. Must be called with
+   /// gChannelMutex locked.
+   TChannelTable* oldTable = nullptr;
+   if(gChannelTable.load(std::memory_order_acquire) != nullptr) {
+      auto* table = new TChannelTable;
+      table->Build(channelMap);
+      oldTable = gChannelTable.exchange(table);
+   }
+   uint64_t generation = ++gChannelGeneration;
+   if(oldTable != nullptr || !retiredChannels.empty()) {
+      gRetired.push_back(TRetiredChannels{generation, oldTable, std::move(retiredChannels)});
+      retiredChannels.clear();
+   }
+   // this thread is done with the old channels (it has been working on the copies)
+   if(gReaderSlot.fReader != nullptr) {
+      gReaderSlot.fReader->fGeneration = generation;
+   }
+
+   uint64_t oldest = generation;
+   {
+      std::lock_guard<std::mutex> lock(gReaderMutex);
+      for(auto* reader : gReaders) {
+         oldest = std::min(oldest, reader->fGeneration.load());
+      }
+   }
+   auto firstKept = std::partition(gRetired.begin(), gRetired.end(),
+                                   [oldest](const TRetiredChannels& retired) { return retired.fGeneration <= oldest; });
+   for(auto it = gRetired.begin(); it != firstKept; ++it) {
+      delete it->fTable;
+      for(auto* chan : it->fChannels) {
+         delete chan;
+      }
+   }
+   gRetired.erase(gRetired.begin(), firstKept);
+}
+}
+
 TChannel::TChannel()
 {
    Clear();
@@ -49,6 +219,7 @@ TChannel::TChannel(const char* tempName)
 TChannel::TChannel(TChannel* chan)
 {
    /// Makes a copy of a the TChannel.
+   Clear();
    SetAddress(chan->GetAddress());
    SetIntegration(chan->GetIntegration());
    SetNumber(chan->GetNumber());
@@ -56,6 +227,7 @@ TChannel::TChannel(TChannel* chan)
    SetUserInfoNumber(chan->GetUserInfoNumber());
    SetName(chan->GetName()); // SetName also sets the mnemonic
    SetDigitizerType(chan->GetDigitizerTypeString());
+   SetTypeName(chan->fTypeName);
 
    SetENGCoefficients(chan->GetENGCoeff());
    SetCFDCoefficients(chan->GetCFDCoeff());
@@ -112,7 +284,18 @@ bool TChannel::CompareChannels(const TChannel& chana, const TChannel& chanb)
 
 void TChannel::DeleteAllChannels()
 {
-   /// Safely deletes fChannelMap and fChannelNumberMap
+   /// Safely deletes fChannelMap and fChannelNumberMap. This also deletes the channels replaced by EndUpdate, so it
+   /// must not be called while other threads are still using the channels.
+   std::lock_guard<std::mutex> lock(gChannelMutex);
+   delete gChannelTable.exchange(nullptr);
+   for(auto& retired : gRetired) {
+      delete retired.fTable;
+      for(auto* chan : retired.fChannels) {
+         delete chan;
+      }
+   }
+   gRetired.clear();
+   ++gChannelGeneration;
    std::map<unsigned int, TChannel*>::iterator iter;
    for(iter = fChannelMap->begin(); iter != fChannelMap->end(); iter++) {
       if(iter->second != nullptr) {
@@ -136,7 +319,15 @@ void TChannel::AddChannel(TChannel* chan, Option_t* opt)
    if(chan == nullptr) {
       return;
    }
-   if(fChannelMap->count(chan->GetAddress()) == 1) { // if this channel exists
+   if(gStagedChannels == nullptr && gChannelTable.load(std::memory_order_acquire) != nullptr) {
+      // the channels are in use, so the change is made to copies that are swapped in at the end
+      BeginUpdate();
+      AddChannel(chan, opt);
+      EndUpdate();
+      return;
+   }
+   std::map<unsigned int, TChannel*>* channelMap = (gStagedChannels != nullptr) ? gStagedChannels : fChannelMap;
+   if(channelMap->count(chan->GetAddress()) == 1) { // if this channel exists
       if(strcmp(opt, "overwrite") == 0) {
          TChannel* oldchan = GetChannel(chan->GetAddress());
          oldchan->OverWriteChannel(chan);
@@ -153,8 +344,9 @@ void TChannel::AddChannel(TChannel* chan, Option_t* opt)
       delete chan;
    } else {
       // We need to update the channel maps to correspond to the new channel that has been added.
-      fChannelMap->insert(std::make_pair(chan->GetAddress(), chan));
-      if((chan->GetNumber() != 0) && (fChannelNumberMap->count(chan->GetNumber()) == 0)) {
+      // The channel number map of staged channels is updated by EndUpdate.
+      channelMap->insert(std::make_pair(chan->GetAddress(), chan));
+      if(gStagedChannels == nullptr && (chan->GetNumber() != 0) && (fChannelNumberMap->count(chan->GetNumber()) == 0)) {
          fChannelNumberMap->insert(std::make_pair(chan->GetNumber(), chan));
       }
    }
@@ -314,8 +506,9 @@ int TChannel::UpdateChannel(TChannel* chan, Option_t*)
 
 TChannel* TChannel::GetDefaultChannel()
 {
-   if(!fChannelMap->empty()) {
-      return fChannelMap->begin()->second;
+   std::map<unsigned int, TChannel*>* channelMap = GetChannelMap();
+   if(!channelMap->empty()) {
+      return channelMap->begin()->second;
    }
    return nullptr;
 }
@@ -343,6 +536,7 @@ void TChannel::Clear(Option_t*)
    SetName("DefaultTChannel");
 
    fENGCoefficients.clear();
+   fENGCompiled    = false;
    fENGChi2        = 0.0;
    fCFDCoefficients.clear();
    fCFDChi2        = 0.0;
@@ -367,19 +561,172 @@ TChannel* TChannel::GetChannel(unsigned int temp_address)
 {
    /// Returns the TChannel at the specified address. If the address doesn't exist, returns an empty gChannel.
 
+   if(gStagedChannels != nullptr) {
+      // this thread is updating the channels, see BeginUpdate
+      auto iter = gStagedChannels->find(temp_address);
+      return (iter != gStagedChannels->end()) ? iter->second : nullptr;
+   }
+   TChannelTable* table = gChannelTable.load(std::memory_order_acquire);
+   if(table != nullptr) {
+      return table->Find(temp_address);
+   }
+
    TChannel* chan = nullptr;
    //    if(temp_address == 0 || temp_address == 0xffffffff) {//default (nullptr) address, return 0;
    //	      return chan;
    //    }
-   if(fChannelMap->count(temp_address) == 1) { // found channel
-      chan = fChannelMap->at(temp_address);
+   auto iter = fChannelMap->find(temp_address);
+   if(iter != fChannelMap->end()) { // found channel
+      chan = iter->second;
    }
    return chan;
 }
 
+void TChannel::BuildChannelTable()
+{
+   /// Builds the table used by GetChannel from fChannelMap, so this should be called once all channels have been
+   /// read (from the ODB, cal files, ...) and before the channels are used by other threads. After this all changes
+   /// made via AddChannel or the cal files are made to copies of the channels (see BeginUpdate) and a new table is
+   /// published with them, so they are safe while other threads look up channels. Changes made directly via
+   /// GetChannelMap() are not, and need this to be called again.
+   std::lock_guard<std::mutex> lock(gChannelMutex);
+   for(auto& iter : *fChannelMap) {
+      iter.second->CompileCalibration();
+   }
+   if(gChannelTable.load(std::memory_order_acquire) == nullptr) {
+      auto* table = new TChannelTable;
+      table->Build(*fChannelMap);
+      gChannelTable.store(table);
+      ++gChannelGeneration;
+      return;
+   }
+   std::vector<TChannel*> noChannels;
+   PublishChannelTable(*fChannelMap, noChannels);
+}
+
+std::map<unsigned int, TChannel*>* TChannel::GetChannelMap()
+{
+   /// Returns the map of all channels by address. While this thread updates the channels (see BeginUpdate), these
+   /// are the copies being updated. Once the table has been built (see BuildChannelTable), this is the copy of the
+   /// map in the current table, which stays valid until this thread passes ReaderCheckpoint, and must not be changed.
+   if(gStagedChannels != nullptr) {
+      return gStagedChannels;
+   }
+   TChannelTable* table = gChannelTable.load(std::memory_order_acquire);
+   if(table != nullptr) {
+      return &table->fChannelMap;
+   }
+   return fChannelMap;
+}
+
+int TChannel::GetNumberOfChannels()
+{
+   return GetChannelMap()->size();
+}
+
+UInt_t TChannel::GetGeneration()
+{
+   /// Returns the number of updates of the channels so far. A pointer to a channel (e.g. the one cached by the
+   /// hits) is only valid as long as the generation hasn't changed.
+   return static_cast<UInt_t>(gChannelGeneration.load(std::memory_order_acquire));
+}
+
+void TChannel::ReaderCheckpoint()
+{
+   /// Tells the channels that this thread is done with all channels (and channel maps) it got so far. Channels and
+   /// tables replaced by EndUpdate are only deleted once all threads that called this have called it again, so
+   /// threads using channels while others update them (like the loops do) have to call this regularly, at a point
+   /// where they don't hold on to any channel.
+   gReaderSlot.Get()->fGeneration = gChannelGeneration.load();
+}
+
+void TChannel::BeginUpdate()
+{
+   /// Starts an update of the channels by this thread. Until EndUpdate is called, GetChannel, AddChannel, and the
+   /// cal file functions called from this thread work on copies of the channels, while all other threads keep
+   /// using the current ones. Updates by other threads wait until EndUpdate.
+   if(gStagedChannels != nullptr) {
+      return;
+   }
+   gChannelMutex.lock();
+   gStagedChannels = new std::map<unsigned int, TChannel*>;
+   for(const auto& iter : *fChannelMap) {
+      auto* chan = new TChannel(iter.second);
+      chan->CompileCalibration();
+      gStagedChannels->insert(std::make_pair(iter.first, chan));
+   }
+}
+
+int TChannel::EndUpdate()
+{
+   /// Finishes the update started by BeginUpdate: the channels that changed (or were added) replace the current
+   /// ones and GetChannel switches to a new table with them. The replaced channels are kept until all threads using
+   /// channels have passed ReaderCheckpoint, since they might still point to them. Returns the number of channels
+   /// that changed.
+   if(gStagedChannels == nullptr) {
+      return 0;
+   }
+   int                    changed = 0;
+   std::vector<TChannel*> retiredChannels;
+   for(auto& iter : *gStagedChannels) {
+      auto current = fChannelMap->find(iter.first);
+      if(current != fChannelMap->end()) {
+         if(current->second->SameSettings(iter.second)) {
+            delete iter.second;
+            continue;
+         }
+         retiredChannels.push_back(current->second);
+      }
+      // the calibration might have been changed after the copy was compiled in BeginUpdate
+      iter.second->CompileCalibration();
+      (*fChannelMap)[iter.first] = iter.second;
+      ++changed;
+   }
+   delete gStagedChannels;
+   gStagedChannels = nullptr;
+   if(changed > 0) {
+      UpdateChannelNumberMap();
+      PublishChannelTable(*fChannelMap, retiredChannels);
+   }
+   gChannelMutex.unlock();
+   return changed;
+}
+
+bool TChannel::SameSettings(const TChannel* chan) const
+{
+   /// Returns true if chan has the same settings and calibrations as this channel.
+   return fAddress == chan->fAddress && fIntegration == chan->fIntegration && fTypeName == chan->fTypeName &&
+          fDigitizerTypeString == chan->fDigitizerTypeString && fNumber == chan->fNumber && fStream == chan->fStream &&
+          fUserInfoNumber == chan->fUserInfoNumber && fUseCalFileInt == chan->fUseCalFileInt &&
+          fTimeOffset == chan->fTimeOffset && strcmp(GetName(), chan->GetName()) == 0 &&
+          GetClassType() == chan->GetClassType() && fENGCoefficients == chan->fENGCoefficients &&
+          fENGChi2 == chan->fENGChi2 && fCFDCoefficients == chan->fCFDCoefficients && fCFDChi2 == chan->fCFDChi2 &&
+          fLEDCoefficients == chan->fLEDCoefficients && fLEDChi2 == chan->fLEDChi2 &&
+          fTIMECoefficients == chan->fTIMECoefficients && fTIMEChi2 == chan->fTIMEChi2 &&
+          fEFFCoefficients == chan->fEFFCoefficients && fEFFChi2 == chan->fEFFChi2 &&
+          fCTCoefficients == chan->fCTCoefficients && fResidualValues == chan->fResidualValues &&
+          fResidualEnergies == chan->fResidualEnergies && fUseResiduals == chan->fUseResiduals &&
+          WaveFormShape.InUse == chan->WaveFormShape.InUse && WaveFormShape.BaseLine == chan->WaveFormShape.BaseLine &&
+          WaveFormShape.TauDecay == chan->WaveFormShape.TauDecay && WaveFormShape.TauRise == chan->WaveFormShape.TauRise;
+}
+
 TChannel* TChannel::GetChannelByNumber(int temp_num)
 {
    /// Returns the TChannel based on the channel number and not the channel address.
+   if(gStagedChannels != nullptr) {
+      // this thread is updating the channels, the number map is only updated by EndUpdate
+      for(const auto& iter : *gStagedChannels) {
+         if(iter.second->GetNumber() == temp_num) {
+            return iter.second;
+         }
+      }
+      return nullptr;
+   }
+   TChannelTable* table = gChannelTable.load(std::memory_order_acquire);
+   if(table != nullptr) {
+      auto iter = table->fChannelNumberMap.find(temp_num);
+      return (iter != table->fChannelNumberMap.end()) ? iter->second : nullptr;
+   }
    //  if(fChannelMap->size() != fChannelNumberMap->size()) {
    // We should just always update this map before we use it
    UpdateChannelNumberMap();
@@ -406,8 +753,9 @@ TChannel* TChannel::FindChannelByName(const char* ccName)
       return chan;
    }
 
+   std::map<unsigned int, TChannel*>*          channelMap = GetChannelMap();
    std::map<unsigned int, TChannel*>::iterator iter;
-   for(iter = fChannelMap->begin(); iter != fChannelMap->end(); iter++) {
+   for(iter = channelMap->begin(); iter != channelMap->end(); iter++) {
       chan                    = iter->second;
       std::string channelName = chan->GetName();
       if(channelName.compare(0, name.length(), name) == 0) {
@@ -423,7 +771,10 @@ TChannel* TChannel::FindChannelByName(const char* ccName)
 void TChannel::UpdateChannelNumberMap()
 {
    /// Updates the fChannelNumberMap based on the entries in the fChannelMap. This should be called before using the
-   /// fChannelNumberMap.
+   /// fChannelNumberMap. While this thread updates copies of the channels (see BeginUpdate), this is left to EndUpdate.
+   if(gStagedChannels != nullptr) {
+      return;
+   }
    std::map<unsigned int, TChannel*>::iterator mapiter;
    fChannelNumberMap->clear(); // This isn't the nicest way to do this but will keep us consistent.
 
@@ -460,6 +811,7 @@ void TChannel::DestroyENGCal()
 {
    /// Erases the ENGCoefficients vector
    fENGCoefficients.clear();
+   fENGCompiled = false;
 }
 
 void TChannel::DestroyCFDCal()
@@ -528,22 +880,31 @@ double TChannel::CalibrateENG(int charge, int temp_int)
    /// bin. This is then taken and divided by the integration parameter. The
    /// polynomial energy calibration formula is then applied to get the calibrated
    /// energy.
+   /// Without a time stamp to key it on, the random number comes from the stream of
+   /// this thread, so the result is not reproducible. Use CalibrateENG(int, int, Long64_t)
+   /// where the time stamp of the charge is known.
    if(charge == 0) {
       return 0.0000;
    }
 
-   // int temp_int = 1; //125.0;
-   if(temp_int == 0) {
-      if(fIntegration != 0) {
-         temp_int = fIntegration; // the 4 is the dis.
-      } else {
-         temp_int = 1;
-      }
+   return CalibrateENG((static_cast<double>(charge) + TGRSIRandom::Uniform(fAddress)) /
+                       static_cast<double>(Integration(temp_int)));
+}
+
+double TChannel::CalibrateENG(int charge, int temp_int, Long64_t timestamp)
+{
+   /// Same as CalibrateENG(int, int), but the random number added to the charge is keyed
+   /// on the address of this channel, the time stamp, and the charge (see TGRSIRandom),
+   /// like the dithering of the hits, so the result does not depend on the thread or the
+   /// order of the calls.
+   if(charge == 0) {
+      return 0.0000;
    }
 
    // We need to add a random number between 0 and 1 before calibrating to avoid
    // binning issues.
-   return CalibrateENG((static_cast<double>(charge) + gRandom->Uniform()) / static_cast<double>(temp_int));
+   return CalibrateENG((static_cast<double>(charge) + Dither(TGRSIRandom::kCharge, timestamp, charge)) /
+                       static_cast<double>(Integration(temp_int)));
 }
 
 double TChannel::CalibrateENG(double charge, int temp_int)
@@ -576,26 +937,127 @@ double TChannel::CalibrateENG(double charge)
    if(fENGCoefficients.empty()) {
       return charge;
    }
-   double cal_chg = fENGCoefficients[0];
-   //ok... griffin is non-linear and this is causing havic in trying to line
-   //things up.  we are now going to take upto 5 energy coefficents where they
-   //go like a_n*x^n except number 5 - it will be a_5x^(1/2);
+   if(!fENGCompiled) {
+      double polynomial[4];
+      double sqrtCoefficient;
+      bool   useSqrt;
+      GetENGPolynomial(polynomial, sqrtCoefficient, useSqrt);
+      double cal_chg = ((polynomial[3] * charge + polynomial[2]) * charge + polynomial[1]) * charge + polynomial[0];
+      return useSqrt ? cal_chg + sqrtCoefficient * std::sqrt(charge) : cal_chg;
+   }
 
+   double cal_chg =
+      ((fENGPolynomial[3] * charge + fENGPolynomial[2]) * charge + fENGPolynomial[1]) * charge + fENGPolynomial[0];
+   if(fENGUseSqrt) {
+      cal_chg += fENGSqrt * std::sqrt(charge);
+   }
+   return cal_chg;
+}
 
-   for(size_t i = 1; i < fENGCoefficients.size(); i++) {
-      if(i==4) {
-        cal_chg += fENGCoefficients[i] * pow((charge), 0.5);
-        break;
+void TChannel::CalibrateENG(const double* charges, double* energies, size_t n)
+{
+   /// Calibrates n charges at once, like CalibrateENG(double) (so without the integration).
+   /// The loops are kept simple so the compiler can vectorize them. charges and energies
+   /// can be the same array.
+   double polynomial[4];
+   double sqrtCoefficient;
+   bool   useSqrt;
+   GetENGPolynomial(polynomial, sqrtCoefficient, useSqrt);
+
+   if(useSqrt) {
+      for(size_t i = 0; i < n; ++i) {
+         double charge = charges[i];
+         energies[i]   = ((polynomial[3] * charge + polynomial[2]) * charge + polynomial[1]) * charge + polynomial[0] +
+                       sqrtCoefficient * std::sqrt(charge);
+      }
+   } else {
+      for(size_t i = 0; i < n; ++i) {
+         double charge = charges[i];
+         energies[i]   = ((polynomial[3] * charge + polynomial[2]) * charge + polynomial[1]) * charge + polynomial[0];
       }
-      cal_chg += fENGCoefficients[i] * pow((charge), i);
    }
-   return cal_chg;
+}
+
+void TChannel::CalibrateENG(const int* charges, const Long64_t* timestamps, double* energies, size_t n, int temp_int)
+{
+   /// Calibrates n integer charges at once, like CalibrateENG(int, int, Long64_t) with the
+   /// time stamps in timestamps.
+   double integration = static_cast<double>(Integration(temp_int));
+
+   for(size_t i = 0; i < n; ++i) {
+      if(charges[i] != 0) {
+         energies[i] =
+            (static_cast<double>(charges[i]) + Dither(TGRSIRandom::kCharge, timestamps[i], charges[i])) / integration;
+      } else {
+         energies[i] = 0.;
+      }
+   }
+   CalibrateENG(energies, energies, n);
+   for(size_t i = 0; i < n; ++i) {
+      if(charges[i] == 0) {
+         energies[i] = 0.;
+      }
+   }
+}
+
+int TChannel::Integration(int temp_int) const
+{
+   /// Returns the integration parameter used to divide the charges, temp_int if it isn't
+   /// zero, otherwise the integration of this channel (or 1 if that isn't set either).
+   if(temp_int != 0) {
+      return temp_int;
+   }
+   if(fIntegration != 0) {
+      return fIntegration;
+   }
+   return 1;
+}
+
+double TChannel::Dither(UInt_t stream, Long64_t timestamp, int value) const
+{
+   /// Returns a random number in [0,1) keyed on the address of this channel, the time stamp,
+   /// and the value, the same way TGRSIDetectorHit::Dither does.
+   return TGRSIRandom::Uniform(fAddress, static_cast<uint64_t>(timestamp), static_cast<uint32_t>(value), stream);
+}
+
+void TChannel::GetENGPolynomial(double* polynomial, double& sqrtCoefficient, bool& useSqrt) const
+{
+   /// Converts fENGCoefficients into four polynomial coefficients for Horner's scheme and the coefficient of
+   /// the square root term.
+   //ok... griffin is non-linear and this is causing havic in trying to line
+   //things up.  we are now going to take upto 5 energy coefficents where they
+   //go like a_n*x^n except number 5 - it will be a_5x^(1/2);
+   for(size_t i = 0; i < 4; ++i) {
+      polynomial[i] = (i < fENGCoefficients.size()) ? fENGCoefficients[i] : 0.;
+   }
+   if(fENGCoefficients.empty()) {
+      // no calibration, return the charge itself
+      polynomial[1] = 1.;
+   }
+   useSqrt         = fENGCoefficients.size() > 4;
+   sqrtCoefficient = useSqrt ? fENGCoefficients[4] : 0.;
+}
+
+void TChannel::CompileCalibration()
+{
+   /// Prepares the energy calibration for fast evaluation. This is done for all channels by
+   /// BuildChannelTable, changing the energy coefficients afterwards switches back to
+   /// evaluating them from fENGCoefficients until this is called again.
+   GetENGPolynomial(fENGPolynomial, fENGSqrt, fENGUseSqrt);
+   fENGCompiled = true;
 }
 
 double TChannel::CalibrateCFD(int cfd)
 {
-   /// Calibrates the CFD properly.
-   return CalibrateCFD(static_cast<double>(cfd) + gRandom->Uniform());
+   /// Calibrates the CFD properly. The random number added to the CFD comes from the
+   /// stream of this thread, use CalibrateCFD(int, Long64_t) for reproducible results.
+   return CalibrateCFD(static_cast<double>(cfd) + TGRSIRandom::Uniform(fAddress));
+}
+
+double TChannel::CalibrateCFD(int cfd, Long64_t timestamp)
+{
+   /// Calibrates the CFD, with the random number keyed on the address, time stamp, and CFD.
+   return CalibrateCFD(static_cast<double>(cfd) + Dither(TGRSIRandom::kCfd, timestamp, cfd));
 }
 
 double TChannel::CalibrateCFD(double cfd)
@@ -606,9 +1068,10 @@ double TChannel::CalibrateCFD(double cfd)
       return cfd;
    }
 
+   // Horner's scheme, starting with the highest order
    double cal_cfd = 0.0;
-   for(size_t i = 0; i < fCFDCoefficients.size(); i++) {
-      cal_cfd += fCFDCoefficients[i] * pow(cfd, i);
+   for(size_t i = fCFDCoefficients.size(); i-- > 0;) {
+      cal_cfd = cal_cfd * cfd + fCFDCoefficients[i];
    }
 
    return cal_cfd;
@@ -616,8 +1079,15 @@ double TChannel::CalibrateCFD(double cfd)
 
 double TChannel::CalibrateLED(int led)
 {
-   /// Calibrates the LED
-   return CalibrateLED(static_cast<double>(led) + gRandom->Uniform());
+   /// Calibrates the LED. The random number added to the LED comes from the stream of
+   /// this thread, use CalibrateLED(int, Long64_t) for reproducible results.
+   return CalibrateLED(static_cast<double>(led) + TGRSIRandom::Uniform(fAddress));
+}
+
+double TChannel::CalibrateLED(int led, Long64_t timestamp)
+{
+   /// Calibrates the LED, with the random number keyed on the address, time stamp, and LED.
+   return CalibrateLED(static_cast<double>(led) + Dither(TGRSIRandom::kLed, timestamp, led));
 }
 
 double TChannel::CalibrateLED(double led)
@@ -628,9 +1098,10 @@ double TChannel::CalibrateLED(double led)
       return led;
    }
 
+   // Horner's scheme, starting with the highest order
    double cal_led = 0.0;
-   for(size_t i = 0; i < fLEDCoefficients.size(); i++) {
-      cal_led += fLEDCoefficients[i] * pow(led, i);
+   for(size_t i = fLEDCoefficients.size(); i-- > 0;) {
+      cal_led = cal_led * led + fLEDCoefficients[i];
    }
    return cal_led;
 }
@@ -1134,7 +1605,10 @@ Int_t TChannel::ReadCalFile(const char* filename)
    infile.read(buffer, length);
 
    int channels_found = ParseInputData(const_cast<const char*>(buffer));
-   SaveToSelf(infilename.c_str());
+   if(gStagedChannels == nullptr) {
+      // WriteCalFile would write the current channels, not the copies this thread is updating
+      SaveToSelf(infilename.c_str());
+   }
    UpdateChannelNumberMap();
    return channels_found;
 }
@@ -1157,6 +1631,13 @@ void TChannel::SaveToSelf(const char* fname)
 
 Int_t TChannel::ParseInputData(const char* inputdata, Option_t* opt)
 {
+   if(gStagedChannels == nullptr && gChannelTable.load(std::memory_order_acquire) != nullptr) {
+      // the channels are in use, so the changes are made to copies that are swapped in at the end
+      BeginUpdate();
+      Int_t channels = ParseInputData(inputdata, opt);
+      EndUpdate();
+      return channels;
+   }
    std::istringstream infile(inputdata);
 
    TChannel* channel = nullptr;
@@ -1,6 +1,7 @@
 #include "TFragment.h"
 #include "TChannel.h"
 #include "TROOT.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -11,6 +12,7 @@ ClassImp(TFragment)
 /// \endcond
 
 Long64_t TFragment::fNumberOfFragments = 0;
+bool     TFragment::fWaveformBranch    = false;
 
 TFragment::TFragment() : TGRSIDetectorHit()
 {
@@ -38,7 +40,9 @@ TFragment::TFragment(const TFragment& rhs) : TGRSIDetectorHit(rhs)
    fDetectorType    = rhs.fDetectorType;
    fNumberOfPileups = rhs.fNumberOfPileups;
 
-   fTriggerId = rhs.fTriggerId;
+   fNumberOfTriggerIds = rhs.fNumberOfTriggerIds;
+   std::copy(rhs.fTriggerIds, rhs.fTriggerIds + kInlineTriggerIds, fTriggerIds);
+   fExtraTriggerIds = rhs.fExtraTriggerIds;
 
    // copy transient data members
    fPPG           = rhs.fPPG;
@@ -48,6 +52,41 @@ TFragment::TFragment(const TFragment& rhs) : TGRSIDetectorHit(rhs)
    fNumberOfWords = rhs.fNumberOfWords;
 }
 
+TFragment& TFragment::operator=(const TFragment& rhs)
+{
+   /// Assignment operator, copies the same members as the copy constructor (used to re-use fragments)
+   if(&rhs == this) {
+      return *this;
+   }
+   rhs.TGRSIDetectorHit::Copy(*this, true);
+   ClearTransients();
+
+   fMidasTimeStamp      = rhs.fMidasTimeStamp;
+   fMidasId             = rhs.fMidasId;
+   fFragmentId          = rhs.fFragmentId;
+   fTriggerBitPattern   = rhs.fTriggerBitPattern;
+   fNetworkPacketNumber = rhs.fNetworkPacketNumber;
+   fChannelId           = rhs.fChannelId;
+   fAcceptedChannelId   = rhs.fAcceptedChannelId;
+
+   fDeadTime        = rhs.fDeadTime;
+   fModuleType      = rhs.fModuleType;
+   fDetectorType    = rhs.fDetectorType;
+   fNumberOfPileups = rhs.fNumberOfPileups;
+
+   fNumberOfTriggerIds = rhs.fNumberOfTriggerIds;
+   std::copy(rhs.fTriggerIds, rhs.fTriggerIds + kInlineTriggerIds, fTriggerIds);
+   fExtraTriggerIds = rhs.fExtraTriggerIds;
+
+   fPPG           = rhs.fPPG;
+   fZc            = rhs.fZc;
+   fCcShort       = rhs.fCcShort;
+   fCcLong        = rhs.fCcLong;
+   fNumberOfWords = rhs.fNumberOfWords;
+
+   return *this;
+}
+
 TFragment::~TFragment()
 {
    /// Default destructor does nothing right now
@@ -71,7 +110,8 @@ void TFragment::Clear(Option_t* opt)
    fDetectorType    = 0;
    fNumberOfPileups = 0;
 
-   fTriggerId.clear();
+   ClearTriggerIds();
+   std::fill(fTriggerIds, fTriggerIds + kInlineTriggerIds, 0);
 
    fPPG           = nullptr;
 	fEntryNumber   = 0;
@@ -163,9 +203,9 @@ void TFragment::Print(Option_t*) const
    strftime(buff, 20, "%b %d %H:%M:%S", timeinfo);
    printf("MidasTimeStamp: %s\n", buff);
    printf("MidasId      %i\n", fMidasId);
-   printf("\tTriggerId[%lu]	  ", fTriggerId.size());
-   for(long x : fTriggerId) {
-      printf("     0x%08lx", x);
+   printf("\tTriggerId[%lu]	  ", GetNumberOfTriggerIds());
+   for(size_t i = 0; i < GetNumberOfTriggerIds(); ++i) {
+      printf("     0x%08lx", GetTriggerId(i));
    }
    printf("\n");
    printf("FragmentId:   %i\n", fFragmentId);
@@ -178,9 +178,10 @@ void TGRSIRunInfo::SetRunInfo(int runnum, int subrunnum)
       SetSubRunNumber(subrunnum);
    }
 
+   std::map<unsigned int, TChannel*>*          channelMap = TChannel::GetChannelMap();
    std::map<unsigned int, TChannel*>::iterator iter;
 
-   for(iter = TChannel::GetChannelMap()->begin(); iter != TChannel::GetChannelMap()->end(); iter++) {
+   for(iter = channelMap->begin(); iter != channelMap->end(); iter++) {
       std::string channelname = iter->second->GetName();
 
       //  detector system type.
@@ -1,6 +1,8 @@
 #include "TPPG.h"
 
 #include <iomanip>
+#include <algorithm>
+#include <mutex>
 #include "TDirectory.h"
 
 #include "TGRSIRunInfo.h"
@@ -12,6 +14,26 @@ ClassImp(TPPG)
 
 TPPG* TPPG::fPPG = nullptr;
 
+/// Flat copy of the PPG map, index 0 is the junk entry at time 0.
+struct TPPGTimeline {
+   size_t                 fVersion;      ///< version of the map this was built from
+   std::vector<ULong64_t> fTimes;        ///< time stamps of the ppg words
+   std::vector<uint16_t>  fStatus;       ///< new status of the ppg words
+   std::vector<size_t>    fPreviousSame; ///< index of the previous word with the same status (0 if there is none)
+   ULong64_t              fCycleLength;  ///< most common time between two words with the same status
+};
+
+namespace {
+std::atomic_size_t gTimelineVersions{0}; // versions are unique over all TPPGs
+std::mutex         gTimelineMutex;
+
+struct TPPGCursor {
+   std::shared_ptr<const TPPGTimeline> fTimeline;
+   size_t                              fIndex{0};
+};
+thread_local TPPGCursor gCursor;
+}
+
 TPPGData::TPPGData()
 {
    Clear();
@@ -136,6 +158,85 @@ void TPPG::AddData(TPPGData* pat)
    fPPGStatusMap->insert(std::make_pair(pat->GetTimeStamp(), new TPPGData(*pat)));
    fCycleLength = 0;
    fNumberOfCycleLengths.clear();
+   InvalidateTimeline();
+}
+
+void TPPG::InvalidateTimeline()
+{
+   /// Needs to be called every time the map changes, the next lookup rebuilds the timeline.
+   fTimelineVersion = ++gTimelineVersions;
+}
+
+std::shared_ptr<const TPPGTimeline> TPPG::BuildTimeline(size_t version) const
+{
+   auto timeline      = std::make_shared<TPPGTimeline>();
+   timeline->fVersion = version;
+   timeline->fTimes.reserve(fPPGStatusMap->size());
+   timeline->fStatus.reserve(fPPGStatusMap->size());
+   for(auto& ppg : *fPPGStatusMap) {
+      timeline->fTimes.push_back(ppg.first);
+      timeline->fStatus.push_back(ppg.second->GetNewPPG());
+   }
+
+   // the junk entry at index 0 never counts as previous status
+   timeline->fPreviousSame.assign(timeline->fTimes.size(), 0);
+   std::map<uint16_t, size_t> lastIndex;
+   std::map<ULong64_t, int>   numberOfCycleLengths;
+   for(size_t i = 1; i < timeline->fTimes.size(); ++i) {
+      auto last = lastIndex.find(timeline->fStatus[i]);
+      if(last != lastIndex.end()) {
+         timeline->fPreviousSame[i] = last->second;
+      }
+      lastIndex[timeline->fStatus[i]] = i;
+      numberOfCycleLengths[timeline->fTimes[i] - timeline->fTimes[timeline->fPreviousSame[i]]]++;
+   }
+
+   timeline->fCycleLength = 0;
+   int counter            = 0;
+   for(auto& numberOfCycleLength : numberOfCycleLengths) {
+      if(numberOfCycleLength.second > counter) {
+         counter                = numberOfCycleLength.second;
+         timeline->fCycleLength = numberOfCycleLength.first;
+      }
+   }
+
+   return timeline;
+}
+
+const TPPGTimeline* TPPG::Timeline() const
+{
+   /// Returns the timeline of the current map, this also points the cursor of this thread at it.
+   size_t version = fTimelineVersion;
+   if(gCursor.fTimeline == nullptr || gCursor.fTimeline->fVersion != version) {
+      std::lock_guard<std::mutex> lock(gTimelineMutex);
+      if(fTimeline == nullptr || fTimeline->fVersion != version) {
+         fTimeline = BuildTimeline(version);
+      }
+      gCursor.fTimeline = fTimeline;
+      gCursor.fIndex    = 0;
+   }
+   return gCursor.fTimeline.get();
+}
+
+size_t TPPG::FindIndex(const TPPGTimeline* timeline, ULong64_t time) const
+{
+   /// Returns the index of the last ppg word at or before "time". Starts from the position of the previous lookup
+   /// of this thread and only falls back to a binary search if the time is before that or far after it.
+   const std::vector<ULong64_t>& times = timeline->fTimes;
+   size_t&                       index = gCursor.fIndex;
+   if(times[index] <= time) {
+      for(int step = 0; step < 4; ++step) {
+         if(index + 1 == times.size() || times[index + 1] > time) {
+            return index;
+         }
+         ++index;
+      }
+      index = std::upper_bound(times.begin() + index, times.end(), time) - times.begin() - 1;
+      return index;
+   }
+   // the junk entry at time 0 makes sure this never goes before the first element
+   index = std::upper_bound(times.begin(), times.begin() + index, time) - times.begin() - 1;
+   return index;
 }
 
 ULong64_t TPPG::GetLastStatusTime(ULong64_t time, ppg_pattern pat, bool exact_flag) const
@@ -149,26 +250,20 @@ ULong64_t TPPG::GetLastStatusTime(ULong64_t time, ppg_pattern pat, bool exact_fl
       return 0;
    }
 
-   auto               curppg_it = --(fPPGStatusMap->upper_bound(time));
-   PPGMap_t::iterator ppg_it;
+   const TPPGTimeline* timeline = Timeline();
+   size_t              current  = FindIndex(timeline, time);
    if(pat == kJunk) {
-      for(ppg_it = curppg_it; ppg_it != fPPGStatusMap->begin(); --ppg_it) {
-         if(curppg_it->second->GetNewPPG() == ppg_it->second->GetNewPPG() && curppg_it != ppg_it) {
-            return ppg_it->first;
+      // the previous word with the same status is already known, index 0 (no previous status) is at time 0
+      return timeline->fTimes[timeline->fPreviousSame[current]];
+   }
+   for(size_t i = current; i > 0; --i) {
+      if(exact_flag) {
+         if(pat == timeline->fStatus[i]) {
+            return timeline->fTimes[i];
          }
-      }
-   } else {
-      for(ppg_it = curppg_it; ppg_it != fPPGStatusMap->begin(); --ppg_it) {
-         if(exact_flag) {
-            if(pat == ppg_it->second->GetNewPPG()) {
-               return ppg_it->first;
-            }
-         } else {
-            //	printf("pat %x, ppg_it->first %lu, ppg_it->second->GetNewPPG()
-            //%x\n",pat,ppg_it->first,ppg_it->second->GetNewPPG());
-            if((pat & ppg_it->second->GetNewPPG()) != 0) {
-               return ppg_it->first;
-            }
+      } else {
+         if((pat & timeline->fStatus[i]) != 0) {
+            return timeline->fTimes[i];
          }
       }
    }
@@ -182,9 +277,8 @@ uint16_t TPPG::GetStatus(ULong64_t time) const
    if(MapIsEmpty()) {
       printf("Empty\n");
    }
-   // The upper_bound and lower_bound functions always return an iterator to the NEXT map element. We back off by one
-   // because we want to know what the last PPG event was.
-   return ((--(fPPGStatusMap->upper_bound(time)))->second->GetNewPPG());
+   const TPPGTimeline* timeline = Timeline();
+   return timeline->fStatus[FindIndex(timeline, time)];
 }
 
 void TPPG::Print(Option_t* opt) const
@@ -422,6 +516,7 @@ bool TPPG::Correct(bool verbose)
             // if they are, we change the status of the one fCycleLength ago to match the current status
             if(it->second->GetNewPPG() == (++prev)->second->GetOldPPG()) {
                (--prev)->second->SetNewPPG(it->second->GetNewPPG());
+               InvalidateTimeline();
             } else if(verbose) {
                printf(DBLUE "PPG at %lld already exist with status 0x%x (current status is 0x%x)." RESET_COLOR "\n",
                       (*it).first - fCycleLength, prev->second->GetNewPPG(), it->second->GetNewPPG());
@@ -437,6 +532,7 @@ bool TPPG::Correct(bool verbose)
             printf("inserting new ppg data at %lld\n", new_data->GetTimeStamp());
          }
          it = fPPGStatusMap->insert(std::make_pair(new_data->GetTimeStamp(), new_data)).first;
+         InvalidateTimeline();
          --it;
       }
    }
@@ -500,6 +596,7 @@ void TPPG::Streamer(TBuffer& R__b)
    if(R__b.IsReading()) {
       R__b.ReadClassBuffer(TPPG::Class(), this);
       fCurrIterator = fPPGStatusMap->begin();
+      InvalidateTimeline();
    } else {
       R__b.WriteClassBuffer(TPPG::Class(), this);
    }
@@ -507,21 +604,21 @@ void TPPG::Streamer(TBuffer& R__b)
 
 ULong64_t TPPG::GetTimeInCycle(ULong64_t real_time)
 {
-   return real_time % GetCycleLength();
+   // the cycle length of the timeline is the same GetCycleLength calculates, unless it was set by hand
+   return real_time % (fCycleLength != 0 ? fCycleLength : Timeline()->fCycleLength);
 }
 
 ULong64_t TPPG::GetCycleNumber(ULong64_t real_time)
 {
-   return real_time / GetCycleLength();
+   return real_time / (fCycleLength != 0 ? fCycleLength : Timeline()->fCycleLength);
 }
 
 ULong64_t TPPG::GetCycleLength()
 {
    if(fCycleLength == 0) {
-      PPGMap_t::iterator ppgit;
-      for(ppgit = MapBegin(); ppgit != MapEnd(); ++ppgit) {
-         ULong64_t diff = ppgit->second->GetTimeStamp() - GetLastStatusTime(ppgit->second->GetTimeStamp());
-         fNumberOfCycleLengths[diff]++;
+      const TPPGTimeline* timeline = Timeline();
+      for(size_t i = 1; i < timeline->fTimes.size(); ++i) {
+         fNumberOfCycleLengths[timeline->fTimes[i] - timeline->fTimes[timeline->fPreviousSame[i]]]++;
       }
       int counter = 0;
       for(auto& fNumberOfCycleLength : fNumberOfCycleLengths) {
@@ -1,11 +1,15 @@
 #include "TParsingDiagnostics.h"
 
 #include <fstream>
+#include <mutex>
 
 #include "TChannel.h"
 
 TParsingDiagnostics* TParsingDiagnostics::fParsingDiagnostics = nullptr;
 
+// the setter functions are called by all unpacking threads
+static std::mutex gDiagnosticsMutex;
+
 TParsingDiagnostics::TParsingDiagnostics() : TObject()
 {
    fIdHist         = nullptr;
@@ -94,9 +98,22 @@ void TParsingDiagnostics::Print(Option_t*) const
    }
 }
 
+void TParsingDiagnostics::GoodFragment(Short_t detType)
+{
+   std::lock_guard<std::mutex> lock(gDiagnosticsMutex);
+   fNumberOfGoodFragments[detType]++;
+}
+
+void TParsingDiagnostics::BadFragment(Short_t detType)
+{
+   std::lock_guard<std::mutex> lock(gDiagnosticsMutex);
+   fNumberOfBadFragments[detType]++;
+}
+
 void TParsingDiagnostics::GoodFragment(const std::shared_ptr<const TFragment>& frag)
 {
    /// increment the counter of good fragments for this detector type and check if any trigger ids have been lost
+   std::lock_guard<std::mutex> lock(gDiagnosticsMutex);
    fNumberOfGoodFragments[frag->GetDetectorType()]++;
 
    Short_t channelNumber = frag->GetChannelNumber();
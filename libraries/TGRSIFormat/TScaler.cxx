@@ -1,7 +1,5 @@
 #include "TScaler.h"
 
-#include <iomanip>
-
 #include "TROOT.h"
 
 /// \cond CLASSIMP
@@ -51,17 +49,14 @@ void TScalerData::Print(Option_t*) const
 TScaler::TScaler(bool loadIntoMap)
 {
    /// This constructor tries to find the "ScalerTree" and uses it (if requested) to load the scaler data into the map.
-   ///\param[in] loadIntoMap Flag telling TScaler to load all scaler data into fScalerMap.
+   ///\param[in] loadIntoMap Flag telling TScaler to load all scaler data into memory (see LoadScalers).
    Clear();
    fTree = static_cast<TTree*>(gROOT->FindObject("ScalerTree"));
    if(fTree != nullptr) {
       fEntries = fTree->GetEntries();
       fTree->SetBranchAddress("TScalerData", &fScalerData);
       if(loadIntoMap) {
-         for(Long64_t entry = 0; entry < fEntries; ++entry) {
-            fTree->GetEntry(entry);
-            fScalerMap[fScalerData->GetAddress()][fScalerData->GetTimeStamp()] = fScalerData->GetScaler();
-         }
+         LoadScalers();
       }
    }
 }
@@ -74,10 +69,7 @@ TScaler::TScaler(TTree* tree, bool loadIntoMap)
       fEntries = fTree->GetEntries();
       fTree->SetBranchAddress("TScalerData", &fScalerData);
       if(loadIntoMap) {
-         for(Long64_t entry = 0; entry < fEntries; ++entry) {
-            fTree->GetEntry(entry);
-            fScalerMap[fScalerData->GetAddress()][fScalerData->GetTimeStamp()] = fScalerData->GetScaler();
-         }
+         LoadScalers();
       }
    }
 }
@@ -100,7 +92,7 @@ TScaler::~TScaler()
    fPPG = nullptr;
    fHist.clear();
    fHistRange.clear();
-   fScalerMap.clear();
+   fScalers.clear();
 }
 
 void TScaler::Copy(TObject& obj) const
@@ -113,7 +105,54 @@ void TScaler::Copy(TObject& obj) const
    static_cast<TScaler&>(obj).fNumberOfTimePeriods      = fNumberOfTimePeriods;
    static_cast<TScaler&>(obj).fTotalTimePeriod          = fTotalTimePeriod;
    static_cast<TScaler&>(obj).fTotalNumberOfTimePeriods = fTotalNumberOfTimePeriods;
-   static_cast<TScaler&>(obj).fScalerMap                = fScalerMap;
+   static_cast<TScaler&>(obj).fScalers                  = fScalers;
+}
+
+void TScaler::LoadScalers()
+{
+   /// Reads all scaler data from the tree and stores them as flat arrays for each address. The number of scaler
+   /// values of an address is taken from its first readout. If there are several readouts with the same time
+   /// stamp, the last one is kept.
+   fScalers.clear();
+   if(fTree == nullptr) {
+      return;
+   }
+   for(Long64_t entry = 0; entry < fEntries; ++entry) {
+      fTree->GetEntry(entry);
+      TScalerValues& values = fScalers[fScalerData->GetAddress()];
+      if(values.fTimes.empty()) {
+         values.fWidth = fScalerData->GetScaler().size();
+      }
+      values.fTimes.push_back(fScalerData->GetTimeStamp());
+      for(size_t i = 0; i < values.fWidth; ++i) {
+         values.fValues.push_back(fScalerData->GetScaler(i));
+      }
+   }
+
+   for(auto& addrIt : fScalers) {
+      TScalerValues& values = addrIt.second;
+      std::vector<size_t> order(values.Size());
+      for(size_t i = 0; i < order.size(); ++i) {
+         order[i] = i;
+      }
+      // the readouts should already be in order, so this hardly ever has to move anything
+      std::stable_sort(order.begin(), order.end(),
+                       [&values](size_t a, size_t b) { return values.fTimes[a] < values.fTimes[b]; });
+      TScalerValues sorted;
+      sorted.fWidth = values.fWidth;
+      sorted.fTimes.reserve(values.Size());
+      sorted.fValues.reserve(values.fValues.size());
+      for(size_t i = 0; i < order.size(); ++i) {
+         // a later readout with the same time stamp replaces the earlier one
+         if(i + 1 < order.size() && values.fTimes[order[i + 1]] == values.fTimes[order[i]]) {
+            continue;
+         }
+         sorted.fTimes.push_back(values.fTimes[order[i]]);
+         sorted.fValues.insert(sorted.fValues.end(), values.fValues.begin() + order[i] * values.fWidth,
+                               values.fValues.begin() + (order[i] + 1) * values.fWidth);
+      }
+      values = std::move(sorted);
+   }
 }
 
 std::vector<UInt_t> TScaler::GetScaler(UInt_t address, ULong64_t time) const
@@ -125,19 +164,18 @@ std::vector<UInt_t> TScaler::GetScaler(UInt_t address, ULong64_t time) const
       printf("Empty\n");
       return std::vector<UInt_t>(0);
    }
-   if(!fScalerMap.empty()) {
+   if(!fScalers.empty()) {
       // Check that this address exists
-      if(fScalerMap.find(address) == fScalerMap.end()) {
+      auto addrIt = fScalers.find(address);
+      if(addrIt == fScalers.end()) {
          return std::vector<UInt_t>();
       }
-      auto currIt = fScalerMap.find(address)->second.lower_bound(time);
-      // if the time is after our last entry, we return the last entry
-      if(currIt == fScalerMap.find(address)->second.end()) {
-         return std::prev(fScalerMap.find(address)->second.end())->second;
-      }
-      // The lower_bound function returns an iterator to the NEXT map element or the current map element if the time is
-      // a perfect match.
-      return currIt->second;
+      const TScalerValues& values = addrIt->second;
+      // Find returns the NEXT readout or the current one if the time is a perfect match, if the time is after our last
+      // entry, we return the last entry
+      size_t readout = std::min(values.Find(time), values.Size() - 1);
+      return std::vector<UInt_t>(values.fValues.begin() + readout * values.fWidth,
+                                 values.fValues.begin() + (readout + 1) * values.fWidth);
    }
    // loop through the tree and find the right entry
    for(Long64_t entry = 0; entry < fEntries; ++entry) {
@@ -164,6 +202,14 @@ std::vector<UInt_t> TScaler::GetScaler(UInt_t address, ULong64_t time) const
 
 UInt_t TScaler::GetScaler(UInt_t address, ULong64_t time, size_t index) const
 {
+   /// Returns the "index"th scaler value for address "address" at the time "time", see GetScaler(address, time).
+   if(fTree != nullptr && fEntries != 0 && !fScalers.empty()) {
+      auto addrIt = fScalers.find(address);
+      if(addrIt == fScalers.end()) {
+         return 0;
+      }
+      return addrIt->second.Value(std::min(addrIt->second.Find(time), addrIt->second.Size() - 1), index);
+   }
    std::vector<UInt_t> values = GetScaler(address, time);
    if(index < values.size()) {
       return values[index];
@@ -182,23 +228,24 @@ UInt_t TScaler::GetScalerDifference(UInt_t address, ULong64_t time, size_t index
       printf("Empty\n");
       return 0;
    }
-   if(!fScalerMap.empty()) {
+   if(!fScalers.empty()) {
       // Check that this address exists
-      if(fScalerMap.find(address) == fScalerMap.end()) {
+      auto addrIt = fScalers.find(address);
+      if(addrIt == fScalers.end()) {
          return 0;
       }
-      auto currIt = fScalerMap.find(address)->second.lower_bound(time);
+      const TScalerValues& values  = addrIt->second;
+      size_t               readout = values.Find(time);
       // if the time is after our last entry, we return the last entry divided by the number of entries
-      if(currIt == fScalerMap.find(address)->second.end()) {
-         return std::prev(fScalerMap.find(address)->second.end())->second[index] /
-                fScalerMap.find(address)->second.size();
+      if(readout == values.Size()) {
+         return values.Value(readout - 1, index) / values.Size();
       }
       // if this is the before or at the first scaler, we just return the first scaler
-      if(currIt == fScalerMap.find(address)->second.begin()) {
-         return fScalerMap.find(address)->second.begin()->second[index];
+      if(readout == 0) {
+         return values.Value(0, index);
       }
       // otherwise we return the scaler minus the previous scaler
-      return (currIt->second[index]) - (std::prev(currIt)->second[index]);
+      return values.Value(readout, index) - values.Value(readout - 1, index);
    }
    // loop through the tree and find the right entry
    for(Long64_t entry = 0; entry < fEntries; ++entry) {
@@ -260,7 +307,28 @@ void TScaler::Clear(Option_t*)
       }
    }
    fHistRange.clear();
-   fScalerMap.clear();
+   fScalers.clear();
+}
+
+void TScaler::FillDifferences(TH1D* hist, const TScalerValues& values, size_t index, bool timeInCycle)
+{
+   /// Fills the scaler differences (i.e. current scaler minus last scaler) of one address into the histogram, vs.
+   /// the time in cycle in ms or vs. the time in s.
+   // we have to skip the first data point in case this is a sub-run
+   UInt_t previousValue = 0;
+   for(size_t readout = 0; readout < values.Size(); ++readout) {
+      UInt_t value = values.Value(readout, index);
+      // fill the difference between the current and the next scaler (if we found a previous value and that one is
+      // smaller than the current one)
+      if(previousValue != 0 && previousValue < value) {
+         if(timeInCycle) {
+            hist->Fill(fPPG->GetTimeInCycle(values.fTimes[readout]) / 1e5, value - previousValue);
+         } else {
+            hist->Fill(values.fTimes[readout] / 1e8, value - previousValue);
+         }
+      }
+      previousValue = value;
+   }
 }
 
 TH1D* TScaler::Draw(UInt_t address, size_t index, Option_t* option)
@@ -271,6 +339,9 @@ TH1D* TScaler::Draw(UInt_t address, size_t index, Option_t* option)
       printf("Empty\n");
       return nullptr;
    }
+   if(fScalers.empty()) {
+      LoadScalers();
+   }
 
    // if the address doesn't exist in the histogram map, insert a null pointer
    if(fHist.find(address) == fHist.end()) {
@@ -302,25 +373,10 @@ TH1D* TScaler::Draw(UInt_t address, size_t index, Option_t* option)
                      nofBins, 0., fPPG->GetCycleLength() / 1e5);
          // fHist[address]->ResetBit(kMustCleanup);
       }
-      // we have to skip the first data point in case this is a sub-run
-      // loop over the remaining scaler data for this address
-      UInt_t previousValue = 0;
-      for(Long64_t entry = 0; entry < fEntries; ++entry) {
-         fTree->GetEntry(entry);
-         if(fScalerData->GetAddress() == address) {
-            // fill the difference between the current and the next scaler (if we found a previous value and that one is
-            // smaller than the current one)
-            if(previousValue != 0 && previousValue < fScalerData->GetScaler(index)) {
-               fHist[address]->Fill(fPPG->GetTimeInCycle(fScalerData->GetTimeStamp()) / 1e5,
-                                    fScalerData->GetScaler(index) - previousValue);
-            }
-            previousValue = fScalerData->GetScaler(index);
-         }
-         if(entry % 1000 == 0) {
-            std::cout<<std::setw(3)<<(100 * entry) / fEntries<<" % done\r"<<std::flush;
-         }
+      auto addrIt = fScalers.find(address);
+      if(addrIt != fScalers.end()) {
+         FillDifferences(fHist[address], addrIt->second, index, true);
       }
-      std::cout<<"100 % done\r"<<std::flush;
    }
    // if redraw was part of the original options, remove it from the options passed on
    if(opt_index >= 0) {
@@ -342,6 +398,9 @@ TH1D* TScaler::Draw(UInt_t lowAddress, UInt_t highAddress, size_t index, Option_
       printf("Empty\n");
       return nullptr;
    }
+   if(fScalers.empty()) {
+      LoadScalers();
+   }
 
    // try and find the ppg (if we haven't already done so)
    if(fPPG == nullptr) {
@@ -374,28 +433,10 @@ TH1D* TScaler::Draw(UInt_t lowAddress, UInt_t highAddress, size_t index, Option_
                           static_cast<int>(index), lowAddress, highAddress, fPPG->GetCycleLength() / 1e5 / nofBins),
                      nofBins, 0., fPPG->GetCycleLength() / 1e5);
          // fHistRange[std::make_pair(lowAddress, highAddress)]->ResetBit(kMustCleanup);
-         // we have to skip the first data point in case this is a sub-run
-         // loop over the remaining scaler data for this address
-         std::map<UInt_t, UInt_t> previousValue; // we could make this a vector, since we know there can only be
-                                                 // highAddress-lowAddress+1 different addresses
-         for(Long64_t entry = 0; entry < fEntries; ++entry) {
-            fTree->GetEntry(entry);
-            if(lowAddress <= fScalerData->GetAddress() && fScalerData->GetAddress() <= highAddress) {
-               // fill the difference between the current and the next scaler (if we found a previous value and that one
-               // is smaller than the current one)
-               if(previousValue[fScalerData->GetAddress()] != 0 &&
-                  previousValue[fScalerData->GetAddress()] < fScalerData->GetScaler(index)) {
-                  fHistRange[std::make_pair(lowAddress, highAddress)]->Fill(
-                     fPPG->GetTimeInCycle(fScalerData->GetTimeStamp()) / 1e5,
-                     fScalerData->GetScaler(index) - previousValue[fScalerData->GetAddress()]);
-               }
-               previousValue[fScalerData->GetAddress()] = fScalerData->GetScaler(index);
-            }
-            if(entry % 1000 == 0) {
-               std::cout<<std::setw(3)<<(100 * entry) / fEntries<<" % done\r"<<std::flush;
-            }
+         auto endIt = fScalers.upper_bound(highAddress);
+         for(auto addrIt = fScalers.lower_bound(lowAddress); addrIt != endIt; ++addrIt) {
+            FillDifferences(fHistRange[std::make_pair(lowAddress, highAddress)], addrIt->second, index, true);
          }
-         std::cout<<"100 % done\r"<<std::flush;
       }
       // if "redraw" was part of the original options, remove it from the options passed on
       if(draw_index >= 0) {
@@ -427,27 +468,11 @@ TH1D* TScaler::Draw(UInt_t lowAddress, UInt_t highAddress, size_t index, Option_
       }
       fHist[address]->SetLineColor(address - lowAddress + 1);
    }
-   // now we have all histograms, so we loop through the tree (once) and create all that are in the range
-   std::map<UInt_t, UInt_t> previousValue; // we could make this a vector, since we know there can only be
-                                           // highAddress-lowAddress+1 different addresses
-   for(Long64_t entry = 0; entry < fEntries; ++entry) {
-      fTree->GetEntry(entry);
-      if(lowAddress <= fScalerData->GetAddress() && fScalerData->GetAddress() <= highAddress) {
-         // fill the difference between the current and the next scaler (if we found a previous value and that one is
-         // smaller than the current one)
-         if(previousValue[fScalerData->GetAddress()] != 0 &&
-            previousValue[fScalerData->GetAddress()] < fScalerData->GetScaler(index)) {
-            fHist[fScalerData->GetAddress()]->Fill(fPPG->GetTimeInCycle(fScalerData->GetTimeStamp()) / 1e5,
-                                                   fScalerData->GetScaler(index) -
-                                                      previousValue[fScalerData->GetAddress()]);
-         }
-         previousValue[fScalerData->GetAddress()] = fScalerData->GetScaler(index);
-      }
-      if(entry % 1000 == 0) {
-         std::cout<<std::setw(3)<<(100 * entry) / fEntries<<" % done\r"<<std::flush;
-      }
+   // now we have all histograms, so we fill all addresses that are in the range
+   auto endIt = fScalers.upper_bound(highAddress);
+   for(auto addrIt = fScalers.lower_bound(lowAddress); addrIt != endIt; ++addrIt) {
+      FillDifferences(fHist[addrIt->first], addrIt->second, index, true);
    }
-   std::cout<<"100 % done\r"<<std::flush;
    Double_t max = fHist[lowAddress]->GetMaximum();
    for(UInt_t address = lowAddress + 1; address <= highAddress; ++address) {
       if(max < fHist[address]->GetMaximum()) {
@@ -470,6 +495,9 @@ TH1D* TScaler::DrawRawTimes(UInt_t address, Double_t lowtime, Double_t hightime,
       printf("Empty\n");
       return nullptr;
    }
+   if(fScalers.empty()) {
+      LoadScalers();
+   }
 
    TString opt = option;
    opt.ToLower();
@@ -480,24 +508,10 @@ TH1D* TScaler::DrawRawTimes(UInt_t address, Double_t lowtime, Double_t hightime,
       new TH1D(Form("TScalerHistRaw_%04x", address),
                Form("scaler %d vs time for address 0x%04x; time in [ms]; counts/ ms", static_cast<int>(index), address),
                nofBins, lowtime, hightime);
-   // we have to skip the first data point in case this is a sub-run
-   // loop over the remaining scaler data for this address
-   UInt_t previousValue = 0;
-   for(Long64_t entry = 0; entry < fEntries; ++entry) {
-      fTree->GetEntry(entry);
-      if(fScalerData->GetAddress() == address) {
-         // fill the difference between the current and the next scaler (if we found a previous value and that one is
-         // smaller than the current one)
-         if(previousValue != 0 && previousValue < fScalerData->GetScaler(index)) {
-            scHist->Fill(fScalerData->GetTimeStamp() / 1e8, fScalerData->GetScaler(index) - previousValue);
-         }
-         previousValue = fScalerData->GetScaler(index);
-      }
-      if(entry % 1000 == 0) {
-         std::cout<<std::setw(3)<<(100 * entry) / fEntries<<" % done\r"<<std::flush;
-      }
+   auto addrIt = fScalers.find(address);
+   if(addrIt != fScalers.end()) {
+      FillDifferences(scHist, addrIt->second, index, false);
    }
-   std::cout<<"100 % done\r"<<std::flush;
 
    scHist->Draw(opt);
 
@@ -510,18 +524,18 @@ ULong64_t TScaler::GetTimePeriod(UInt_t address)
    /// that occurs most often.
    /// Returns 0 if the address doesn't exist in the map.
    if(fTimePeriod[address] == 0) {
-      ULong64_t previousValue = 0;
-      for(Long64_t entry = 0; entry < fEntries; ++entry) {
-         fTree->GetEntry(entry);
-         if(fScalerData->GetAddress() == address) {
-            // fill the difference between the current and the next scaler (if we found a previous value and that one is
-            // smaller than the current one)
-            if(previousValue != 0 && previousValue < fScalerData->GetTimeStamp()) {
-               // compare timestamp of current element with that of the previous element
-               ULong64_t diff = fScalerData->GetTimeStamp() - previousValue;
-               fNumberOfTimePeriods[address][diff]++;
-            }
-            previousValue = fScalerData->GetTimeStamp();
+      if(fScalers.empty()) {
+         LoadScalers();
+      }
+      auto addrIt = fScalers.find(address);
+      if(addrIt == fScalers.end()) {
+         return 0;
+      }
+      const std::vector<ULong64_t>& times = addrIt->second.fTimes;
+      for(size_t readout = 1; readout < times.size(); ++readout) {
+         // compare timestamp of current element with that of the previous element
+         if(times[readout - 1] != 0) {
+            fNumberOfTimePeriods[address][times[readout] - times[readout - 1]]++;
          }
       }
       int counter = 0;
@@ -23,11 +23,28 @@ TSortingDiagnostics::~TSortingDiagnostics() = default;
 void TSortingDiagnostics::Copy(TObject& obj) const
 {
    static_cast<TSortingDiagnostics&>(obj).fFragmentsOutOfOrder = fFragmentsOutOfOrder;
+   static_cast<TSortingDiagnostics&>(obj).fSortDepth           = fSortDepth;
+   static_cast<TSortingDiagnostics&>(obj).fMaxSortDepth        = fMaxSortDepth;
+   static_cast<TSortingDiagnostics&>(obj).fMaxLateEntries      = fMaxLateEntries;
+   static_cast<TSortingDiagnostics&>(obj).fMaxLateTime         = fMaxLateTime;
 }
 
 void TSortingDiagnostics::Clear(Option_t*)
 {
    fFragmentsOutOfOrder.clear();
+   fSortDepth      = 0;
+   fMaxSortDepth   = 0;
+   fMaxLateEntries = 0;
+   fMaxLateTime    = 0;
+}
+
+void TSortingDiagnostics::SortDepth(long finalDepth, long maxDepth, long lateEntries, long lateTime)
+{
+   /// Called by the event building loop once it's done.
+   fSortDepth      = finalDepth;
+   fMaxSortDepth   = maxDepth;
+   fMaxLateEntries = lateEntries;
+   fMaxLateTime    = lateTime;
 }
 
 void TSortingDiagnostics::OutOfOrder(long newFragTS, long oldFragTS, long newEntry)
@@ -53,6 +70,10 @@ void TSortingDiagnostics::Print(Option_t* opt) const
    TString option = opt;
    option.ToUpper();
    std::string color;
+   if(fMaxSortDepth > 0) {
+      std::cout<<"Final sort depth was "<<fSortDepth<<" (maximum "<<fMaxSortDepth<<"), latest fragment arrived "
+               <<fMaxLateEntries<<" fragments/"<<fMaxLateTime<<" time stamps late"<<std::endl;
+   }
    if(fFragmentsOutOfOrder.empty()) {
       if(option.EqualTo("ERROR")) {
          color = DGREEN;
@@ -79,5 +100,8 @@ void TSortingDiagnostics::WriteToFile(const char* fileName) const
    statsOut<<std::endl
            <<"Number of fragments out of order = "<<NumberOfFragmentsOutOfOrder()<<std::endl
            <<"Maximum entry difference = "<<fMaxEntryDiff<<std::endl
+           <<"Final sort depth = "<<fSortDepth<<std::endl
+           <<"Maximum sort depth = "<<fMaxSortDepth<<std::endl
+           <<"Maximum lateness = "<<fMaxLateEntries<<" fragments, "<<fMaxLateTime<<" time stamps"<<std::endl
            <<std::endl;
 }
@@ -95,7 +95,24 @@ void TGRSIOptions::Clear(Option_t*)
    fFragmentWriteQueueSize = 10000000;
    fAnalysisWriteQueueSize = 1000000;
 
-   fTimeSortInput = false;
+   fDecompressionThreads = 0;
+   fUnpackingThreads     = 1;
+
+   fWriteMidasIndex    = false;
+   fMidasIndexInterval = 1000;
+
+   fTimeSortInput     = false;
+   fMergeByChannel    = false;
+   fAdaptiveSortDepth = false;
+   fMaxSortDepth      = 2000000;
+
+   fEventBuildingThreads = 1;
+   fSliceWidth           = 100000000;
+   fDetBuildingThreads   = 1;
+   fWriteThreads         = 1;
+
+   fAnalysisBranches.clear();
+   fColumnTree = false;
 
    fSeparateOutOfOrder    = false;
 
@@ -153,8 +170,26 @@ void TGRSIOptions::Print(Option_t*) const
             <<"fFragmentWriteQueueSize: "<<fFragmentWriteQueueSize<<std::endl
             <<"fAnalysisWriteQueueSize: "<<fAnalysisWriteQueueSize<<std::endl
             <<std::endl
+            <<"fDecompressionThreads: "<<fDecompressionThreads<<std::endl
+            <<"fUnpackingThreads: "<<fUnpackingThreads<<std::endl
+            <<"fWriteMidasIndex: "<<fWriteMidasIndex<<std::endl
+            <<"fMidasIndexInterval: "<<fMidasIndexInterval<<std::endl
+            <<std::endl
             <<"fTimeSortInput: "<<fTimeSortInput<<std::endl
             <<"fSortDepth: "<<fSortDepth<<std::endl
+            <<"fMergeByChannel: "<<fMergeByChannel<<std::endl
+            <<"fAdaptiveSortDepth: "<<fAdaptiveSortDepth<<std::endl
+            <<"fMaxSortDepth: "<<fMaxSortDepth<<std::endl
+            <<"fEventBuildingThreads: "<<fEventBuildingThreads<<std::endl
+            <<"fSliceWidth: "<<fSliceWidth<<std::endl
+            <<"fDetBuildingThreads: "<<fDetBuildingThreads<<std::endl
+            <<"fWriteThreads: "<<fWriteThreads<<std::endl
+            <<"fAnalysisBranches: ";
+   for(const auto& branch : fAnalysisBranches) {
+      std::cout<<branch<<" ";
+   }
+   std::cout<<std::endl
+            <<"fColumnTree: "<<fColumnTree<<std::endl
             <<std::endl
             <<"fSeparateOutOfOrder: "<<fSeparateOutOfOrder<<std::endl
             <<std::endl
@@ -221,6 +256,32 @@ void TGRSIOptions::Load(int argc, char** argv)
    parser.option("sort-depth", &fSortDepth, true)
       .description("Number of events to hold when sorting by time/trigger_id")
       .default_value(200000);
+   parser.option("merge-by-channel", &fMergeByChannel, true)
+      .description("Build events by merging the time ordered fragments of each channel instead of sorting all of them")
+      .default_value(false);
+   parser.option("adaptive-sort-depth", &fAdaptiveSortDepth, true)
+      .description("Grow (and shrink) the sort depth to match how far out of order the fragments arrive")
+      .default_value(false);
+   parser.option("max-sort-depth", &fMaxSortDepth, true)
+      .description("Maximum number of events to hold when adapting the sort depth")
+      .default_value(2000000);
+   parser.option("event-building-threads", &fEventBuildingThreads, true)
+      .description("number of threads used to build events (in time slices) when building on timestamps (0 = all cores)")
+      .default_value(1);
+   parser.option("slice-width", &fSliceWidth, true)
+      .description("Width of the time slices (in timestamp units) built by each event building thread")
+      .default_value(100000000);
+   parser.option("det-building-threads", &fDetBuildingThreads, true)
+      .description("number of threads used to build detectors from events (0 = all cores)")
+      .default_value(1);
+   parser.option("write-threads", &fWriteThreads, true)
+      .description("number of threads used to compress the fragment and analysis trees (0 = all cores)")
+      .default_value(1);
+   parser.option("analysis-branches", &fAnalysisBranches, true)
+      .description("detector classes to create analysis tree branches for at the start, in addition to those of the "
+                   "channels");
+   parser.option("column-tree", &fColumnTree, true)
+      .description("also write the hits of the analysis tree as flat columns to the AnalysisColumns tree");
    parser.option("s sort", &fSortRoot, true).description("Attempt to loop through root files.");
 
    parser.option("q quit", &fCloseAfterSort, true).description("Run in batch mode");
@@ -255,6 +316,19 @@ void TGRSIOptions::Load(int argc, char** argv)
    parser.option("analysis-size", &fAnalysisWriteQueueSize, true)
       .description("size of analysis write queue")
       .default_value(1000000);
+   parser.option("decompression-threads", &fDecompressionThreads, true)
+      .description("number of threads used to decompress compressed input files (0 = all cores)")
+      .default_value(0);
+   parser.option("unpacking-threads", &fUnpackingThreads, true)
+      .description("number of threads used to parse midas events (0 = all cores)")
+      .default_value(1);
+   parser.option("write-midas-index", &fWriteMidasIndex, true)
+      .description("write a .mid.idx index next to each uncompressed midas file that is read completely");
+   parser.option("midas-index-interval", &fMidasIndexInterval, true)
+      .description("number of events between entries of the midas index")
+      .default_value(1000);
+   parser.option("input-ring", &fInputRing, true)
+      .description("name of the shared memory ring to read midas events from while they are taken (online sorting)");
 
    parser.option("column-width", &fColumnWidth, true).description("width of one column of status").default_value(20);
    parser.option("status-width", &fStatusWidth, true)
@@ -330,6 +404,10 @@ void TGRSIOptions::Load(int argc, char** argv)
       FileAutoDetect(file);
    }
 
+   if(!fInputRing.empty()) {
+      fIsOnline = true;
+   }
+
 	// read analysis options from input file(s)
 	for(const std::string& file : fInputRootFiles) {
 		fAnalysisOptions->ReadFromFile(file);
@@ -349,7 +427,7 @@ kFileType TGRSIOptions::DetermineFileType(const std::string& filename) const
    size_t      dot_pos = filename.find_last_of('.');
    std::string ext     = filename.substr(dot_pos + 1);
 
-   bool isZipped = (ext == "gz") || (ext == "bz2") || (ext == "zip");
+   bool isZipped = (ext == "gz") || (ext == "bz2") || (ext == "zip") || (ext == "zst");
    if(isZipped) {
       std::string remaining = filename.substr(0, dot_pos);
       ext                   = remaining.substr(remaining.find_last_of('.') + 1);
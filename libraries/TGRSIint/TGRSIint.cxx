@@ -135,6 +135,11 @@ void TGRSIint::ApplyOptions()
       OpenLstFile(lst_file);
    }
 
+   // the online ring goes last, so any files given are sorted first
+   if(!opt->InputRing().empty()) {
+      OpenMidasRing(opt->InputRing());
+   }
+
    SetupPipeline();
 
 
@@ -414,6 +419,21 @@ TLstFile* TGRSIint::OpenLstFile(const std::string& filename)
    return file;
 }
 
+TMidasRing* TGRSIint::OpenMidasRing(const std::string& name)
+{
+   /// Attaches to the shared memory ring an online producer writes midas events to.
+   auto* ring = new TMidasRing;
+   if(!ring->Open(name.c_str())) {
+      std::cerr<<R"(Failed to attach to ring ")"<<name<<R"(": )"<<ring->GetLastError()<<std::endl;
+      delete ring;
+      return nullptr;
+   }
+   fRawFiles.push_back(ring);
+
+   std::cout<<"	attached to ring "<<BLUE<<name<<RESET_COLOR<<std::endl;
+   return ring;
+}
+
 void TGRSIint::SetupPipeline()
 {
    /// Finds all of the files input as well as flags provided and makes all
@@ -437,10 +457,14 @@ void TGRSIint::SetupPipeline()
          std::cerr<<"File not found: "<<filename<<std::endl;
       }
    }
+   if(!opt->InputRing().empty() && (fRawFiles.empty() || dynamic_cast<TMidasRing*>(fRawFiles.back()) == nullptr)) {
+      missing_raw_file = true;
+      std::cerr<<"Ring not available: "<<opt->InputRing()<<std::endl;
+   }
 
    // Which input files do we have
-   bool has_raw_file =
-      (!opt->InputMidasFiles().empty() || !opt->InputLstFiles().empty()) && opt->SortRaw() && !missing_raw_file;
+   bool has_raw_file = (!opt->InputMidasFiles().empty() || !opt->InputLstFiles().empty() || !opt->InputRing().empty()) &&
+                       opt->SortRaw() && !missing_raw_file;
    bool has_input_fragment_tree = gFragment != nullptr; // && opt->SortRoot();
    bool has_input_analysis_tree = gAnalysis != nullptr; // && opt->SortRoot();
 
@@ -475,56 +499,61 @@ void TGRSIint::SetupPipeline()
       (has_input_analysis_tree && (write_analysis_histograms || write_analysis_tree) && !generate_analysis_data);
 
    // Extract the run number and sub run number from whatever we were given
-   int run_number     = 0;
-   int sub_run_number = 0;
+   int run_number          = 0;
+   int sub_run_number      = 0;
+   int last_run_number     = 0;
+   int last_sub_run_number = 0;
    if(read_from_raw) {
-      run_number     = fRawFiles[0]->GetRunNumber();
-      sub_run_number = fRawFiles[0]->GetSubRunNumber();
+      run_number          = fRawFiles[0]->GetRunNumber();
+      sub_run_number      = fRawFiles[0]->GetSubRunNumber();
+      last_run_number     = fRawFiles.back()->GetRunNumber();
+      last_sub_run_number = fRawFiles.back()->GetSubRunNumber();
    } else if(read_from_fragment_tree) {
-      auto run_title = gFragment->GetListOfFiles()->At(0)->GetTitle();
-      run_number     = GetRunNumber(run_title);
-      sub_run_number = GetSubRunNumber(run_title);
+      auto run_title      = gFragment->GetListOfFiles()->At(0)->GetTitle();
+      run_number          = GetRunNumber(run_title);
+      sub_run_number      = GetSubRunNumber(run_title);
+      last_run_number     = run_number;
+      last_sub_run_number = sub_run_number;
    } else if(read_from_analysis_tree) {
-      auto run_title = gAnalysis->GetListOfFiles()->At(0)->GetTitle();
-      run_number     = GetRunNumber(run_title);
-      sub_run_number = GetSubRunNumber(run_title);
+      auto run_title      = gAnalysis->GetListOfFiles()->At(0)->GetTitle();
+      run_number          = GetRunNumber(run_title);
+      sub_run_number      = GetSubRunNumber(run_title);
+      last_run_number     = run_number;
+      last_sub_run_number = sub_run_number;
+   }
+
+   // Build the run part of the output file names, this includes the range of sub runs
+   // if we sort multiple raw files, e.g. 12345_000-012
+   std::string run_suffix;
+   if(sub_run_number == -1) {
+      run_suffix = Form("%05i", run_number);
+   } else if(last_run_number != run_number) {
+      run_suffix = Form("%05i_%03i-%05i_%03i", run_number, sub_run_number, last_run_number, last_sub_run_number);
+   } else if(last_sub_run_number != sub_run_number) {
+      run_suffix = Form("%05i_%03i-%03i", run_number, sub_run_number, last_sub_run_number);
+   } else {
+      run_suffix = Form("%05i_%03i", run_number, sub_run_number);
    }
 
    // Choose output file names for the 4 possible output files
    std::string output_fragment_tree_filename = opt->OutputFragmentFile();
    if(output_fragment_tree_filename.length() == 0) {
-      if(sub_run_number == -1) {
-         output_fragment_tree_filename = Form("fragment%05i.root", run_number);
-      } else {
-         output_fragment_tree_filename = Form("fragment%05i_%03i.root", run_number, sub_run_number);
-      }
+      output_fragment_tree_filename = Form("fragment%s.root", run_suffix.c_str());
    }
 
    std::string output_fragment_hist_filename = opt->OutputFragmentHistogramFile();
    if(output_fragment_hist_filename.length() == 0) {
-      if(sub_run_number == -1) {
-         output_fragment_hist_filename = Form("hist_fragment%05i.root", run_number);
-      } else {
-         output_fragment_hist_filename = Form("hist_fragment%05i_%03i.root", run_number, sub_run_number);
-      }
+      output_fragment_hist_filename = Form("hist_fragment%s.root", run_suffix.c_str());
    }
 
    std::string output_analysis_tree_filename = opt->OutputAnalysisFile();
    if(output_analysis_tree_filename.length() == 0) {
-      if(sub_run_number == -1) {
-         output_analysis_tree_filename = Form("analysis%05i.root", run_number);
-      } else {
-         output_analysis_tree_filename = Form("analysis%05i_%03i.root", run_number, sub_run_number);
-      }
+      output_analysis_tree_filename = Form("analysis%s.root", run_suffix.c_str());
    }
 
    std::string output_analysis_hist_filename = opt->OutputAnalysisHistogramFile();
    if(output_analysis_hist_filename.length() == 0) {
-      if(sub_run_number == -1) {
-         output_analysis_hist_filename = Form("hist_analysis%05i.root", run_number);
-      } else {
-         output_analysis_hist_filename = Form("hist_analysis%05i_%03i.root", run_number, sub_run_number);
-      }
+      output_analysis_hist_filename = Form("hist_analysis%s.root", run_suffix.c_str());
    }
 
    if(read_from_analysis_tree) {
@@ -546,6 +575,16 @@ void TGRSIint::SetupPipeline()
    StoppableThread::ColumnWidth(TGRSIOptions::Get()->ColumnWidth());
    StoppableThread::StatusWidth(TGRSIOptions::Get()->StatusWidth());
 
+   // Compress the output trees on several threads, this has to happen before the trees are created
+   if((write_fragment_tree || write_analysis_tree) && opt->WriteThreads() != 1) {
+#ifdef R__USE_IMT
+      // with implicit multi-threading TTree::Fill compresses the baskets of the branches in parallel
+      ROOT::EnableImplicitMT(opt->WriteThreads() > 0 ? opt->WriteThreads() : 0);
+#else
+      std::cerr<<"ROOT was built without implicit multi-threading, ignoring --write-threads"<<std::endl;
+#endif
+   }
+
    // Different queues that can show up
    std::vector<std::shared_ptr<ThreadsafeQueue<std::shared_ptr<const TFragment>>>>    fragmentQueues;
    std::vector<std::shared_ptr<ThreadsafeQueue<std::shared_ptr<TEpicsFrag>>>>         scalerQueues;
@@ -560,11 +599,11 @@ void TGRSIint::SetupPipeline()
 
    // If needed, read from the raw file
    if(read_from_raw) {
-      if(fRawFiles.size() > 1) {
-         std::cerr<<"I'm going to ignore all but first .mid"<<std::endl;
-      }
-
+      // all raw files are read back-to-back by the same data loop
       dataLoop = TDataLoop::Get("1_input_loop", fRawFiles[0]);
+      for(size_t i = 1; i < fRawFiles.size(); ++i) {
+         dataLoop->AddSource(fRawFiles[i]);
+      }
       dataLoop->SetSelfStopping(self_stopping);
 
       unpackLoop               = TUnpackingLoop::Get("2_unpack_loop");
@@ -637,6 +676,11 @@ void TGRSIint::SetupPipeline()
       TGRSIOptions::AnalysisOptions()->Print();
       eventBuildingLoop = TEventBuildingLoop::Get("5_event_build_loop", event_build_mode);
       eventBuildingLoop->SetSortDepth(opt->SortDepth());
+      eventBuildingLoop->SetMergeByChannel(opt->MergeByChannel());
+      eventBuildingLoop->SetAdaptiveSortDepth(opt->AdaptiveSortDepth());
+      eventBuildingLoop->SetMaxSortDepth(opt->MaxSortDepth());
+      eventBuildingLoop->SetEventBuildingThreads(opt->EventBuildingThreads());
+      eventBuildingLoop->SetSliceWidth(opt->SliceWidth());
       eventBuildingLoop->SetBuildWindow(opt->AnalysisOptions()->BuildWindow());
       if(unpackLoop != nullptr) {
          eventBuildingLoop->InputQueue() = unpackLoop->AddGoodOutputQueue();
@@ -675,6 +719,10 @@ void TGRSIint::SetupPipeline()
       analysisQueues.push_back(loop->InputQueue());
    }
 
+   // all channels have been read (from the ODB, cal files, or the input files), so we can freeze them for the
+   // look-ups during sorting
+   TChannel::BuildChannelTable();
+
    StoppableThread::ResumeAll();
 }
 
@@ -45,7 +45,7 @@ void TFragHistLoop::ClearQueue()
 bool TFragHistLoop::Iteration()
 {
    std::shared_ptr<const TFragment> event;
-   fInputSize = fInputQueue->Pop(event);
+   fInputSize = fInputQueue->Pop(event, 0);
 
    if(event) {
       if(fOutputFile == nullptr) {
@@ -59,7 +59,8 @@ bool TFragHistLoop::Iteration()
    if(fInputQueue->IsFinished()) {
       return false;
    }
-   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+   WakeOn(fInputQueue);
+   WaitForInput();
    return true;
 }
 
@@ -1,4 +1,4 @@
-// TDataLoop.h StoppableThread.h TFragWriteLoop.h TTerminalLoop.h TFragment.h TEventBuildingLoop.h TDetBuildingLoop.h TAnalysisWriteLoop.h
+// TDataLoop.h StoppableThread.h TFragWriteLoop.h TTerminalLoop.h TFragment.h TEventBuildingLoop.h TDetBuildingLoop.h TAnalysisWriteLoop.h TAnalysisColumns.h
 //
 // TDataLoop.h TUnpackingLoop.h TFragmentChainLoop.h StoppableThread.h TFragWriteLoop.h TTerminalLoop.h TFragment.h TEventBuildingLoop.h TDetBuildingLoop.h TAnalysisWriteLoop.h
 
@@ -20,5 +20,6 @@
 #pragma link C++ class TEventBuildingLoop+;
 #pragma link C++ class TDetBuildingLoop+;
 #pragma link C++ class TAnalysisWriteLoop+;
+#pragma link C++ class TAnalysisColumns+;
 
 #endif
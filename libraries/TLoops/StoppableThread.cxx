@@ -8,6 +8,7 @@
 
 #include <TString.h>
 
+#include "TChannel.h"
 #include "TDataLoop.h"
 #include "TFragmentChainLoop.h"
 
@@ -24,7 +25,8 @@ int StoppableThread::GetNThreads()
 }
 
 StoppableThread::StoppableThread(std::string name)
-   : fItemsPopped(0), fInputSize(0), fName(std::move(name)), running(true), paused(true)
+   : fWakeup(std::make_shared<ThreadsafeQueueWakeup>()), fItemsPopped(0), fInputSize(0), fName(std::move(name)),
+     running(true), paused(true)
 {
    // TODO: check if a thread already exists and delete?
    fThreadMap.insert(std::make_pair(fName, this));
@@ -209,6 +211,8 @@ void StoppableThread::Stop()
    paused = false;
    std::cout<<EndStatus();
    paused_wait.notify_one();
+   // don't let the loop wait for input that isn't coming anymore
+   fWakeup->Notify();
 }
 
 bool StoppableThread::IsRunning()
@@ -234,6 +238,8 @@ void StoppableThread::Loop()
       while(paused && running) {
          paused_wait.wait_for(lock, std::chrono::milliseconds(100));
       }
+      // the channels replaced since the last iteration can be deleted once all loops got here
+      TChannel::ReaderCheckpoint();
       bool success = Iteration();
       if(!success) {
          running = false;
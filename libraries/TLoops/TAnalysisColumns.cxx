@@ -0,0 +1,350 @@
+#include "TAnalysisColumns.h"
+
+#include <string>
+
+#include "TBranch.h"
+
+#include "TChannel.h"
+#include "TGRSIDetector.h"
+#include "TGRSIDetectorHit.h"
+
+/// \cond CLASSIMP
+ClassImp(TAnalysisColumns)
+/// \endcond
+
+namespace {
+char LeafType(UInt_t*)
+{
+   return 'i';
+}
+char LeafType(Float_t*)
+{
+   return 'F';
+}
+char LeafType(Short_t*)
+{
+   return 'S';
+}
+char LeafType(Int_t*)
+{
+   return 'I';
+}
+char LeafType(Long64_t*)
+{
+   return 'L';
+}
+char LeafType(Double_t*)
+{
+   return 'D';
+}
+
+/// One column of a detector class, i.e. one branch holding an array of values with one entry per hit.
+template <typename T>
+struct TColumn {
+   std::vector<T> fValues = std::vector<T>(1);
+   TBranch*       fBranch{nullptr};
+   Long64_t       fEntry{-1}; ///< entry currently in fValues when reading
+
+   void Create(TTree* tree, const std::string& prefix, const char* name)
+   {
+      std::string branch = prefix + name;
+      std::string leaves = branch + "[" + prefix + "Multiplicity]/" + LeafType(fValues.data());
+      fBranch            = tree->Branch(branch.c_str(), fValues.data(), leaves.c_str());
+   }
+
+   bool Bind(TTree* tree, const std::string& prefix, const char* name)
+   {
+      fBranch = tree->GetBranch((prefix + name).c_str());
+      return fBranch != nullptr;
+   }
+
+   void Resize(Int_t size)
+   {
+      if(static_cast<size_t>(size) > fValues.size()) {
+         fValues.resize(size);
+      }
+   }
+
+   const T* Load(Long64_t entry, Int_t multiplicity)
+   {
+      if(fBranch == nullptr) {
+         return nullptr;
+      }
+      if(fEntry != entry) {
+         Resize(multiplicity);
+         // the vector might have moved, so we always set the address
+         fBranch->SetAddress(fValues.data());
+         fBranch->GetEntry(entry);
+         fEntry = entry;
+      }
+      return fValues.data();
+   }
+};
+}
+
+struct TAnalysisColumns::TDetectorColumns {
+   Int_t    fMultiplicity{0};
+   TBranch* fMultiplicityBranch{nullptr};
+   Long64_t fMultiplicityEntry{-1};
+
+   TColumn<UInt_t>   fAddress;
+   TColumn<Float_t>  fCharge;
+   TColumn<Short_t>  fKValue;
+   TColumn<Int_t>    fCfd;
+   TColumn<Long64_t> fTimeStamp;
+   TColumn<Double_t> fEnergy;
+   TColumn<Double_t> fTime;
+
+   std::unique_ptr<TDetector> fDetector;
+   Long64_t                   fDetectorEntry{-1};
+
+   void Create(TTree* tree, const std::string& prefix)
+   {
+      fMultiplicityBranch = tree->Branch((prefix + "Multiplicity").c_str(), &fMultiplicity,
+                                         (prefix + "Multiplicity/I").c_str());
+      fAddress.Create(tree, prefix, "Address");
+      fCharge.Create(tree, prefix, "Charge");
+      fKValue.Create(tree, prefix, "KValue");
+      fCfd.Create(tree, prefix, "Cfd");
+      fTimeStamp.Create(tree, prefix, "TimeStamp");
+      fEnergy.Create(tree, prefix, "Energy");
+      fTime.Create(tree, prefix, "Time");
+   }
+
+   bool Bind(TTree* tree, const std::string& prefix)
+   {
+      fMultiplicityBranch = tree->GetBranch((prefix + "Multiplicity").c_str());
+      if(fMultiplicityBranch == nullptr) {
+         return false;
+      }
+      fMultiplicityBranch->SetAddress(&fMultiplicity);
+      fAddress.Bind(tree, prefix, "Address");
+      fCharge.Bind(tree, prefix, "Charge");
+      fKValue.Bind(tree, prefix, "KValue");
+      fCfd.Bind(tree, prefix, "Cfd");
+      fTimeStamp.Bind(tree, prefix, "TimeStamp");
+      fEnergy.Bind(tree, prefix, "Energy");
+      fTime.Bind(tree, prefix, "Time");
+      return true;
+   }
+
+   void Resize(Int_t size)
+   {
+      fAddress.Resize(size);
+      fCharge.Resize(size);
+      fKValue.Resize(size);
+      fCfd.Resize(size);
+      fTimeStamp.Resize(size);
+      fEnergy.Resize(size);
+      fTime.Resize(size);
+   }
+
+   void SetAddresses()
+   {
+      fAddress.fBranch->SetAddress(fAddress.fValues.data());
+      fCharge.fBranch->SetAddress(fCharge.fValues.data());
+      fKValue.fBranch->SetAddress(fKValue.fValues.data());
+      fCfd.fBranch->SetAddress(fCfd.fValues.data());
+      fTimeStamp.fBranch->SetAddress(fTimeStamp.fValues.data());
+      fEnergy.fBranch->SetAddress(fEnergy.fValues.data());
+      fTime.fBranch->SetAddress(fTime.fValues.data());
+   }
+
+   void FillBranches()
+   {
+      fMultiplicityBranch->Fill();
+      fAddress.fBranch->Fill();
+      fCharge.fBranch->Fill();
+      fKValue.fBranch->Fill();
+      fCfd.fBranch->Fill();
+      fTimeStamp.fBranch->Fill();
+      fEnergy.fBranch->Fill();
+      fTime.fBranch->Fill();
+   }
+
+   Int_t Multiplicity(Long64_t entry)
+   {
+      // the arrays are read with the length from the multiplicity branch, so this has to be read first
+      if(fMultiplicityEntry != entry) {
+         fMultiplicityBranch->GetEntry(entry);
+         fMultiplicityEntry = entry;
+      }
+      return fMultiplicity;
+   }
+};
+
+TAnalysisColumns::TAnalysisColumns(TTree* tree, bool write) : fTree(tree), fWrite(write), fEntry(0)
+{
+}
+
+TAnalysisColumns::~TAnalysisColumns() = default;
+
+TAnalysisColumns::TDetectorColumns* TAnalysisColumns::Columns(TClass* cls)
+{
+   auto it = fColumns.find(cls);
+   if(it != fColumns.end()) {
+      return it->second.get();
+   }
+   if(fWrite) {
+      return nullptr;
+   }
+   // classes that aren't in the tree are remembered as well, so we only look for their branches once
+   std::unique_ptr<TDetectorColumns> columns(new TDetectorColumns);
+   if(!columns->Bind(fTree, cls->GetName())) {
+      columns.reset();
+   }
+   return (fColumns[cls] = std::move(columns)).get();
+}
+
+void TAnalysisColumns::AddDetector(TClass* cls)
+{
+   /// Creates the columns for this detector class. Like in the analysis tree, the new branches are filled with empty
+   /// entries up to the number of entries the tree already has. Only TGRSIDetector classes have hits that can be
+   /// written as columns, other classes are ignored.
+   if(fColumns.count(cls) != 0u || !cls->InheritsFrom(TGRSIDetector::Class())) {
+      return;
+   }
+   auto* columns = new TDetectorColumns;
+   fColumns[cls].reset(columns);
+   columns->Create(fTree, cls->GetName());
+   Long64_t entries = fTree->GetEntries();
+   for(Long64_t i = 0; i < entries; ++i) {
+      columns->FillBranches();
+   }
+}
+
+void TAnalysisColumns::Fill(const std::vector<std::shared_ptr<TDetector>>& detectors)
+{
+   /// Copies the hits of the detectors into the columns and fills the tree. Classes without a detector in this event
+   /// are written with multiplicity zero. The energies and times have already been calculated when the event was
+   /// built (see TUnpackedEvent::CalculateHits), so this only reads them.
+   for(auto& elem : fColumns) {
+      elem.second->fMultiplicity = 0;
+   }
+   for(const auto& det : detectors) {
+      auto* grsiDet = dynamic_cast<TGRSIDetector*>(det.get());
+      if(grsiDet == nullptr) {
+         continue;
+      }
+      if(fColumns.count(det->IsA()) == 0u) {
+         AddDetector(det->IsA());
+      }
+      TDetectorColumns* columns = Columns(det->IsA());
+      Int_t             size    = grsiDet->GetMultiplicity();
+      columns->Resize(size);
+      for(Int_t i = 0; i < size; ++i) {
+         TGRSIDetectorHit* hit = grsiDet->GetHit(i);
+
+         columns->fAddress.fValues[i]   = hit->GetAddress();
+         columns->fCharge.fValues[i]    = hit->Charge();
+         columns->fKValue.fValues[i]    = hit->GetKValue();
+         columns->fCfd.fValues[i]       = hit->GetCfd();
+         columns->fTimeStamp.fValues[i] = hit->GetRawTimeStamp();
+         columns->fEnergy.fValues[i]    = hit->GetEnergy();
+         columns->fTime.fValues[i]      = hit->GetTime();
+      }
+      columns->fMultiplicity = size;
+   }
+   for(auto& elem : fColumns) {
+      elem.second->SetAddresses();
+   }
+   fTree->Fill();
+}
+
+Int_t TAnalysisColumns::GetMultiplicity(TClass* cls)
+{
+   TDetectorColumns* columns = Columns(cls);
+   return columns == nullptr ? 0 : columns->Multiplicity(fEntry);
+}
+
+const UInt_t* TAnalysisColumns::GetAddress(TClass* cls)
+{
+   TDetectorColumns* columns = Columns(cls);
+   return columns == nullptr ? nullptr : columns->fAddress.Load(fEntry, columns->Multiplicity(fEntry));
+}
+
+const Float_t* TAnalysisColumns::GetCharge(TClass* cls)
+{
+   TDetectorColumns* columns = Columns(cls);
+   return columns == nullptr ? nullptr : columns->fCharge.Load(fEntry, columns->Multiplicity(fEntry));
+}
+
+const Short_t* TAnalysisColumns::GetKValue(TClass* cls)
+{
+   TDetectorColumns* columns = Columns(cls);
+   return columns == nullptr ? nullptr : columns->fKValue.Load(fEntry, columns->Multiplicity(fEntry));
+}
+
+const Int_t* TAnalysisColumns::GetCfd(TClass* cls)
+{
+   TDetectorColumns* columns = Columns(cls);
+   return columns == nullptr ? nullptr : columns->fCfd.Load(fEntry, columns->Multiplicity(fEntry));
+}
+
+const Long64_t* TAnalysisColumns::GetTimeStamp(TClass* cls)
+{
+   TDetectorColumns* columns = Columns(cls);
+   return columns == nullptr ? nullptr : columns->fTimeStamp.Load(fEntry, columns->Multiplicity(fEntry));
+}
+
+const Double_t* TAnalysisColumns::GetEnergy(TClass* cls)
+{
+   TDetectorColumns* columns = Columns(cls);
+   return columns == nullptr ? nullptr : columns->fEnergy.Load(fEntry, columns->Multiplicity(fEntry));
+}
+
+const Double_t* TAnalysisColumns::GetTime(TClass* cls)
+{
+   TDetectorColumns* columns = Columns(cls);
+   return columns == nullptr ? nullptr : columns->fTime.Load(fEntry, columns->Multiplicity(fEntry));
+}
+
+TDetector* TAnalysisColumns::GetDetector(TClass* cls)
+{
+   /// Rebuilds the detector of this class for the current entry from the raw hit values, by passing them as
+   /// fragments to TDetector::AddFragment. Returns nullptr if the tree has no columns for this class.
+   TDetectorColumns* columns = Columns(cls);
+   if(columns == nullptr) {
+      return nullptr;
+   }
+   if(columns->fDetectorEntry == fEntry) {
+      return columns->fDetector.get();
+   }
+   if(columns->fDetector == nullptr) {
+      columns->fDetector.reset(static_cast<TDetector*>(cls->New()));
+   } else {
+      columns->fDetector->Clear();
+   }
+   columns->fDetectorEntry = fEntry;
+
+   Int_t           size      = columns->Multiplicity(fEntry);
+   const UInt_t*   address   = columns->fAddress.Load(fEntry, size);
+   const Float_t*  charge    = columns->fCharge.Load(fEntry, size);
+   const Short_t*  kValue    = columns->fKValue.Load(fEntry, size);
+   const Int_t*    cfd       = columns->fCfd.Load(fEntry, size);
+   const Long64_t* timeStamp = columns->fTimeStamp.Load(fEntry, size);
+   if(address == nullptr || charge == nullptr || kValue == nullptr || cfd == nullptr || timeStamp == nullptr) {
+      return columns->fDetector.get();
+   }
+   for(Int_t i = 0; i < size; ++i) {
+      TChannel* channel = TChannel::GetChannel(address[i]);
+      if(channel == nullptr) {
+         continue;
+      }
+      // re-use the fragment unless a detector kept it
+      if(fFragment.use_count() != 1) {
+         fFragment = std::make_shared<TFragment>();
+      } else {
+         fFragment->Clear();
+      }
+      fFragment->SetAddress(address[i]);
+      fFragment->SetCharge(charge[i]);
+      fFragment->SetKValue(kValue[i]);
+      fFragment->SetCfd(cfd[i]);
+      fFragment->SetTimeStamp(timeStamp[i]);
+      columns->fDetector->AddFragment(fFragment, channel);
+   }
+   columns->fDetector->BuildHits();
+
+   return columns->fDetector.get();
+}
@@ -33,8 +33,8 @@ TAnalysisWriteLoop* TAnalysisWriteLoop::Get(std::string name, std::string output
 }
 
 TAnalysisWriteLoop::TAnalysisWriteLoop(std::string name, std::string output_filename)
-   : StoppableThread(name), fOutputFile(nullptr), fEventTree(nullptr), fOutOfOrderTree(nullptr),
-     fOutOfOrderFrag(nullptr), fInputQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<TUnpackedEvent>>>()),
+   : StoppableThread(name), fOutputFile(nullptr), fEventTree(nullptr), fBranchesAdded(false), fColumnTree(nullptr),
+     fColumns(nullptr), fOutOfOrderTree(nullptr), fOutOfOrderFrag(nullptr), fInputQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<TUnpackedEvent>>>()),
      fOutOfOrderQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<const TFragment>>>())
 {
 
@@ -42,6 +42,10 @@ TAnalysisWriteLoop::TAnalysisWriteLoop(std::string name, std::string output_file
       // TPreserveGDirectory preserve;
       fOutputFile = new TFile(output_filename.c_str(), "RECREATE");
       fEventTree  = new TTree("AnalysisTree", "AnalysisTree");
+      if(TGRSIOptions::Get()->ColumnTree()) {
+         fColumnTree = new TTree("AnalysisColumns", "AnalysisColumns");
+         fColumns    = new TAnalysisColumns(fColumnTree, true);
+      }
       if(TGRSIOptions::Get()->SeparateOutOfOrder()) {
          fOutOfOrderTree = new TTree("OutOfOrderTree", "OutOfOrderTree");
          fOutOfOrderFrag = new TFragment;
@@ -52,11 +56,16 @@ TAnalysisWriteLoop::TAnalysisWriteLoop(std::string name, std::string output_file
 
 TAnalysisWriteLoop::~TAnalysisWriteLoop()
 {
+   // the trees still use the branch addresses and columns until they are written
+   Write();
+
+   delete fColumns;
    for(auto& elem : fDetMap) {
       delete elem.second;
    }
-
-   Write();
+   for(auto& elem : fDefaultDets) {
+      delete elem.second;
+   }
 }
 
 void TAnalysisWriteLoop::ClearQueue()
@@ -83,7 +92,7 @@ std::string TAnalysisWriteLoop::EndStatus()
 bool TAnalysisWriteLoop::Iteration()
 {
    std::shared_ptr<TUnpackedEvent> event;
-   fInputSize = fInputQueue->Pop(event);
+   fInputSize = fInputQueue->Pop(event, 0);
    if(fInputSize < 0) {
       fInputSize = 0;
    }
@@ -93,10 +102,10 @@ bool TAnalysisWriteLoop::Iteration()
       std::shared_ptr<const TFragment> frag;
       fOutOfOrderQueue->Pop(frag, 0);
       if(frag != nullptr) {
-         *fOutOfOrderFrag = *frag;
-         fOutOfOrderFrag->ClearTransients();
+         fOutOfOrderFrag = const_cast<TFragment*>(frag.get());
          std::lock_guard<std::mutex> lock(ttree_fill_mutex);
          fOutOfOrderTree->Fill();
+         fOutOfOrderFrag = nullptr;
       }
    }
 
@@ -107,7 +116,9 @@ bool TAnalysisWriteLoop::Iteration()
    if(fInputQueue->IsFinished()) {
       return false;
    }
-   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+   WakeOn(fInputQueue);
+   WakeOn(fOutOfOrderQueue);
+   WaitForInput();
    return true;
 }
 
@@ -119,6 +130,10 @@ void TAnalysisWriteLoop::Write()
 
       fEventTree->Write(fEventTree->GetName(), TObject::kOverwrite);
 
+      if(fColumnTree != nullptr) {
+         fColumnTree->Write(fColumnTree->GetName(), TObject::kOverwrite);
+      }
+
       if(fOutOfOrderTree != nullptr) {
          fOutOfOrderTree->Write(fOutOfOrderTree->GetName(), TObject::kOverwrite);
       }
@@ -172,52 +187,76 @@ void TAnalysisWriteLoop::AddBranch(TClass* cls)
       //   Therefore, we need to fill the new branch as many times as
       // TTree::Fill has been called before.
       std::lock_guard<std::mutex> lock(ttree_fill_mutex);
-      for(int i = 0; i < fEventTree->GetEntries(); i++) {
+      Long64_t entries = fEventTree->GetEntries();
+      for(Long64_t i = 0; i < entries; i++) {
          new_branch->Fill();
       }
+      if(fColumns != nullptr) {
+         fColumns->AddDetector(cls);
+      }
 
-      std::cout<<"\r"<<std::string(30, ' ')<<"\rAdded \""<<cls->GetName()<<R"(" branch)"<<std::endl;
+      if(entries > 0) {
+         std::cout<<"\r"<<std::string(30, ' ')<<"\rAdded \""<<cls->GetName()<<R"(" branch after )"<<entries
+                  <<" events, use --analysis-branches to create it at the start"<<std::endl;
+      }
 
       // Unlock after we are done.
       TThread::UnLock();
    }
 }
 
+void TAnalysisWriteLoop::AddBranches()
+{
+   /// Creates the branches for the detector classes of all channels and those requested with --analysis-branches.
+   /// This is done when the first event arrives, by then the channels of midas files have been read from the ODB.
+   fBranchesAdded = true;
+   for(const auto& elem : *TChannel::GetChannelMap()) {
+      TClass* cls = elem.second->GetClassType();
+      if(cls != nullptr) {
+         AddBranch(cls);
+      }
+   }
+   for(const auto& name : TGRSIOptions::Get()->AnalysisBranches()) {
+      TClass* cls = TClass::GetClass(name.c_str());
+      if(cls == nullptr || !cls->InheritsFrom(TDetector::Class())) {
+         std::cerr<<"Can't create a branch for \""<<name<<"\", it is not a detector class"<<std::endl;
+         continue;
+      }
+      AddBranch(cls);
+   }
+   std::cout<<"\r"<<std::string(30, ' ')<<"\rCreated "<<fDetMap.size()<<" detector branches"<<std::endl;
+}
+
 void TAnalysisWriteLoop::WriteEvent(TUnpackedEvent& event)
 {
    if(fEventTree != nullptr) {
-      // Clear pointers from previous writes.
+      if(!fBranchesAdded) {
+         AddBranches();
+      }
+      // Point the branches straight at the detectors of the event instead of copying them. The histogram loops
+      // might use the same detectors at the same time, but everything they change (addback and cross-talk flags,
+      // energies, addback hits, ...) is transient, so what's written is the detector as it was built.
+      // The branches of detectors that aren't in this event point to the empty default detector.
       // Note that we cannot just set this equal to nullptr,
       //   because ROOT would then construct a new object.
-      // This contradicts the ROOT documentation for TBranchElement::SetAddress,
-      //   which suggests that a new object would be constructed only when setting the address,
-      //   not when filling the TTree.
-      for(auto& elem : fDetMap) {
-         //*elem.second = fDefaultDets[elem.first];
-         (*elem.second)->Clear();
-      }
-
-      // Load current events
       for(const auto& det : event.GetDetectors()) {
          TClass* cls = det->IsA();
-         try {
-            **fDetMap.at(cls) = *(det.get());
-         } catch(std::out_of_range& e) {
+         if(fDetMap.count(cls) == 0u) {
             AddBranch(cls);
-            **fDetMap.at(cls) = *(det.get());
          }
-         (*fDetMap.at(cls))->ClearTransients();
-         // if(cls == TDescant::Class()) {
-         //	for(int i = 0; i < static_cast<TDescant*>(det)->GetMultiplicity(); ++i) {
-         //		std::cout<<"Descant hit "<<i<<(static_cast<TDescant*>(det)->GetDescantHit(i)->GetDebugData() == nullptr ?
-         //"
-         // has no debug data": " has debug data")<<std::endl;
-         //	}
-         //}
+         *fDetMap.at(cls) = det.get();
       }
 
       // Fill
       std::lock_guard<std::mutex> lock(ttree_fill_mutex);
       fEventTree->Fill();
+      if(fColumns != nullptr) {
+         fColumns->Fill(event.GetDetectors());
+      }
+
+      // the event goes back to its pool once everyone is done with it, so we can't keep pointing at its detectors
+      for(auto& elem : fDetMap) {
+         *elem.second = fDefaultDets[elem.first];
+      }
    }
 }
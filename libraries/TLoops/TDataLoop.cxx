@@ -5,16 +5,19 @@
 #include <utility>
 #include <cstdio>
 #include <sstream>
+#include <functional>
 
 #include "TGRSIOptions.h"
 #include "TString.h"
 #include "TRawFile.h"
 #include "TMidasFile.h"
+#include "TMidasRing.h"
 #include "TChannel.h"
 #include "TGRSIRunInfo.h"
 
 TDataLoop::TDataLoop(std::string name, TRawFile* source)
-   : StoppableThread(name), fSource(source), fSelfStopping(true),
+   : StoppableThread(name), fSource(source), fSelfStopping(true), fSources(1, source), fCurrentSource(0),
+     fBytesDone(0), fOdbHash(0),
      fOutputQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<TRawEvent>>>("midas_queue"))
 #ifdef HAS_XML
      , fOdb(nullptr)
@@ -24,6 +27,10 @@ TDataLoop::TDataLoop(std::string name, TRawFile* source)
    if(midasFile != nullptr) {
       SetFileOdb(midasFile->GetFirstEvent()->GetTimeStamp(), midasFile->GetFirstEvent()->GetData(), midasFile->GetFirstEvent()->GetDataSize());
    }
+   TMidasRing* midasRing = dynamic_cast<TMidasRing*>(source);
+   if(midasRing != nullptr && midasRing->GetFirstEvent()->GetDataSize() > 0) {
+      SetFileOdb(midasRing->GetFirstEvent()->GetTimeStamp(), midasRing->GetFirstEvent()->GetData(), midasRing->GetFirstEvent()->GetDataSize());
+   }
    for(const auto& cal_filename : TGRSIOptions::Get()->CalInputFiles()) {
       TChannel::ReadCalFile(cal_filename.c_str());
    }
@@ -46,9 +53,19 @@ TDataLoop* TDataLoop::Get(std::string name, TRawFile* source)
    return loop;
 }
 
-void TDataLoop::SetFileOdb(uint32_t time, char* data, int size)
+void TDataLoop::SetFileOdb(uint32_t time, char* data, int size, bool firstFile)
 {
+   /// Reads the ODB stored in the first event of a midas file. For any file but the first
+   /// one the ODB is only read if it differs from the previous one, and instead of deleting
+   /// all channels (which might still be used by fragments in the queues) they are updated
+   /// (within TChannel::BeginUpdate/EndUpdate, see NextSource).
 #ifdef HAS_XML
+   size_t odbHash = std::hash<std::string>()(std::string(data, size));
+   if(!firstFile && odbHash == fOdbHash) {
+      return;
+   }
+   fOdbHash = odbHash;
+
    // check if we have already set the TChannels....
    //
 	delete fOdb;
@@ -60,7 +77,9 @@ void TDataLoop::SetFileOdb(uint32_t time, char* data, int size)
    }
 
    fOdb = new TXMLOdb(data, size);
-   TChannel::DeleteAllChannels();
+   if(firstFile) {
+      TChannel::DeleteAllChannels();
+   }
 
    // Check to see if we are running a GRIFFIN or TIGRESS experiment
    TXMLNode* node = fOdb->FindPath("/Experiment");
@@ -88,7 +107,9 @@ void TDataLoop::SetFileOdb(uint32_t time, char* data, int size)
       SetGRIFFOdb();
    }
 
-   SetRunInfo(time);
+   if(firstFile) {
+      SetRunInfo(time);
+   }
 
    // Check for EPICS variables
    SetEPICSOdb();
@@ -179,6 +200,8 @@ void TDataLoop::SetGRIFFOdb()
          // printf("temp chan(%s) number set to: %i\n",tempChan->GetChannelName(),tempChan->GetNumber());
 
          tempChan->SetUserInfoNumber(x);
+         // an existing channel already has the coefficients of the previous ODB
+         tempChan->DestroyENGCal();
          tempChan->AddENGCoefficient(offsets.at(x));
          tempChan->AddENGCoefficient(gains.at(x));
          // TChannel::UpdateChannel(tempChan);
@@ -339,6 +362,8 @@ void TDataLoop::SetTIGOdb()
       }
       tempChan->SetIntegration(temp_integration);
       tempChan->SetUserInfoNumber(x);
+      // an existing channel already has the coefficients of the previous ODB
+      tempChan->DestroyENGCal();
       tempChan->AddENGCoefficient(offsets.at(x));
       tempChan->AddENGCoefficient(gains.at(x));
 
@@ -360,7 +385,80 @@ void TDataLoop::ReplaceSource(TRawFile* new_source)
 {
    std::lock_guard<std::mutex> lock(fSourceMutex);
    // delete source;
-   fSource = new_source;
+   fSource                  = new_source;
+   fSources[fCurrentSource] = new_source;
+}
+
+bool TDataLoop::AddSource(TRawFile* source)
+{
+   /// Adds a source to be read once all previous sources have been read. Only sub runs of the same run can be
+   /// read back-to-back (the time stamps restart with each run), so sources of other runs are rejected.
+   std::lock_guard<std::mutex> lock(fSourceMutex);
+   if(source->GetRunNumber() != fSources.front()->GetRunNumber()) {
+      std::cerr<<DRED<<"Not adding "<<source->GetFilename()<<": run "<<source->GetRunNumber()
+               <<" can't be read together with run "<<fSources.front()->GetRunNumber()<<RESET_COLOR<<std::endl;
+      return false;
+   }
+   fSources.push_back(source);
+   // the next source can be prefetched while the current one is being read
+   if(fSources.size() == fCurrentSource + 2) {
+      source->Prefetch();
+   }
+
+   return true;
+}
+
+bool TDataLoop::NextSource()
+{
+   /// Switches to the next source (if there is one), updating the run info, ODB, and
+   /// calibrations if necessary. Prefetches the source after that one.
+   /// Has to be called with fSourceMutex locked.
+   if(fCurrentSource + 1 >= fSources.size()) {
+      return false;
+   }
+   fBytesDone += fSource->GetBytesRead();
+   ++fCurrentSource;
+   fSource = fSources[fCurrentSource];
+   if(fCurrentSource + 1 < fSources.size()) {
+      fSources[fCurrentSource + 1]->Prefetch();
+   }
+
+   std::cout<<DBLUE<<"\nSwitching to "<<fSource->GetFilename()<<RESET_COLOR<<std::endl;
+
+   // same logic as TGRSIRunInfo::Add: the sub run number is only meaningful for subsequent sub runs
+   // (AddSource only accepts sub runs of the same run)
+   TGRSIRunInfo* runInfo = TGRSIRunInfo::Get();
+   if(runInfo->SubRunNumber() != -1 && fSource->GetSubRunNumber() == runInfo->SubRunNumber() + 1) {
+      runInfo->SetSubRunNumber(fSource->GetSubRunNumber());
+   } else {
+      runInfo->SetSubRunNumber(-1);
+   }
+
+   TMidasFile* midasFile = dynamic_cast<TMidasFile*>(fSource);
+   if(midasFile != nullptr) {
+#ifdef HAS_XML
+      size_t oldHash = fOdbHash;
+#endif
+      // the other loops are still using the channels, so the ODB and calibrations are applied to copies of them,
+      // and only the channels that changed are replaced at the end
+      TChannel::BeginUpdate();
+      SetFileOdb(midasFile->GetFirstEvent()->GetTimeStamp(), midasFile->GetFirstEvent()->GetData(),
+                 midasFile->GetFirstEvent()->GetDataSize(), false);
+#ifdef HAS_XML
+      if(oldHash != fOdbHash) {
+         // the ODB changed, so we need to re-apply the calibrations on top of it
+         for(const auto& cal_filename : TGRSIOptions::Get()->CalInputFiles()) {
+            TChannel::ReadCalFile(cal_filename.c_str());
+         }
+      }
+#endif
+      int changed = TChannel::EndUpdate();
+      if(changed > 0) {
+         std::cout<<DBLUE<<changed<<" channels changed"<<RESET_COLOR<<std::endl;
+      }
+   }
+
+   return true;
 }
 
 void TDataLoop::ResetSource()
@@ -379,15 +477,40 @@ bool TDataLoop::Iteration()
 {
    std::shared_ptr<TRawEvent> evt = fSource->NewEvent();
    int                        bytesRead;
+   bool                       live;
    {
       std::lock_guard<std::mutex> lock(fSourceMutex);
-      bytesRead   = fSource->Read(evt);
-      fItemsPopped = fSource->GetBytesRead() / 1000;
-      fInputSize = fSource->GetFileSize() / 1000 - fItemsPopped; // this way fInputSize+fItemsPopped give the file size
+      bytesRead = fSource->Read(evt);
+      // only continue with the next source once the current one is read completely, empty ones are skipped
+      while(bytesRead <= 0 && !fSource->IsLive() && (fSource->IsEndOfFile() || fSource->GetFileSize() == 0) &&
+            NextSource()) {
+         evt       = fSource->NewEvent();
+         bytesRead = fSource->Read(evt);
+      }
+      if(bytesRead <= 0 && !fSource->IsLive() && !fSource->IsEndOfFile() && fSource->GetFileSize() > 0) {
+         // a read error, an invalid event, or a file that ends in the middle of an event
+         TMidasFile* midasFile = dynamic_cast<TMidasFile*>(fSource);
+         std::cerr<<DRED<<"\nError reading "<<fSource->GetFilename()<<" after "<<fSource->GetBytesRead()<<" bytes: "
+                  <<((midasFile != nullptr && midasFile->GetLastErrno() != 0) ? midasFile->GetLastError()
+                                                                              : "incomplete event at the end of the file")
+                  <<", stopping"<<RESET_COLOR<<std::endl;
+         return false;
+      }
+      size_t totalSize = fBytesDone;
+      for(size_t i = fCurrentSource; i < fSources.size(); ++i) {
+         totalSize += fSources[i]->GetFileSize();
+      }
+      fItemsPopped = (fBytesDone + fSource->GetBytesRead()) / 1000;
+      fInputSize   = totalSize / 1000 - fItemsPopped; // this way fInputSize+fItemsPopped give the total file size
+      live         = fSource->IsLive();
    }
 
+   if(bytesRead <= 0 && live) {
+      // an online source had no new event for now, it already waited for one so we try again right away
+      return true;
+   }
    if(bytesRead <= 0 && fSelfStopping) {
-      // Error, and no point in trying again.
+      // all sources have been read
       return false;
    }
    if(bytesRead > 0) {
@@ -395,8 +518,9 @@ bool TDataLoop::Iteration()
       fOutputQueue->Push(evt);
       return true;
    }
-   // Nothing returned this time, but I might get something next time.
-   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+   // Nothing returned this time, but I might get something next time (e.g. if the file is still being written).
+   // There's no queue feeding this loop, so this only returns early if the loop is stopped.
+   WaitForInput();
    return true;
 }
 
@@ -3,7 +3,12 @@
 #include <chrono>
 #include <thread>
 
+#include "TROOT.h"
+
+#include "TChannel.h"
+#include "TGRSIOptions.h"
 #include "TUnpackedEvent.h"
+#include "TUnpackedEventPool.h"
 
 ClassImp(TDetBuildingLoop)
 
@@ -21,17 +26,41 @@ TDetBuildingLoop* TDetBuildingLoop::Get(std::string name)
 
 TDetBuildingLoop::TDetBuildingLoop(std::string name)
    : StoppableThread(name),
-     fInputQueue(std::make_shared<ThreadsafeQueue<std::vector<std::shared_ptr<const TFragment>>>>())
+     fInputQueue(std::make_shared<ThreadsafeQueue<std::vector<std::shared_ptr<const TFragment>>>>()),
+     fEventPool(TUnpackedEventPool::Create())
+{
+   fNofWorkers = TGRSIOptions::Get()->DetBuildingThreads();
+   if(fNofWorkers <= 0) {
+      fNofWorkers = std::thread::hardware_concurrency();
+   }
+   if(fNofWorkers <= 0) {
+      fNofWorkers = 1;
+   }
+   fWorkers.SetStatusVariables(&fItemsPopped, &fInputSize);
+}
+
+TDetBuildingLoop::~TDetBuildingLoop()
 {
+   fWorkers.Stop();
 }
 
-TDetBuildingLoop::~TDetBuildingLoop() = default;
+void TDetBuildingLoop::OnEnd()
+{
+   fWorkers.Stop();
+}
 
 bool TDetBuildingLoop::Iteration()
 {
+   if(fNofWorkers > 1) {
+      if(!fWorkers.IsStarted()) {
+         StartWorkers();
+      }
+      return ReleaseBuiltEvents();
+   }
+
    std::vector<std::shared_ptr<const TFragment>> frags;
 
-   fInputSize = fInputQueue->Pop(frags);
+   fInputSize = fInputQueue->Pop(frags, 0);
    if(fInputSize < 0) {
       fInputSize = 0;
    }
@@ -43,19 +72,66 @@ bool TDetBuildingLoop::Iteration()
          }
          return false;
       }
-      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+      WakeOn(fInputQueue);
+      WaitForInput();
       return true;
    }
    ++fItemsPopped;
 
-   std::shared_ptr<TUnpackedEvent> outputEvent = std::make_shared<TUnpackedEvent>();
+   PushEvent(BuildEvent(frags, fEventPool));
+
+   return true;
+}
+
+std::shared_ptr<TUnpackedEvent> TDetBuildingLoop::BuildEvent(const std::vector<std::shared_ptr<const TFragment>>& frags,
+                                                             const std::shared_ptr<TUnpackedEventPool>&           pool)
+{
+   std::shared_ptr<TUnpackedEvent> outputEvent = pool->Get();
    for(const auto& frag : frags) {
       // passes ownership of all TFragments, no need to delete here
       outputEvent->AddRawData(frag);
    }
    outputEvent->Build();
+
+   return outputEvent;
+}
+
+void TDetBuildingLoop::PushEvent(const std::shared_ptr<TUnpackedEvent>& event)
+{
    for(const auto& outQueue : fOutputQueues) {
-      outQueue->Push(outputEvent);
+      outQueue->Push(event);
+   }
+}
+
+void TDetBuildingLoop::StartWorkers()
+{
+   /// The workers build the detectors of the events, each from its own pool. The events are pushed to the output
+   /// queues in order on the thread of the loop.
+   // the detectors use ROOT (e.g. for fitting waveforms) from several threads now
+   ROOT::EnableThreadSafety();
+   fWorkers.Start(fInputQueue, fNofWorkers, 64 * static_cast<size_t>(fNofWorkers), [this]() {
+      std::shared_ptr<TUnpackedEventPool> pool = TUnpackedEventPool::Create();
+      return [this, pool](std::vector<std::shared_ptr<const TFragment>>& frags) {
+         TChannel::ReaderCheckpoint();
+         return BuildEvent(frags, pool);
+      };
+   });
+}
+
+bool TDetBuildingLoop::ReleaseBuiltEvents()
+{
+   /// Pushes all built events that are next in line to the output queues. Returns false once all workers are done
+   /// and all their events have been released.
+   std::vector<std::shared_ptr<TUnpackedEvent>> events;
+   if(!fWorkers.Release(events)) {
+      for(const auto& outQueue : fOutputQueues) {
+         outQueue->SetFinished();
+      }
+      return false;
+   }
+
+   for(const auto& event : events) {
+      PushEvent(event);
    }
 
    return true;
@@ -68,6 +144,8 @@ void TDetBuildingLoop::ClearQueue()
       fInputQueue->Pop(rawEvent);
    }
 
+   fWorkers.Clear();
+
    for(const auto& outQueue : fOutputQueues) {
       while(outQueue->Size() != 0u) {
          std::shared_ptr<TUnpackedEvent> event;
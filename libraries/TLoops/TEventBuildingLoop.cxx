@@ -3,7 +3,10 @@
 #include "TGRSIOptions.h"
 #include "TSortingDiagnostics.h"
 
+#include <algorithm>
 #include <chrono>
+#include <climits>
+#include <iterator>
 #include <thread>
 
 ClassImp(TEventBuildingLoop)
@@ -25,7 +28,11 @@ TEventBuildingLoop::TEventBuildingLoop(std::string name, EBuildMode mode)
    : StoppableThread(name), fInputQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<const TFragment>>>()),
      fOutputQueue(std::make_shared<ThreadsafeQueue<std::vector<std::shared_ptr<const TFragment>>>>()),
      fOutOfOrderQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<const TFragment>>>()), fBuildMode(mode),
-     fSortingDepth(10000), fBuildWindow(200), fPreviousSortingDepthError(false)
+     fSortingDepth(10000), fBuildWindow(200), fPreviousSortingDepthError(false), fMergeByChannel(false),
+     fAdaptiveSortDepth(false), fMinSortingDepth(10000), fMaxSortingDepth(2000000), fLargestSortingDepth(0),
+     fLatestKey(0), fMaxLateEntries(0), fMaxLateTime(0), fWindowLateEntries(0), fWindowStart(0), fNofWorkers(1),
+     fSliceWidth(100000000), fSliceOverlap(0), fNextSlice(LONG_MIN), fSplitSlices(0), fLateFragments(0), fNextEventStart(0),
+     fNextEventLast(0), fMergeSize(0), fMergeCounter(0)
 {
 
    switch(fBuildMode) {
@@ -43,7 +50,26 @@ TEventBuildingLoop::TEventBuildingLoop(std::string name, EBuildMode mode)
    }
 }
 
-TEventBuildingLoop::~TEventBuildingLoop() = default;
+TEventBuildingLoop::~TEventBuildingLoop()
+{
+   StopWorkers();
+}
+
+void TEventBuildingLoop::SetEventBuildingThreads(int threads)
+{
+   fNofWorkers = threads;
+   if(fNofWorkers <= 0) {
+      fNofWorkers = std::thread::hardware_concurrency();
+   }
+   if(fNofWorkers <= 0) {
+      fNofWorkers = 1;
+   }
+}
+
+void TEventBuildingLoop::OnEnd()
+{
+   StopWorkers();
+}
 
 void TEventBuildingLoop::ClearQueue()
 {
@@ -56,10 +82,26 @@ void TEventBuildingLoop::ClearQueue()
    while(fOutputQueue->Size() != 0u) {
       fOutputQueue->Pop(event);
    }
+
+   fOrdered.clear();
+   fChannels.clear();
+   fHeads     = decltype(fHeads)();
+   fIdle      = decltype(fIdle)();
+   fMergeSize = 0;
+
+   fOpenSlices.clear();
+   fBuildingSlices.clear();
 }
 
 bool TEventBuildingLoop::Iteration()
 {
+   if(fNofWorkers > 1 && fBuildMode == kTimestamp) {
+      return IterationSliced();
+   }
+   if(fMergeByChannel && fBuildMode == kTimestamp) {
+      return IterationMerge();
+   }
+
    // Pull something off of the input queue.
    std::shared_ptr<const TFragment> input_frag = nullptr;
    fInputSize                                  = fInputQueue->Pop(input_frag, 0);
@@ -69,6 +111,7 @@ bool TEventBuildingLoop::Iteration()
 
    if(input_frag) {
       ++fItemsPopped;
+      UpdateSortDepth(input_frag);
       fOrdered.insert(input_frag);
       if(fOrdered.size() < fSortingDepth) {
          // Got a new event, but we want to have more to sort
@@ -79,7 +122,8 @@ bool TEventBuildingLoop::Iteration()
    } else {
       if(!fInputQueue->IsFinished()) {
          // If the parent is live, wait for it
-         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+         WakeOn(fInputQueue);
+         WaitForInput();
          return true;
       }
       if(fOrdered.empty()) {
@@ -88,6 +132,7 @@ bool TEventBuildingLoop::Iteration()
             fOutputQueue->Push(fNextEvent);
          }
          fOutputQueue->SetFinished();
+         ReportSortDepth();
          return false;
       }
       // Parent is dead, but we still have items.
@@ -95,30 +140,461 @@ bool TEventBuildingLoop::Iteration()
    }
 
    // We have data, and we want to add it to the next fragment;
-   std::shared_ptr<const TFragment> next_fragment = *fOrdered.begin();
-   fOrdered.erase(fOrdered.begin());
-   if(CheckBuildCondition(next_fragment)) {
-      fNextEvent.push_back(next_fragment);
+   // if the sort depth has been lowered, we release fragments until we're back at the sort depth
+   do {
+      std::shared_ptr<const TFragment> next_fragment = *fOrdered.begin();
+      fOrdered.erase(fOrdered.begin());
+      if(CheckBuildCondition(next_fragment)) {
+         AddToNextEvent(next_fragment, (fBuildMode == kTimestamp) ? next_fragment->GetTimeStamp() : 0);
+      }
+   } while(input_frag && fOrdered.size() >= fSortingDepth);
+
+   return true;
+}
+
+bool TEventBuildingLoop::IterationMerge()
+{
+   /// Builds events by merging the per-channel queues, see the class description.
+   std::shared_ptr<const TFragment> input_frag = nullptr;
+   fInputSize                                  = fInputQueue->Pop(input_frag, 0);
+   if(fInputSize < 0) {
+      fInputSize = 0;
+   }
+
+   if(input_frag) {
+      ++fItemsPopped;
+      UpdateSortDepth(input_frag);
+      AddToMerge(input_frag);
+   }
+
+   // once the parent is dead there is nothing left to wait for
+   bool parentDead = !input_frag && fInputQueue->IsFinished();
+   while(ReleaseFromMerge(parentDead)) {
+   }
+
+   if(input_frag) {
+      return true;
+   }
+   if(!parentDead) {
+      WakeOn(fInputQueue);
+      WaitForInput();
+      return true;
+   }
+   // Parent is dead, and we have passed on all events
+   if(!fNextEvent.empty()) {
+      fOutputQueue->Push(fNextEvent);
+      fNextEvent.clear();
+   }
+   fOutputQueue->SetFinished();
+   ReportSortDepth();
+   return false;
+}
+
+void TEventBuildingLoop::AddToMerge(const std::shared_ptr<const TFragment>& frag)
+{
+   long           timestamp = frag->GetTimeStamp();
+   UInt_t         address   = frag->GetAddress();
+   TMergeChannel& channel   = fChannels[address];
+   ++fMergeCounter;
+   ++fMergeSize;
+
+   if(channel.fQueue.empty()) {
+      channel.fQueue.push_back({timestamp, frag});
+      fHeads.push({timestamp, address, fMergeCounter});
+   } else if(timestamp >= channel.fQueue.back().fTimeStamp) {
+      channel.fQueue.push_back({timestamp, frag});
+   } else {
+      // this channel isn't time ordered after all, so we insert the fragment where it belongs
+      auto it = std::upper_bound(channel.fQueue.begin(), channel.fQueue.end(), timestamp,
+                                 [](long ts, const TMergeEntry& entry) { return ts < entry.fTimeStamp; });
+      if(it == channel.fQueue.begin()) {
+         // new first fragment of this channel, the old heap entry is skipped once it comes up
+         fHeads.push({timestamp, address, fMergeCounter});
+      }
+      channel.fQueue.insert(it, TMergeEntry{timestamp, frag});
    }
 
+   if(timestamp > channel.fLastTimeStamp) {
+      channel.fLastTimeStamp = timestamp;
+   }
+   channel.fLastEntry = fMergeCounter;
+}
+
+bool TEventBuildingLoop::ReleaseFromMerge(bool force)
+{
+   /// Releases the earliest fragment of all channels, if no channel still waiting for data could send an
+   /// earlier one (or force is set). Returns true if a fragment was released.
+
+   // skip heads that are out of date (the channel got an earlier fragment)
+   while(!fHeads.empty()) {
+      const TMergeHead& head  = fHeads.top();
+      auto              found = fChannels.find(head.fAddress);
+      if(found != fChannels.end() && !found->second.fQueue.empty() &&
+         found->second.fQueue.front().fTimeStamp == head.fTimeStamp) {
+         break;
+      }
+      fHeads.pop();
+   }
+   if(fHeads.empty()) {
+      return false;
+   }
+   TMergeHead head = fHeads.top();
+
+   if(!force && fMergeSize <= fSortingDepth) {
+      // find the empty channel with the earliest last time stamp we still have to wait for
+      while(!fIdle.empty()) {
+         const TMergeHead& idle    = fIdle.top();
+         TMergeChannel&    channel = fChannels[idle.fAddress];
+         if(!channel.fQueue.empty() || channel.fLastEntry != idle.fEntry || fMergeCounter - idle.fEntry > fSortingDepth) {
+            // the channel has data again, or has been quiet for too long to wait for it
+            fIdle.pop();
+            continue;
+         }
+         break;
+      }
+      if(!fIdle.empty() && fIdle.top().fTimeStamp < head.fTimeStamp) {
+         // this channel could still send a fragment before the head
+         return false;
+      }
+   }
+
+   fHeads.pop();
+   TMergeChannel& channel = fChannels[head.fAddress];
+   TMergeEntry    entry   = std::move(channel.fQueue.front());
+   channel.fQueue.pop_front();
+   --fMergeSize;
+   if(channel.fQueue.empty()) {
+      fIdle.push({channel.fLastTimeStamp, head.fAddress, channel.fLastEntry});
+   } else {
+      fHeads.push({channel.fQueue.front().fTimeStamp, head.fAddress, channel.fLastEntry});
+   }
+
+   if(CheckTimestampCondition(entry.fFragment, entry.fTimeStamp)) {
+      AddToNextEvent(entry.fFragment, entry.fTimeStamp);
+   }
    return true;
 }
 
+bool TEventBuildingLoop::IterationSliced()
+{
+   /// Sorts the fragments into time slices that are built by the workers, see the class description.
+   if(fWorkers.empty()) {
+      StartWorkers();
+   }
+
+   std::shared_ptr<const TFragment> input_frag = nullptr;
+   fInputSize                                  = fInputQueue->Pop(input_frag, 0);
+   if(fInputSize < 0) {
+      fInputSize = 0;
+   }
+
+   if(input_frag) {
+      ++fItemsPopped;
+      UpdateSortDepth(input_frag);
+      AddToSlices(input_frag);
+      DispatchSlices(false);
+   }
+   ReleaseSlices();
+
+   if(input_frag) {
+      return true;
+   }
+   if(!fInputQueue->IsFinished()) {
+      // If the parent is live, wait for it
+      WakeOn(fInputQueue);
+      WaitForInput();
+      return true;
+   }
+   // Parent is dead, build the remaining slices and wait for the workers to finish them
+   DispatchSlices(true);
+   fSliceQueue->SetFinished();
+   if(!fBuildingSlices.empty()) {
+      WaitForInput();
+      return true;
+   }
+
+   StopWorkers();
+   if(fSplitSlices > 0) {
+      std::cerr<<std::endl
+               <<fSplitSlices<<" time slice boundaries had no gap larger than the build window, events at these "
+               <<"boundaries may have been split"<<std::endl;
+   }
+   fOutputQueue->SetFinished();
+   ReportSortDepth();
+   return false;
+}
+
+void TEventBuildingLoop::AddToSlices(const std::shared_ptr<const TFragment>& frag)
+{
+   long timestamp = frag->GetTimeStamp();
+   long index     = timestamp / fSliceWidth;
+   long offset    = timestamp - index * fSliceWidth;
+   // fragments in the overlap also go to the previous slice (so it can find its end), fragments within a build
+   // window of the end also to the next slice (so it can find its start)
+   long first = (offset < fSliceOverlap) ? index - 1 : index;
+   long last  = (fSliceWidth - offset <= fBuildWindow) ? index + 1 : index;
+
+   if(first < fNextSlice) {
+      // (one of) the slice(s) has already been handed to the workers
+      ++fLateFragments;
+      TSortingDiagnostics::Get()->OutOfOrder(timestamp, fNextSlice * fSliceWidth, frag->GetEntryNumber());
+      if(!fPreviousSortingDepthError) {
+         std::cerr<<std::endl
+                  <<"Sorting depth of "<<fSortingDepth<<" was insufficient. timestamp: "<<timestamp
+                  <<" arrived after the slice starting at "<<(first * fSliceWidth)<<" was built\n"
+                  <<"Not all events were built correctly"<<std::endl;
+         std::cerr<<"Please increase sort depth with --sort-depth=N (or use --adaptive-sort-depth)"<<std::endl;
+         fPreviousSortingDepthError = true;
+      }
+      if(TGRSIOptions::Get()->SeparateOutOfOrder()) {
+         fOutOfOrderQueue->Push(frag);
+      } else {
+         // build it as an event of its own (like the other build modes do), passed on after the slices handed out
+         std::shared_ptr<TEventSlice> lateSlice = std::make_shared<TEventSlice>();
+         lateSlice->fIndex                      = first;
+         lateSlice->fEvents.emplace_back(1, frag);
+         lateSlice->fDone.store(true, std::memory_order_release);
+         fBuildingSlices.push_back(lateSlice);
+      }
+      return;
+   }
+
+   for(long i = first; i <= last; ++i) {
+      std::shared_ptr<TEventSlice>& slice = fOpenSlices[i];
+      if(slice == nullptr) {
+         slice         = std::make_shared<TEventSlice>();
+         slice->fIndex = i;
+      }
+      slice->fFragments.push_back(frag);
+   }
+}
+
+void TEventBuildingLoop::DispatchSlices(bool all)
+{
+   /// Hands the open slices to the workers once fragments past their overlap have arrived and another sort depth of
+   /// fragments has been read since (or all of them if all is set).
+   while(!fOpenSlices.empty()) {
+      std::shared_ptr<TEventSlice> slice = fOpenSlices.begin()->second;
+      if(!all) {
+         if(slice->fCloseAt == 0) {
+            if(fLatestKey < (slice->fIndex + 1) * fSliceWidth + fSliceOverlap) {
+               break;
+            }
+            slice->fCloseAt = fItemsPopped + fSortingDepth;
+         }
+         if(fItemsPopped < slice->fCloseAt) {
+            break;
+         }
+      }
+      fOpenSlices.erase(fOpenSlices.begin());
+      fNextSlice = slice->fIndex + 1;
+      fBuildingSlices.push_back(slice);
+      fSliceQueue->Push(slice);
+   }
+}
+
+void TEventBuildingLoop::ReleaseSlices()
+{
+   /// Passes on the events of all finished slices, in the order of the slices.
+   while(!fBuildingSlices.empty() && fBuildingSlices.front()->fDone.load(std::memory_order_acquire)) {
+      std::shared_ptr<TEventSlice> slice = fBuildingSlices.front();
+      fBuildingSlices.pop_front();
+      for(auto& event : slice->fEvents) {
+         fOutputQueue->Push(std::move(event));
+      }
+      if(slice->fSplit) {
+         ++fSplitSlices;
+      }
+   }
+}
+
+void TEventBuildingLoop::StartWorkers()
+{
+   // the slices have to be wide enough for the overlap to only reach into the neighbouring slices
+   fSliceWidth   = std::max(fSliceWidth, std::max(64 * fBuildWindow, 1L));
+   fSliceOverlap = std::max(16 * fBuildWindow, fSliceWidth / 64);
+   fSliceQueue   = std::make_shared<ThreadsafeQueue<std::shared_ptr<TEventSlice>>>("slice_queue", 4 * fNofWorkers);
+   for(int i = 0; i < fNofWorkers; ++i) {
+      fWorkers.emplace_back(&TEventBuildingLoop::WorkerLoop, this);
+   }
+}
+
+void TEventBuildingLoop::StopWorkers()
+{
+   if(fSliceQueue != nullptr) {
+      fSliceQueue->SetFinished();
+   }
+   for(auto& worker : fWorkers) {
+      if(worker.joinable()) {
+         worker.join();
+      }
+   }
+   fWorkers.clear();
+}
+
+void TEventBuildingLoop::WorkerLoop()
+{
+   /// Builds the slices handed to the workers, the events are passed on in order by the loop's thread.
+   std::shared_ptr<TEventSlice> slice;
+   while(!fSliceQueue->IsFinished() || fSliceQueue->Size() > 0) {
+      if(fSliceQueue->Pop(slice, 100) < 0) {
+         continue;
+      }
+      BuildSlice(*slice);
+      slice->fDone.store(true, std::memory_order_release);
+      slice.reset();
+      fWakeup->Notify();
+   }
+}
+
+void TEventBuildingLoop::BuildSlice(TEventSlice& slice) const
+{
+   std::vector<std::shared_ptr<const TFragment>>& fragments = slice.fFragments;
+   // the fragments were added in the order they arrived, so two slices sharing fragments sort them the same way
+   std::stable_sort(fragments.begin(), fragments.end(),
+                    [](const std::shared_ptr<const TFragment>& a, const std::shared_ptr<const TFragment>& b) {
+                       return a->GetTimeStamp() < b->GetTimeStamp();
+                    });
+
+   bool   split = false;
+   size_t begin = SliceBoundary(slice, slice.fIndex * fSliceWidth, split);
+   size_t end   = SliceBoundary(slice, (slice.fIndex + 1) * fSliceWidth, slice.fSplit);
+
+   // same as CheckTimestampCondition, except that the fragments are already in order
+   bool                                          staticWindow = TGRSIOptions::Get()->AnalysisOptions()->StaticWindow();
+   long                                          eventStart   = 0;
+   std::vector<std::shared_ptr<const TFragment>> event;
+   for(size_t i = begin; i < end; ++i) {
+      long timestamp = fragments[i]->GetTimeStamp();
+      if(!event.empty() && timestamp > eventStart + fBuildWindow) {
+         slice.fEvents.push_back(std::move(event));
+         event.clear();
+      }
+      if(event.empty() || !staticWindow) {
+         eventStart = timestamp;
+      }
+      event.push_back(fragments[i]);
+   }
+   if(!event.empty()) {
+      slice.fEvents.push_back(std::move(event));
+   }
+
+   fragments.clear();
+   fragments.shrink_to_fit();
+}
+
+size_t TEventBuildingLoop::SliceBoundary(const TEventSlice& slice, long boundary, bool& split) const
+{
+   /// Returns the index of the first fragment at or after the boundary (and before the end of the overlap) that
+   /// follows a gap larger than the build window. Both slices at a boundary have all fragments from one build
+   /// window before it to the end of the overlap, so they find the same fragment. If there is no such fragment,
+   /// the first fragment at or after the boundary is used and split is set.
+   const std::vector<std::shared_ptr<const TFragment>>& fragments = slice.fFragments;
+
+   size_t first = std::lower_bound(fragments.begin(), fragments.end(), boundary,
+                                   [](const std::shared_ptr<const TFragment>& frag, long timestamp) {
+                                      return frag->GetTimeStamp() < timestamp;
+                                   }) -
+                  fragments.begin();
+   for(size_t i = first; i < fragments.size() && fragments[i]->GetTimeStamp() < boundary + fSliceOverlap; ++i) {
+      if(i == 0 || fragments[i]->GetTimeStamp() - fragments[i - 1]->GetTimeStamp() > fBuildWindow) {
+         return i;
+      }
+   }
+   if(first < fragments.size() && fragments[first]->GetTimeStamp() < boundary + fSliceOverlap) {
+      split = true;
+   }
+   return first;
+}
+
+void TEventBuildingLoop::UpdateSortDepth(const std::shared_ptr<const TFragment>& frag)
+{
+   /// Measures how late the fragment arrived and, if the sort depth is adaptive, raises the sort depth to twice
+   /// the lateness. Every four sort depths of fragments the depth is lowered (by at most half) if no fragment
+   /// in that window needed it.
+   static const size_t sampling = 64;
+
+   long   key   = (fBuildMode == kTimestamp) ? frag->GetTimeStamp() : frag->GetTriggerId();
+   size_t entry = fItemsPopped;
+   if(entry == 1 || key >= fLatestKey) {
+      fLatestKey = key;
+   } else {
+      // the first sample with a later key tells us (within the sampling) since when the fragment is overdue
+      auto it = std::upper_bound(fLatestKeys.begin(), fLatestKeys.end(), key,
+                                 [](long k, const std::pair<size_t, long>& sample) { return k < sample.second; });
+      long lateEntries = entry;
+      if(it != fLatestKeys.begin()) {
+         lateEntries = entry - std::prev(it)->first;
+      } else if(!fLatestKeys.empty()) {
+         lateEntries = entry - it->first;
+      }
+      if(lateEntries > fMaxLateEntries) {
+         fMaxLateEntries = lateEntries;
+      }
+      if(fLatestKey - key > fMaxLateTime) {
+         fMaxLateTime = fLatestKey - key;
+      }
+      if(lateEntries > fWindowLateEntries) {
+         fWindowLateEntries = lateEntries;
+      }
+      if(fAdaptiveSortDepth && 2 * lateEntries > fSortingDepth && fSortingDepth < fMaxSortingDepth) {
+         // grow by at least 50% so we don't creep up one fragment at a time
+         fSortingDepth = std::min(std::max(static_cast<unsigned int>(2 * lateEntries), fSortingDepth * 3 / 2),
+                                  fMaxSortingDepth);
+         fWindowStart = entry;
+      }
+   }
+
+   if(entry % sampling == 0) {
+      fLatestKeys.emplace_back(entry, fLatestKey);
+      // fragments later than the maximum sort depth can't be helped anyway
+      while(fLatestKeys.size() > 1 && entry - fLatestKeys.front().first > fMaxSortingDepth) {
+         fLatestKeys.pop_front();
+      }
+   }
+
+   if(fAdaptiveSortDepth && entry - fWindowStart >= 4 * static_cast<size_t>(fSortingDepth)) {
+      if(4 * fWindowLateEntries < fSortingDepth && fSortingDepth > fMinSortingDepth) {
+         fSortingDepth = std::max(fMinSortingDepth,
+                                  std::max(static_cast<unsigned int>(2 * fWindowLateEntries), fSortingDepth / 2));
+      }
+      fWindowLateEntries = 0;
+      fWindowStart       = entry;
+   }
+
+   if(fSortingDepth > fLargestSortingDepth) {
+      fLargestSortingDepth = fSortingDepth;
+   }
+}
+
+void TEventBuildingLoop::ReportSortDepth()
+{
+   TSortingDiagnostics::Get()->SortDepth(fSortingDepth, fLargestSortingDepth, fMaxLateEntries, fMaxLateTime);
+}
+
+void TEventBuildingLoop::AddToNextEvent(const std::shared_ptr<const TFragment>& frag, long timestamp)
+{
+   if(fNextEvent.empty()) {
+      fNextEventStart = timestamp;
+   }
+   fNextEventLast = timestamp;
+   fNextEvent.push_back(frag);
+}
+
 bool TEventBuildingLoop::CheckBuildCondition(const std::shared_ptr<const TFragment>& frag)
 {
    switch(fBuildMode) {
-   case kTimestamp: return CheckTimestampCondition(frag); break;
+   case kTimestamp: return CheckTimestampCondition(frag, frag->GetTimeStamp()); break;
 
    case kTriggerId: return CheckTriggerIdCondition(frag); break;
    }
    return false; // we should never reach this statement!
 }
 
-bool TEventBuildingLoop::CheckTimestampCondition(const std::shared_ptr<const TFragment>& frag)
+bool TEventBuildingLoop::CheckTimestampCondition(const std::shared_ptr<const TFragment>& frag, long timestamp)
 {
-   long timestamp   = frag->GetTimeStamp();
-   long event_start = (!fNextEvent.empty() ? (TGRSIOptions::Get()->AnalysisOptions()->StaticWindow() ? fNextEvent[0]->GetTimeStamp()
-                                                                                                      : fNextEvent.back()->GetTimeStamp())
+   long event_start = (!fNextEvent.empty() ? (TGRSIOptions::Get()->AnalysisOptions()->StaticWindow() ? fNextEventStart
+                                                                                                      : fNextEventLast)
                                            : timestamp);
 
    // save timestamp every <BuildWindow> fragments
@@ -137,7 +613,12 @@ bool TEventBuildingLoop::CheckTimestampCondition(const std::shared_ptr<const TFr
                   <<"Sorting depth of "<<fSortingDepth<<" was insufficient. timestamp: "<<timestamp
                   <<" Last: "<<event_start<<" \n"
                   <<"Not all events were built correctly"<<std::endl;
-         std::cerr<<"Please increase sort depth with --sort-depth=N"<<std::endl;
+         if(fAdaptiveSortDepth) {
+            std::cerr<<"The sort depth is raised automatically up to "<<fMaxSortingDepth
+                     <<", if this happens again please increase --max-sort-depth=N"<<std::endl;
+         } else {
+            std::cerr<<"Please increase sort depth with --sort-depth=N (or use --adaptive-sort-depth)"<<std::endl;
+         }
          fPreviousSortingDepthError = true;
       }
       if(TGRSIOptions::Get()->SeparateOutOfOrder()) {
@@ -173,7 +654,12 @@ bool TEventBuildingLoop::CheckTriggerIdCondition(const std::shared_ptr<const TFr
                   <<"Not all events were built correctly"<<std::endl;
          std::cerr<<"Trigger id #"<<trigger_id<<" was incorrectly sorted before "
                   <<"trigger id #"<<current_trigger_id<<std::endl;
-         std::cerr<<"Please increase sort depth with --sort-depth=N"<<std::endl;
+         if(fAdaptiveSortDepth) {
+            std::cerr<<"The sort depth is raised automatically up to "<<fMaxSortingDepth
+                     <<", if this happens again please increase --max-sort-depth=N"<<std::endl;
+         } else {
+            std::cerr<<"Please increase sort depth with --sort-depth=N (or use --adaptive-sort-depth)"<<std::endl;
+         }
          fPreviousSortingDepthError = true;
       }
       if(TGRSIOptions::Get()->SeparateOutOfOrder()) {
@@ -190,6 +676,10 @@ std::string TEventBuildingLoop::EndStatus()
    std::stringstream ss;
    ss<<fInputQueue->Name()<<": "<<fItemsPopped<<"/"<<fInputQueue->ItemsPopped()<<" items popped"
      <<std::endl;
+   if(fNofWorkers > 1 && fBuildMode == kTimestamp) {
+      ss<<Name()<<": built events on "<<fNofWorkers<<" threads, "<<fSplitSlices<<" split slice boundaries, "
+        <<fLateFragments<<" late fragments"<<std::endl;
+   }
 
    return ss.str();
 }
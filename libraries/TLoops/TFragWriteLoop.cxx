@@ -37,6 +37,8 @@ TFragWriteLoop* TFragWriteLoop::Get(std::string name, std::string fOutputFilenam
 
 TFragWriteLoop::TFragWriteLoop(std::string name, std::string fOutputFilename)
    : StoppableThread(name), fOutputFile(nullptr), fEventTree(nullptr), fBadEventTree(nullptr), fScalerTree(nullptr),
+     fEventAddress(nullptr), fBadEventAddress(nullptr), fScalerAddress(nullptr), fDefaultEvent(nullptr),
+     fDefaultBadEvent(nullptr), fWaveformAddress(nullptr),
      fInputQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<const TFragment>>>()),
      fBadInputQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<const TBadFragment>>>()),
      fScalerInputQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<TEpicsFrag>>>())
@@ -47,11 +49,19 @@ TFragWriteLoop::TFragWriteLoop(std::string name, std::string fOutputFilename)
       fOutputFile = new TFile(fOutputFilename.c_str(), "RECREATE");
 
       fEventTree    = new TTree("FragmentTree", "FragmentTree");
-      fEventAddress = new TFragment;
+      fDefaultEvent = new TFragment;
+      fEventAddress = fDefaultEvent;
       fEventTree->Branch("TFragment", &fEventAddress);
+      if(TGRSIOptions::Get()->ExtractWaves()) {
+         // the waveforms go into their own branch, so reading the fragments without them doesn't read them at all
+         fWaveformAddress = &fWaveform;
+         fEventTree->Branch("Waveform", &fWaveformAddress);
+         TFragment::SetWaveformBranch(true);
+      }
 
       fBadEventTree    = new TTree("BadFragmentTree", "BadFragmentTree");
-      fBadEventAddress = new TBadFragment;
+      fDefaultBadEvent = new TBadFragment;
+      fBadEventAddress = fDefaultBadEvent;
       fBadEventTree->Branch("TBadFragment", &fBadEventAddress);
 
       fScalerTree    = new TTree("EpicsTree", "EpicsTree");
@@ -65,6 +75,8 @@ TFragWriteLoop::TFragWriteLoop(std::string name, std::string fOutputFilename)
 TFragWriteLoop::~TFragWriteLoop()
 {
    Write();
+   delete fDefaultEvent;
+   delete fDefaultBadEvent;
 }
 
 void TFragWriteLoop::ClearQueue()
@@ -123,7 +135,11 @@ bool TFragWriteLoop::Iteration()
    if(allParentsDead) {
       return false;
    }
-   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+   // wait until any of the three queues gets something instead of polling them
+   WakeOn(fInputQueue);
+   WakeOn(fBadInputQueue);
+   WakeOn(fScalerInputQueue);
+   WaitForInput();
    return true;
 }
 
@@ -160,11 +176,16 @@ void TFragWriteLoop::Write()
 void TFragWriteLoop::WriteEvent(const std::shared_ptr<const TFragment>& event)
 {
    if(fEventTree != nullptr) {
-      *fEventAddress = *event;
-      fEventAddress->ClearTransients();
+      // fill straight from the shared fragment instead of copying it into the branch, writing doesn't change the
+      // fragment (the transient flags aren't streamed)
+      // afterwards the branch points at its own fragment again, with nullptr ROOT would construct a new one
+      fEventAddress = const_cast<TFragment*>(event.get());
+      if(fWaveformAddress != nullptr) {
+         event->GetPackedWaveform(fWaveform);
+      }
       std::lock_guard<std::mutex> lock(ttree_fill_mutex);
       fEventTree->Fill();
-      // fEventAddress = nullptr;
+      fEventAddress = fDefaultEvent;
    } else {
       std::cout<<__PRETTY_FUNCTION__<<": no fragment tree!"<<std::endl;
    }
@@ -173,9 +194,10 @@ void TFragWriteLoop::WriteEvent(const std::shared_ptr<const TFragment>& event)
 void TFragWriteLoop::WriteBadEvent(const std::shared_ptr<const TBadFragment>& event)
 {
    if(fBadEventTree != nullptr) {
-      *fBadEventAddress = *static_cast<const TBadFragment*>(event.get());
-		std::lock_guard<std::mutex> lock(ttree_fill_mutex);
-		fBadEventTree->Fill();
+      fBadEventAddress = const_cast<TBadFragment*>(event.get());
+      std::lock_guard<std::mutex> lock(ttree_fill_mutex);
+      fBadEventTree->Fill();
+      fBadEventAddress = fDefaultBadEvent;
    }
 }
 
@@ -10,6 +10,7 @@
 #include "TDetector.h"
 #include "GRootCommands.h"
 #include "TFragment.h"
+#include "TGRSIOptions.h"
 
 TFragmentChainLoop* TFragmentChainLoop::Get(std::string name, TChain* chain)
 {
@@ -32,7 +33,7 @@ TFragmentChainLoop* TFragmentChainLoop::Get(std::string name, TChain* chain)
 
 TFragmentChainLoop::TFragmentChainLoop(std::string name, TChain* chain)
    : StoppableThread(name), fEntriesTotal(chain->GetEntries()), fInputChain(chain), fFragment(nullptr),
-     fSelfStopping(true)
+     fWaveform(nullptr), fSelfStopping(true)
 {
    SetupChain();
 }
@@ -56,6 +57,14 @@ int TFragmentChainLoop::SetupChain()
    }
 
    fInputChain->SetBranchAddress("TFragment", &fFragment);
+   // files written before the waveforms got their own branch have them in the TFragment branch
+   if(fInputChain->GetBranch("Waveform") != nullptr) {
+      if(TGRSIOptions::Get()->ExtractWaves()) {
+         fInputChain->SetBranchAddress("Waveform", &fWaveform);
+      } else {
+         fInputChain->SetBranchStatus("Waveform", false);
+      }
+   }
    return 0;
 }
 
@@ -84,6 +93,9 @@ bool TFragmentChainLoop::Iteration()
    std::shared_ptr<TFragment> frag = std::make_shared<TFragment>();
    fInputChain->GetEntry(fItemsPopped++);
    *frag = *fFragment;
+   if(fWaveform != nullptr) {
+      frag->SetPackedWaveform(*fWaveform);
+   }
    frag->SetEntryNumber();
    for(const auto& outQueue : fOutputQueues) {
       outQueue->Push(frag);
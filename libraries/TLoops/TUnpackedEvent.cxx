@@ -1,8 +1,13 @@
 #include "TUnpackedEvent.h"
 
+#include <mutex>
+#include <unordered_map>
+
 #include "TClass.h"
 #include "TDetector.h"
+#include "TGRSIDetector.h"
 #include "TChannel.h"
+#include "TGRSIOptions.h"
 
 TUnpackedEvent::TUnpackedEvent()
 {
@@ -10,6 +15,25 @@ TUnpackedEvent::TUnpackedEvent()
 
 TUnpackedEvent::~TUnpackedEvent() = default;
 
+size_t TUnpackedEvent::Slot(TClass* cls)
+{
+   /// Returns the slot number of the detector class. Slots are handed out in the order the classes are first seen,
+   /// each thread keeps its own copy of the mapping so only new classes need the lock.
+   static std::mutex                               slotMutex;
+   static std::unordered_map<TClass*, size_t>       slots;
+   thread_local std::unordered_map<TClass*, size_t> cache;
+
+   auto it = cache.find(cls);
+   if(it != cache.end()) {
+      return it->second;
+   }
+
+   std::lock_guard<std::mutex> lock(slotMutex);
+   auto                        slot = slots.insert(std::make_pair(cls, slots.size())).first->second;
+   cache[cls]                       = slot;
+   return slot;
+}
+
 void TUnpackedEvent::Build()
 {
    for(const auto& frag : fFragments) {
@@ -30,6 +54,9 @@ void TUnpackedEvent::Build()
 
    BuildHits();
    ClearRawData();
+   if(TGRSIOptions::Get()->ColumnTree()) {
+      CalculateHits();
+   }
 }
 
 void TUnpackedEvent::AddRawData(const std::shared_ptr<const TFragment>& frag)
@@ -42,6 +69,23 @@ void TUnpackedEvent::ClearRawData()
    fFragments.clear();
 }
 
+void TUnpackedEvent::Clear()
+{
+   ClearRawData();
+   if(fSpare.size() < fSlots.size()) {
+      fSpare.resize(fSlots.size());
+   }
+   for(size_t slot = 0; slot < fSlots.size(); ++slot) {
+      // only re-use detectors nobody else holds on to (fDetectors has the other reference)
+      if(fSlots[slot] != nullptr && fSlots[slot].use_count() == 2) {
+         fSlots[slot]->Clear();
+         fSpare[slot] = fSlots[slot];
+      }
+      fSlots[slot].reset();
+   }
+   fDetectors.clear();
+}
+
 void TUnpackedEvent::BuildHits()
 {
    for(const auto& det : fDetectors) {
@@ -49,17 +93,52 @@ void TUnpackedEvent::BuildHits()
    }
 }
 
-std::shared_ptr<TDetector> TUnpackedEvent::GetDetector(TClass* cls, bool make_if_not_found)
+void TUnpackedEvent::CalculateHits()
 {
-   for(auto det : fDetectors) {
-      if(det->IsA() == cls) {
-         return det;
+   /// Calculates the energy and time of all hits. These are cached in mutable members of the hits, so once the
+   /// event has been passed on, the analysis write loop (which writes them to the column tree) and the histogram
+   /// loops only read them, instead of both calculating them at the same time.
+   for(const auto& det : fDetectors) {
+      auto* grsiDet = dynamic_cast<TGRSIDetector*>(det.get());
+      if(grsiDet == nullptr) {
+         continue;
+      }
+      for(Int_t i = 0; i < grsiDet->GetMultiplicity(); ++i) {
+         TGRSIDetectorHit* hit = grsiDet->GetHit(i);
+         hit->GetEnergy();
+         hit->GetTime();
       }
    }
+}
+
+void TUnpackedEvent::AddDetector(const std::shared_ptr<TDetector>& det)
+{
+   size_t slot = Slot(det->IsA());
+   if(fSlots.size() <= slot) {
+      fSlots.resize(slot + 1);
+   }
+   fSlots[slot] = det;
+   fDetectors.push_back(det);
+}
+
+std::shared_ptr<TDetector> TUnpackedEvent::GetDetector(TClass* cls, bool make_if_not_found)
+{
+   size_t slot = Slot(cls);
+   if(slot < fSlots.size() && fSlots[slot] != nullptr) {
+      return fSlots[slot];
+   }
 
    if(make_if_not_found) {
-      // std::shared_ptr<TDetector> output = std::make_shared<TDetector>(*static_cast<TDetector*>(cls->New()));
-      std::shared_ptr<TDetector> output(static_cast<TDetector*>(cls->New()));
+      std::shared_ptr<TDetector> output;
+      if(slot < fSpare.size() && fSpare[slot] != nullptr) {
+         output = std::move(fSpare[slot]);
+      } else {
+         output.reset(static_cast<TDetector*>(cls->New()));
+      }
+      if(fSlots.size() <= slot) {
+         fSlots.resize(slot + 1);
+      }
+      fSlots[slot] = output;
       fDetectors.push_back(output);
       return output;
    }
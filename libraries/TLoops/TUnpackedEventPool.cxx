@@ -0,0 +1,58 @@
+#include "TUnpackedEventPool.h"
+
+std::shared_ptr<TUnpackedEventPool> TUnpackedEventPool::Create(size_t maxSize)
+{
+   // the events handed out keep a reference to the pool, so it has to be owned by a shared pointer
+   return std::shared_ptr<TUnpackedEventPool>(new TUnpackedEventPool(maxSize));
+}
+
+TUnpackedEventPool::TUnpackedEventPool(size_t maxSize) : fMaxSize(maxSize)
+{
+   fFree.reserve(fMaxSize);
+}
+
+TUnpackedEventPool::~TUnpackedEventPool()
+{
+   for(auto* event : fFree) {
+      delete event;
+   }
+   for(auto* event : fReturned) {
+      delete event;
+   }
+}
+
+TUnpackedEvent* TUnpackedEventPool::Take()
+{
+   if(fFree.empty()) {
+      std::lock_guard<std::mutex> lock(fReturnMutex);
+      fFree.swap(fReturned);
+   }
+   if(fFree.empty()) {
+      ++fAllocated;
+      return new TUnpackedEvent;
+   }
+   TUnpackedEvent* event = fFree.back();
+   fFree.pop_back();
+   ++fRecycled;
+   return event;
+}
+
+void TUnpackedEventPool::Return(TUnpackedEvent* event)
+{
+   // clearing the event here moves the work to the thread releasing it
+   event->Clear();
+   {
+      std::lock_guard<std::mutex> lock(fReturnMutex);
+      if(fReturned.size() < fMaxSize) {
+         fReturned.push_back(event);
+         return;
+      }
+   }
+   delete event;
+}
+
+std::shared_ptr<TUnpackedEvent> TUnpackedEventPool::Get()
+{
+   std::shared_ptr<TUnpackedEventPool> pool = shared_from_this();
+   return std::shared_ptr<TUnpackedEvent>(Take(), [pool](TUnpackedEvent* event) { pool->Return(event); });
+}
@@ -5,6 +5,7 @@
 #include <sstream>
 #include <memory>
 
+#include "TChannel.h"
 #include "TGRSIOptions.h"
 #include "TLstEvent.h"
 #include "TMidasEvent.h"
@@ -24,11 +25,22 @@ TUnpackingLoop* TUnpackingLoop::Get(std::string name)
 
 TUnpackingLoop::TUnpackingLoop(std::string name)
    : StoppableThread(name), fInputQueue(std::make_shared<ThreadsafeQueue<std::shared_ptr<TRawEvent>>>()),
-     fFragsReadFromRaw(0), fGoodFragsRead(0), fEvaluateDataType(true), fDataType(kMidas)
+     fFragsReadFromRaw(0), fGoodFragsRead(0), fEvaluateDataType(true), fDataType(kMidas), fNoWaveforms(false), fRecordDiag(true)
 {
+   fNofWorkers = TGRSIOptions::Get()->UnpackingThreads();
+   if(fNofWorkers <= 0) {
+      fNofWorkers = std::thread::hardware_concurrency();
+   }
+   if(fNofWorkers <= 0) {
+      fNofWorkers = 1;
+   }
+   fWorkers.SetStatusVariables(&fItemsPopped, &fInputSize);
 }
 
-TUnpackingLoop::~TUnpackingLoop() = default;
+TUnpackingLoop::~TUnpackingLoop()
+{
+   fWorkers.Stop();
+}
 
 void TUnpackingLoop::ClearQueue()
 {
@@ -37,13 +49,24 @@ void TUnpackingLoop::ClearQueue()
       fInputQueue->Pop(singleEvent);
    }
 
+   fWorkers.Clear();
+
    fParser.ClearQueue();
 }
 
+void TUnpackingLoop::OnEnd()
+{
+   fWorkers.Stop();
+}
+
 bool TUnpackingLoop::Iteration()
 {
+   if(fWorkers.IsStarted()) {
+      return ReleaseParsedEvents();
+   }
+
    std::shared_ptr<TRawEvent> event;
-   int                        error = fInputQueue->Pop(event);
+   int                        error = fInputQueue->Pop(event, 0);
    if(error < 0) {
       fInputSize = 0;
       if(fInputQueue->IsFinished()) {
@@ -54,7 +77,8 @@ bool TUnpackingLoop::Iteration()
          return false;
       }
       // Wait for the source to give more data.
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      WakeOn(fInputQueue);
+      WaitForInput();
       return true;
    }
    if(fEvaluateDataType) {
@@ -70,6 +94,55 @@ bool TUnpackingLoop::Iteration()
 
    fFragsReadFromRaw += event->Process(fParser);
    fGoodFragsRead += event->GoodFrags();
+   // push the fragments of this event now, otherwise they'd wait for the next event to fill up the batch
+   fParser.Flush();
+
+   // lst chunks are parsed on this thread, only midas events are spread over several threads
+   // the first event has already been parsed here, so the workers start with the second one
+   if(fDataType == kMidas && fNofWorkers > 1) {
+      StartWorkers();
+   }
+
+   return true;
+}
+
+void TUnpackingLoop::StartWorkers()
+{
+   /// The workers parse midas events with a deferred parser each. Only the events themselves are parsed there,
+   /// the output is released in order on the thread of the loop.
+   fWorkers.Start(fInputQueue, fNofWorkers, 32 * static_cast<size_t>(fNofWorkers), [this]() {
+      auto parser = std::make_shared<TDataParser>();
+      parser->SetNoWaveForms(fNoWaveforms);
+      parser->SetRecordDiag(fRecordDiag);
+      parser->SetDeferredOutput();
+      return [parser](std::shared_ptr<TRawEvent>& event) {
+         TChannel::ReaderCheckpoint();
+         TParsedEvent parsed;
+         parsed.fFrags     = event->Process(*parser);
+         parsed.fGoodFrags = event->GoodFrags();
+         parsed.fEntries.swap(parser->DeferredEntries());
+         return parsed;
+      };
+   });
+}
+
+bool TUnpackingLoop::ReleaseParsedEvents()
+{
+   /// Releases all parsed events that are next in line to fParser. Returns false once all workers are done
+   /// and all their events have been released.
+   std::vector<TParsedEvent> events;
+   if(!fWorkers.Release(events)) {
+      fParser.SetFinished();
+      BadOutputQueue()->SetFinished();
+      ScalerOutputQueue()->SetFinished();
+      return false;
+   }
+
+   for(auto& parsed : events) {
+      fParser.Release(parsed.fEntries);
+      fFragsReadFromRaw += parsed.fFrags;
+      fGoodFragsRead += parsed.fGoodFrags;
+   }
 
    return true;
 }
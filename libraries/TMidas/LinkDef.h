@@ -1,4 +1,4 @@
-// TXMLOdb.h TRawEvent.h TRawFile.h TMidasEvent.h TMidasFile.h TLstEvent.h TLstFile.h
+// TXMLOdb.h TRawEvent.h TRawFile.h TMidasEvent.h TMidasFile.h TMidasRing.h TLstEvent.h TLstFile.h
 
 
 #ifdef __CINT__
@@ -17,6 +17,7 @@
 #pragma link C++ class TRawFile+;
 #pragma link C++ class TMidasEvent+;
 #pragma link C++ class TMidasFile+;
+#pragma link C++ class TMidasRing+;
 #pragma link C++ class TLstEvent+;
 #pragma link C++ class TLstFile+;
 
@@ -0,0 +1,665 @@
+#include "TDecompressor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAS_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+
+const size_t TDecompressor::fStreamChunkSize = 4 * 1024 * 1024;
+const size_t TDecompressor::fMaxBlockSize    = 64 * 1024 * 1024;
+
+TDecompressor::TDecompressor(const char* filename, EFormat format, int nofThreads, size_t ringSize)
+   : fFile(nullptr), fFormat(format), fRing(ringSize), fWriteIndex(0), fReadIndex(0), fEndOfInput(false),
+     fStop(false), fCompressedBytesRead(0)
+{
+   fFile = std::fopen(filename, "rb");
+   if(fFile == nullptr) {
+      fError      = std::strerror(errno);
+      fEndOfInput = true;
+      return;
+   }
+   if(!IsSupported(format)) {
+      fError      = "compression format not supported by this build";
+      fEndOfInput = true;
+      return;
+   }
+
+   fReader = std::thread(&TDecompressor::ReaderLoop, this);
+
+   // bzip2 streams can't be split into independent blocks, so they are always decompressed by the reader thread
+   if(format != EFormat::kBzip2) {
+      if(nofThreads <= 0) {
+         nofThreads = std::max(1U, std::thread::hardware_concurrency());
+      }
+      for(int i = 0; i < nofThreads; ++i) {
+         fWorkers.emplace_back(&TDecompressor::WorkerLoop, this);
+      }
+   }
+}
+
+TDecompressor::~TDecompressor()
+{
+   {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fStop = true;
+   }
+   fChunkFree.notify_all();
+   fChunkCompressed.notify_all();
+   fChunkReady.notify_all();
+   if(fReader.joinable()) {
+      fReader.join();
+   }
+   for(auto& worker : fWorkers) {
+      worker.join();
+   }
+   if(fFile != nullptr) {
+      std::fclose(fFile);
+   }
+}
+
+bool TDecompressor::IsSupported(EFormat format)
+{
+   switch(format) {
+#ifdef HAVE_ZLIB
+   case EFormat::kGzip: return true;
+#endif
+#ifdef HAS_BZIP2
+   case EFormat::kBzip2: return true;
+#endif
+#ifdef HAS_ZSTD
+   case EFormat::kZstd: return true;
+#endif
+   default: return false;
+   }
+}
+
+bool TDecompressor::FormatFromName(const std::string& filename, EFormat& format)
+{
+   /// Determines the compression format from the suffix of the file name, returns false if it's not a known one.
+   size_t dotPos = filename.find_last_of('.');
+   if(dotPos == std::string::npos) {
+      return false;
+   }
+   std::string ext = filename.substr(dotPos + 1);
+   if(ext == "gz") {
+      format = EFormat::kGzip;
+      return true;
+   }
+   if(ext == "bz2") {
+      format = EFormat::kBzip2;
+      return true;
+   }
+   if(ext == "zst") {
+      format = EFormat::kZstd;
+      return true;
+   }
+   return false;
+}
+
+size_t TDecompressor::Read(char* buffer, size_t length)
+{
+   size_t total = 0;
+   while(total < length) {
+      TChunk* chunk = nullptr;
+      {
+         std::unique_lock<std::mutex> lock(fMutex);
+         fChunkReady.wait(lock, [this] {
+            return (fReadIndex < fWriteIndex && fRing[fReadIndex % fRing.size()].fState == EChunkState::kReady) ||
+                   (fEndOfInput && fReadIndex == fWriteIndex) || fStop;
+         });
+         if(fReadIndex == fWriteIndex || fRing[fReadIndex % fRing.size()].fState != EChunkState::kReady) {
+            // end of data or an error occured
+            break;
+         }
+         chunk = &fRing[fReadIndex % fRing.size()];
+      }
+
+      size_t bytes = std::min(length - total, chunk->fData.size() - chunk->fReadPosition);
+      std::memcpy(buffer + total, chunk->fData.data() + chunk->fReadPosition, bytes);
+      chunk->fReadPosition += bytes;
+      total += bytes;
+
+      if(chunk->fReadPosition == chunk->fData.size()) {
+         // we're done with this chunk, so we release it for the reader (keeping the memory allocated)
+         std::lock_guard<std::mutex> lock(fMutex);
+         chunk->fData.clear();
+         chunk->fCompressed.clear();
+         chunk->fReadPosition = 0;
+         chunk->fState        = EChunkState::kEmpty;
+         ++fReadIndex;
+         fChunkFree.notify_one();
+      }
+   }
+
+   return total;
+}
+
+bool TDecompressor::Good() const
+{
+   // the error is set by the reader and worker threads
+   std::lock_guard<std::mutex> lock(fMutex);
+   return fError.empty();
+}
+
+std::string TDecompressor::GetLastError() const
+{
+   std::lock_guard<std::mutex> lock(fMutex);
+   return fError;
+}
+
+void TDecompressor::SetError(const std::string& error)
+{
+   {
+      std::lock_guard<std::mutex> lock(fMutex);
+      if(fError.empty()) {
+         fError = error;
+      }
+      fStop = true;
+   }
+   fChunkFree.notify_all();
+   fChunkCompressed.notify_all();
+   fChunkReady.notify_all();
+}
+
+////////////////////////////// reader thread //////////////////////////////
+
+void TDecompressor::ReaderLoop()
+{
+   std::vector<char> buffer;
+   switch(fFormat) {
+   case EFormat::kGzip: SplitGzip(buffer); break;
+   case EFormat::kBzip2: StreamBzip2(buffer); break;
+   case EFormat::kZstd: SplitZstd(buffer); break;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fEndOfInput = true;
+   }
+   fChunkCompressed.notify_all();
+   fChunkReady.notify_all();
+}
+
+bool TDecompressor::ReadInput(std::vector<char>& buffer, size_t bytes)
+{
+   /// Appends up to bytes bytes from the input file to the buffer, returns false if nothing could be read.
+   size_t initialSize = buffer.size();
+   buffer.resize(initialSize + bytes);
+   size_t rd = std::fread(buffer.data() + initialSize, 1, bytes, fFile);
+   buffer.resize(initialSize + rd);
+   fCompressedBytesRead += rd;
+
+   if(rd == 0 && std::ferror(fFile) != 0) {
+      SetError(std::strerror(errno));
+   }
+
+   return rd > 0;
+}
+
+bool TDecompressor::ReserveChunk(TChunk*& chunk)
+{
+   /// Waits until the next chunk of the ring is free, returns false if we are supposed to stop.
+   std::unique_lock<std::mutex> lock(fMutex);
+   fChunkFree.wait(lock, [this] { return fWriteIndex - fReadIndex < fRing.size() || fStop; });
+   if(fStop) {
+      return false;
+   }
+   chunk = &fRing[fWriteIndex % fRing.size()];
+
+   return true;
+}
+
+void TDecompressor::PublishChunk(EChunkState state)
+{
+   {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fRing[fWriteIndex % fRing.size()].fState = state;
+      ++fWriteIndex;
+   }
+   if(state == EChunkState::kCompressed) {
+      fChunkCompressed.notify_one();
+   } else {
+      fChunkReady.notify_all();
+   }
+}
+
+size_t TDecompressor::GzipMemberSize(std::vector<char>& buffer)
+{
+   /// Returns the size of the gzip member at the start of the buffer if it is a bgzf-style member
+   /// (with the size stored in the "BC" extra field), or 0 otherwise.
+   if(buffer.size() < 12) {
+      ReadInput(buffer, 12 - buffer.size());
+   }
+   if(buffer.size() < 12) {
+      return 0;
+   }
+   const unsigned char* header = reinterpret_cast<const unsigned char*>(buffer.data());
+   if(header[0] != 0x1f || header[1] != 0x8b || header[2] != 8 || (header[3] & 0x4) == 0) {
+      return 0;
+   }
+   size_t extraLength = header[10] | (header[11] << 8);
+   if(buffer.size() < 12 + extraLength) {
+      ReadInput(buffer, 12 + extraLength - buffer.size());
+      header = reinterpret_cast<const unsigned char*>(buffer.data());
+   }
+   if(buffer.size() < 12 + extraLength) {
+      return 0;
+   }
+   // loop over all sub-fields of the extra field
+   for(size_t pos = 12; pos + 4 <= 12 + extraLength;) {
+      size_t subLength = header[pos + 2] | (header[pos + 3] << 8);
+      if(header[pos] == 'B' && header[pos + 1] == 'C' && subLength == 2 && pos + 6 <= 12 + extraLength) {
+         return (header[pos + 4] | (header[pos + 5] << 8)) + 1;
+      }
+      pos += 4 + subLength;
+   }
+
+   return 0;
+}
+
+bool TDecompressor::SplitGzip(std::vector<char>& buffer)
+{
+   /// Splits bgzf-style gzip files into members that get decompressed by the workers.
+   /// Any other gzip file gets decompressed as a single stream.
+   while(!fStop) {
+      if(buffer.empty() && !ReadInput(buffer, fStreamChunkSize)) {
+         return true;
+      }
+      size_t memberSize = GzipMemberSize(buffer);
+      if(memberSize == 0) {
+         return StreamGzip(buffer);
+      }
+      if(buffer.size() < memberSize) {
+         ReadInput(buffer, std::max(memberSize - buffer.size(), fStreamChunkSize));
+      }
+      if(buffer.size() < memberSize) {
+         SetError("truncated gzip member");
+         return false;
+      }
+      TChunk* chunk = nullptr;
+      if(!ReserveChunk(chunk)) {
+         return false;
+      }
+      chunk->fCompressed.assign(buffer.begin(), buffer.begin() + memberSize);
+      buffer.erase(buffer.begin(), buffer.begin() + memberSize);
+      PublishChunk(EChunkState::kCompressed);
+   }
+
+   return false;
+}
+
+bool TDecompressor::SplitZstd(std::vector<char>& buffer)
+{
+   /// Splits zstd files into frames that get decompressed by the workers. If a frame is larger than
+   /// fMaxBlockSize (e.g. a file compressed as a single frame) the rest is decompressed as a single stream.
+#ifdef HAS_ZSTD
+   while(!fStop) {
+      if(buffer.empty() && !ReadInput(buffer, fStreamChunkSize)) {
+         return true;
+      }
+      size_t frameSize = ZSTD_findFrameCompressedSize(buffer.data(), buffer.size());
+      if(ZSTD_isError(frameSize) != 0u) {
+         // incomplete frame
+         if(buffer.size() >= fMaxBlockSize) {
+            return StreamZstd(buffer);
+         }
+         if(!ReadInput(buffer, buffer.size())) {
+            SetError("truncated zstd frame");
+            return false;
+         }
+         continue;
+      }
+      TChunk* chunk = nullptr;
+      if(!ReserveChunk(chunk)) {
+         return false;
+      }
+      chunk->fCompressed.assign(buffer.begin(), buffer.begin() + frameSize);
+      buffer.erase(buffer.begin(), buffer.begin() + frameSize);
+      PublishChunk(EChunkState::kCompressed);
+   }
+#else
+   (void)buffer;
+#endif
+   return false;
+}
+
+bool TDecompressor::StreamGzip(std::vector<char>& buffer)
+{
+#ifdef HAVE_ZLIB
+   z_stream stream;
+   std::memset(&stream, 0, sizeof(stream));
+   if(inflateInit2(&stream, 15 + 32) != Z_OK) { // 15 + 32: maximum window size, automatic header detection
+      SetError("zlib inflateInit2() error");
+      return false;
+   }
+   stream.next_in  = reinterpret_cast<Bytef*>(buffer.data());
+   stream.avail_in = buffer.size();
+   auto refill     = [&]() -> bool {
+      buffer.clear();
+      if(!ReadInput(buffer, fStreamChunkSize)) {
+         return false;
+      }
+      stream.next_in  = reinterpret_cast<Bytef*>(buffer.data());
+      stream.avail_in = buffer.size();
+      return true;
+   };
+
+   bool endOfFile = false;
+   bool truncated = false;
+   while(!endOfFile && !truncated) {
+      TChunk* chunk = nullptr;
+      if(!ReserveChunk(chunk)) {
+         inflateEnd(&stream);
+         return false;
+      }
+      chunk->fData.resize(fStreamChunkSize);
+      stream.next_out  = reinterpret_cast<Bytef*>(chunk->fData.data());
+      stream.avail_out = chunk->fData.size();
+      while(stream.avail_out > 0) {
+         // without more input inflate() can still flush what it has decompressed already
+         bool     noInput  = stream.avail_in == 0 && !refill();
+         unsigned availOut = stream.avail_out;
+         int      ret      = inflate(&stream, Z_NO_FLUSH);
+         if(ret == Z_STREAM_END) {
+            // there might be another gzip member following this one
+            if(stream.avail_in == 0 && !refill()) {
+               endOfFile = true;
+               break;
+            }
+            inflateReset(&stream);
+         } else if(ret != Z_OK && ret != Z_BUF_ERROR) {
+            SetError(stream.msg != nullptr ? stream.msg : "zlib inflate() error");
+            inflateEnd(&stream);
+            return false;
+         } else if(noInput && stream.avail_out == availOut) {
+            // the input ended before the stream did
+            truncated = true;
+            break;
+         }
+      }
+      chunk->fData.resize(chunk->fData.size() - stream.avail_out);
+      PublishChunk(EChunkState::kReady);
+   }
+   inflateEnd(&stream);
+   if(truncated) {
+      SetError("truncated gzip stream");
+      return false;
+   }
+
+   return true;
+#else
+   (void)buffer;
+   return false;
+#endif
+}
+
+bool TDecompressor::StreamBzip2(std::vector<char>& buffer)
+{
+#ifdef HAS_BZIP2
+   bz_stream stream;
+   std::memset(&stream, 0, sizeof(stream));
+   if(BZ2_bzDecompressInit(&stream, 0, 0) != BZ_OK) {
+      SetError("bzip2 BZ2_bzDecompressInit() error");
+      return false;
+   }
+   stream.next_in  = buffer.data();
+   stream.avail_in = buffer.size();
+   auto refill     = [&]() -> bool {
+      buffer.clear();
+      if(!ReadInput(buffer, fStreamChunkSize)) {
+         return false;
+      }
+      stream.next_in  = buffer.data();
+      stream.avail_in = buffer.size();
+      return true;
+   };
+
+   bool endOfFile = false;
+   bool truncated = false;
+   while(!endOfFile && !truncated) {
+      TChunk* chunk = nullptr;
+      if(!ReserveChunk(chunk)) {
+         BZ2_bzDecompressEnd(&stream);
+         return false;
+      }
+      chunk->fData.resize(fStreamChunkSize);
+      stream.next_out  = chunk->fData.data();
+      stream.avail_out = chunk->fData.size();
+      while(stream.avail_out > 0) {
+         // without more input BZ2_bzDecompress() can still flush what it has decompressed already
+         bool     noInput  = stream.avail_in == 0 && !refill();
+         unsigned availOut = stream.avail_out;
+         int      ret      = BZ2_bzDecompress(&stream);
+         if(ret == BZ_STREAM_END) {
+            // parallel compressors (pbzip2, lbzip2) write multiple concatenated streams
+            if(stream.avail_in == 0 && !refill()) {
+               endOfFile = true;
+               break;
+            }
+            bz_stream next;
+            std::memset(&next, 0, sizeof(next));
+            next.next_in   = stream.next_in;
+            next.avail_in  = stream.avail_in;
+            next.next_out  = stream.next_out;
+            next.avail_out = stream.avail_out;
+            BZ2_bzDecompressEnd(&stream);
+            stream = next;
+            if(BZ2_bzDecompressInit(&stream, 0, 0) != BZ_OK) {
+               SetError("bzip2 BZ2_bzDecompressInit() error");
+               return false;
+            }
+         } else if(ret != BZ_OK) {
+            SetError("bzip2 BZ2_bzDecompress() error");
+            BZ2_bzDecompressEnd(&stream);
+            return false;
+         } else if(noInput && stream.avail_out == availOut) {
+            // the input ended before the stream did
+            truncated = true;
+            break;
+         }
+      }
+      chunk->fData.resize(chunk->fData.size() - stream.avail_out);
+      PublishChunk(EChunkState::kReady);
+   }
+   BZ2_bzDecompressEnd(&stream);
+   if(truncated) {
+      SetError("truncated bzip2 stream");
+      return false;
+   }
+
+   return true;
+#else
+   (void)buffer;
+   return false;
+#endif
+}
+
+bool TDecompressor::StreamZstd(std::vector<char>& buffer)
+{
+#ifdef HAS_ZSTD
+   ZSTD_DStream* stream = ZSTD_createDStream();
+   ZSTD_initDStream(stream);
+   ZSTD_inBuffer input = {buffer.data(), buffer.size(), 0};
+   auto          refill = [&]() -> bool {
+      buffer.clear();
+      if(!ReadInput(buffer, fStreamChunkSize)) {
+         return false;
+      }
+      input = {buffer.data(), buffer.size(), 0};
+      return true;
+   };
+
+   bool   endOfFile = false;
+   size_t ret       = 1; // non-zero as long as the current frame isn't complete
+   while(!endOfFile) {
+      TChunk* chunk = nullptr;
+      if(!ReserveChunk(chunk)) {
+         ZSTD_freeDStream(stream);
+         return false;
+      }
+      chunk->fData.resize(fStreamChunkSize);
+      ZSTD_outBuffer output = {chunk->fData.data(), chunk->fData.size(), 0};
+      while(output.pos < output.size) {
+         // without more input ZSTD_decompressStream() can still flush what it has decompressed already
+         bool   noInput   = input.pos == input.size && !refill();
+         size_t outputPos = output.pos;
+         if(noInput && ret == 0) {
+            endOfFile = true;
+            break;
+         }
+         // concatenated frames are handled by ZSTD_decompressStream itself
+         ret = ZSTD_decompressStream(stream, &output, &input);
+         if(ZSTD_isError(ret) != 0u) {
+            SetError(ZSTD_getErrorName(ret));
+            ZSTD_freeDStream(stream);
+            return false;
+         }
+         if(noInput && output.pos == outputPos) {
+            // the input ended before the frame did
+            endOfFile = true;
+            break;
+         }
+      }
+      chunk->fData.resize(output.pos);
+      PublishChunk(EChunkState::kReady);
+   }
+   ZSTD_freeDStream(stream);
+   if(ret != 0) {
+      SetError("truncated zstd stream");
+      return false;
+   }
+
+   return true;
+#else
+   (void)buffer;
+   return false;
+#endif
+}
+
+////////////////////////////// worker threads //////////////////////////////
+
+void TDecompressor::WorkerLoop()
+{
+   while(true) {
+      TChunk* chunk = nullptr;
+      {
+         std::unique_lock<std::mutex> lock(fMutex);
+         fChunkCompressed.wait(lock, [&] {
+            if(fStop) {
+               return true;
+            }
+            for(size_t index = fReadIndex; index < fWriteIndex; ++index) {
+               if(fRing[index % fRing.size()].fState == EChunkState::kCompressed) {
+                  chunk = &fRing[index % fRing.size()];
+                  return true;
+               }
+            }
+            return fEndOfInput;
+         });
+         if(chunk == nullptr) {
+            return;
+         }
+         chunk->fState = EChunkState::kDecompressing;
+      }
+
+      std::string error;
+      if(!Decompress(chunk->fCompressed, chunk->fData, error)) {
+         SetError(error);
+         return;
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(fMutex);
+         chunk->fState = EChunkState::kReady;
+      }
+      fChunkReady.notify_all();
+   }
+}
+
+bool TDecompressor::Decompress(const std::vector<char>& input, std::vector<char>& output, std::string& error)
+{
+   /// Decompresses one independent block (a bgzf member or a zstd frame).
+   switch(fFormat) {
+   case EFormat::kGzip: {
+#ifdef HAVE_ZLIB
+      // the uncompressed size (modulo 2^32) is stored in the last four bytes of the member
+      const unsigned char* trailer = reinterpret_cast<const unsigned char*>(input.data() + input.size() - 4);
+      size_t size = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (static_cast<size_t>(trailer[3]) << 24);
+      output.resize(size);
+      if(size == 0) {
+         return true;
+      }
+      z_stream stream;
+      std::memset(&stream, 0, sizeof(stream));
+      if(inflateInit2(&stream, 15 + 16) != Z_OK) { // 15 + 16: maximum window size, gzip header
+         error = "zlib inflateInit2() error";
+         return false;
+      }
+      stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+      stream.avail_in  = input.size();
+      stream.next_out  = reinterpret_cast<Bytef*>(output.data());
+      stream.avail_out = output.size();
+      int ret          = inflate(&stream, Z_FINISH);
+      inflateEnd(&stream);
+      if(ret != Z_STREAM_END) {
+         error = "corrupt gzip member";
+         return false;
+      }
+      return true;
+#else
+      break;
+#endif
+   }
+   case EFormat::kZstd: {
+#ifdef HAS_ZSTD
+      unsigned long long size = ZSTD_getFrameContentSize(input.data(), input.size());
+      if(size != ZSTD_CONTENTSIZE_UNKNOWN && size != ZSTD_CONTENTSIZE_ERROR) {
+         output.resize(size);
+         size_t ret = ZSTD_decompress(output.data(), output.size(), input.data(), input.size());
+         if(ZSTD_isError(ret) != 0u) {
+            error = ZSTD_getErrorName(ret);
+            return false;
+         }
+         output.resize(ret);
+         return true;
+      }
+      // unknown content size, so we have to decompress it as a stream
+      ZSTD_DStream* stream = ZSTD_createDStream();
+      ZSTD_initDStream(stream);
+      ZSTD_inBuffer in = {input.data(), input.size(), 0};
+      output.clear();
+      while(in.pos < in.size) {
+         size_t oldSize = output.size();
+         output.resize(oldSize + ZSTD_DStreamOutSize());
+         ZSTD_outBuffer out = {output.data() + oldSize, output.size() - oldSize, 0};
+         size_t         ret = ZSTD_decompressStream(stream, &out, &in);
+         output.resize(oldSize + out.pos);
+         if(ZSTD_isError(ret) != 0u) {
+            error = ZSTD_getErrorName(ret);
+            ZSTD_freeDStream(stream);
+            return false;
+         }
+      }
+      ZSTD_freeDStream(stream);
+      return true;
+#else
+      break;
+#endif
+   }
+   case EFormat::kBzip2: break;
+   }
+
+   (void)input;
+   (void)output;
+   error = "can't decompress independent blocks of this format";
+   return false;
+}
@@ -16,7 +16,7 @@
 ClassImp(TLstEvent)
 /// \endcond
 
-TLstEvent::TLstEvent()
+TLstEvent::TLstEvent() : fExternalData(nullptr), fExternalSize(0)
 {
    // Default constructor
    fData.resize(0);
@@ -24,11 +24,14 @@ TLstEvent::TLstEvent()
 
 void TLstEvent::Copy(TObject& rhs) const
 {
-   // Copies the entire TLstEvent.
-   static_cast<TLstEvent&>(rhs).fData = fData;
+   // Copies the entire TLstEvent, external data is shared, not copied.
+   static_cast<TLstEvent&>(rhs).fData         = fData;
+   static_cast<TLstEvent&>(rhs).fExternalData = fExternalData;
+   static_cast<TLstEvent&>(rhs).fExternalSize = fExternalSize;
+   static_cast<TLstEvent&>(rhs).fDataOwner    = fDataOwner;
 }
 
-TLstEvent::TLstEvent(const TLstEvent& rhs) : TRawEvent()
+TLstEvent::TLstEvent(const TLstEvent& rhs) : TRawEvent(), fExternalData(nullptr), fExternalSize(0)
 {
    // Copy ctor.
    rhs.Copy(*this);
@@ -53,24 +56,46 @@ void TLstEvent::Clear(Option_t*)
 {
    // Clears the TLstEvent.
    fData.clear();
+   fExternalData = nullptr;
+   fExternalSize = 0;
+   fDataOwner.reset();
 }
 
 void TLstEvent::SetData(std::vector<char>& buffer)
 {
    // Sets the data in the TLstEvent as the data argument passed into
    // this function.
+   Clear();
    fData = buffer;
    SwapBytes(false);
 }
 
+void TLstEvent::SetData(size_t size, char* data, const std::shared_ptr<char>& owner)
+{
+   // Sets the data in the TLstEvent to point into an external buffer
+   // without copying it. The owner keeps the buffer alive for as long as
+   // this event references it (used for chunks of memory mapped lst files).
+   Clear();
+   fExternalData = data;
+   fExternalSize = size;
+   fDataOwner    = owner;
+   SwapBytes(false);
+}
+
 uint32_t TLstEvent::GetDataSize() const
 {
+   if(fExternalData != nullptr) {
+      return fExternalSize;
+   }
    return fData.size();
 }
 
 char* TLstEvent::GetData()
 {
-   // returns the allocated data.
+   // returns the data (external or allocated).
+   if(fExternalData != nullptr) {
+      return fExternalData;
+   }
    return fData.data();
 }
 
@@ -83,8 +108,9 @@ void TLstEvent::Print(const char* option) const
 
    printf("Event start:\n");
    if(option[0] == 'a') {
-      for(size_t i = 0; i < fData.size() / 4; ++i) {
-         printf("0x%08x", ((uint32_t*)fData.data())[i]);
+      const char* data = (fExternalData != nullptr) ? fExternalData : fData.data();
+      for(size_t i = 0; i < GetDataSize() / 4; ++i) {
+         printf("0x%08x", ((const uint32_t*)data)[i]);
          if(i % 10 == 9) {
             printf("\n");
          } else {
@@ -149,7 +175,7 @@ int TLstEvent::Process(TDataParser& parser)
    /// Returns the total number of fragments read (good and bad).
    // right now the parser only returns the total number of fragments read
    // so we assume (for now) that all fragments are good fragments
-   fGoodFrags = parser.FippsToFragment(fData);
+   fGoodFrags = parser.FippsToFragment(GetData(), GetDataSize());
    return fGoodFrags;
 }
 
@@ -4,10 +4,13 @@
 #include <cstring>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <cerrno>
 #include <cassert>
 #include <cstdlib>
+#include <algorithm>
 
 #ifdef HAVE_ZLIB
 #include <zlib.h>
@@ -24,7 +27,12 @@
 ClassImp(TLstFile)
 /// \endcond
 
-TLstFile::TLstFile()
+// the first 9 words (= 36 bytes) seem to be a kind of header
+static const size_t gLstHeaderSize = 36;
+// each record is 4 words (= 16 bytes)
+static const size_t gLstRecordSize = 16;
+
+TLstFile::TLstFile() : fChunkSize(gLstRecordSize << 20)
 {
    // Default Constructor
    fBytesRead = 0;
@@ -52,85 +60,124 @@ std::string TLstFile::Status(bool)
                (fBytesRead / 1000000.0), (fFileSize / 1000000.0));
 }
 
-/// Open a midas .mid file with given file name.
-///
-/// Remote files can be accessed using these special file names:
-/// - pipein://command - read data produced by given command, see examples below
-/// - ssh://username\@hostname/path/file.mid - read remote file through an ssh pipe
-/// - ssh://username\@hostname/path/file.mid.gz and file.mid.bz2 - same for compressed files
-/// - dccp://path/file.mid (also file.mid.gz and file.mid.bz2) - read data from dcache, requires dccp in the PATH
-///
-/// Examples:
-/// - ./event_dump.exe /ladd/data9/t2km11/data/run02696.mid.gz - read normal compressed file
-/// - ./event_dump.exe ssh://ladd09//ladd/data9/t2km11/data/run02696.mid.gz - read compressed file through ssh to ladd09
-/// (note double "/")
-/// - ./event_dump.exe pipein://"cat /ladd/data9/t2km11/data/run02696.mid.gz | gzip -dc" - read data piped from a
-/// command or script (note quotes)
-/// - ./event_dump.exe pipein://"gzip -dc /ladd/data9/t2km11/data/run02696.mid.gz" - another way to read compressed
-/// files
-/// - ./event_dump.exe dccp:///pnfs/triumf.ca/data/t2km11/aug2008/run02837.mid.gz - read file directly from a dcache
-/// pool (note triple "/")
+/// Open a lst file with given file name. The file is memory mapped, the data is only
+/// read once the chunks are accessed.
 ///
 /// \param[in] filename The file to open.
-/// \returns "true" for succes, "false" for error, use GetLastError() to see why
+/// \returns "true" for succes, "false" for error
 bool TLstFile::Open(const char* filename)
 {
+   Close();
    fFilename = filename;
-   // the first 9 words (= 36 bytes) seem to be a kind of header
-   int headerSize = 36;
-   try {
-      std::ifstream in(GetFilename(), std::ifstream::in | std::ifstream::binary);
-      in.seekg(0, std::ifstream::end);
-      if(in.tellg() < 0) {
-         std::cout<<R"(Failed to open ")"<<GetFilename()<<"/"<<fFilename<<R"("!)"<<std::endl;
-         return false;
-      }
-      fFileSize = in.tellg();
-      fReadBuffer.resize(fFileSize - headerSize);
-      in.seekg(headerSize, std::ifstream::beg);
-      in.read(fReadBuffer.data(), fFileSize);
-      in.close();
-
-   } catch(std::exception& e) {
-      std::cout<<"Caught "<<e.what()<<std::endl;
-   }
-// Do we need these?
-// signal(SIGPIPE,SIG_IGN); // crash if reading from closed pipe
-// signal(SIGXFSZ,SIG_IGN); // crash if reading from file >2GB without O_LARGEFILE
 
 #ifndef O_LARGEFILE
 #define O_LARGEFILE 0
 #endif
 
+   int file = open(GetFilename(), O_RDONLY | O_LARGEFILE);
+   if(file < 0) {
+      std::cout<<R"(Failed to open ")"<<GetFilename()<<R"(": )"<<std::strerror(errno)<<std::endl;
+      return false;
+   }
+   struct stat fileStat;
+   if(fstat(file, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) ||
+      static_cast<size_t>(fileStat.st_size) <= gLstHeaderSize) {
+      std::cout<<R"(")"<<GetFilename()<<R"(" is not a regular file or too small to hold any data!)"<<std::endl;
+      close(file);
+      return false;
+   }
+
+   size_t size = static_cast<size_t>(fileStat.st_size);
+   void*  addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+   // the mapping stays valid after the file is closed
+   close(file);
+   if(addr == MAP_FAILED) {
+      std::cout<<R"(Failed to map ")"<<GetFilename()<<R"(": )"<<std::strerror(errno)<<std::endl;
+      return false;
+   }
+#ifdef MADV_SEQUENTIAL
+   madvise(addr, size, MADV_SEQUENTIAL);
+#endif
+
+   fMappedFile.reset(static_cast<char*>(addr), [size](char* ptr) { munmap(ptr, size); });
+   fMappedSize   = size;
+   fMappedOffset = gLstHeaderSize;
+   fFileSize     = size;
+   fBytesRead    = 0;
+
    TGRSIRunInfo::SetRunInfo(GetRunNumber(), GetSubRunNumber());
    TGRSIRunInfo::SetGRSIVersion(GRSI_RELEASE);
 
-   std::cout<<"Successfully read "<<fFileSize - headerSize<<" bytes into buffer!"<<std::endl;
-
    return true;
 }
 
 void TLstFile::Close()
 {
+   // events still pointing into the mapping keep it alive
+   fMappedFile.reset();
+   fMappedSize   = 0;
+   fMappedOffset = 0;
 }
 
-/// \param [in] midasEvent Pointer to an empty TLstEvent
-/// \returns "true" for success, "false" for failure, see GetLastError() to see why
-///
-///  EDITED FROM THE ORIGINAL TO RETURN TOTAL SUCESSFULLY BYTES READ INSTEAD OF TRUE/FALSE,  PCB
+void TLstFile::Prefetch()
+{
+   /// Asks the kernel to start reading the mapped file in the background.
+#ifdef MADV_WILLNEED
+   if(fMappedFile != nullptr) {
+      madvise(fMappedFile.get(), fMappedSize, MADV_WILLNEED);
+   }
+#endif
+}
+
+void TLstFile::SetChunkSize(size_t size)
+{
+   /// Sets the number of bytes each event covers, rounded down to whole records (at least one).
+   fChunkSize = std::max(size / gLstRecordSize, static_cast<size_t>(1)) * gLstRecordSize;
+}
+
+/// Points the event to the next chunk of the mapped file. The pages of the chunk are
+/// released once the event is gone, so only the chunks still waiting to be parsed
+/// are held in memory.
 ///
+/// \param [in] lstEvent Pointer to an empty TLstEvent
+/// \returns number of bytes read, 0 at the end of the file
 int TLstFile::Read(std::shared_ptr<TRawEvent> lstEvent)
 {
-   if(fBytesRead < fFileSize) {
-      try {
-         std::static_pointer_cast<TLstEvent>(lstEvent)->SetData(fReadBuffer);
-      } catch(std::exception& e) {
-         std::cout<<e.what()<<std::endl;
+   if(fMappedFile == nullptr) {
+      return 0;
+   }
+   if(fMappedOffset + gLstRecordSize > fMappedSize) {
+      fEndOfFile = true;
+      return 0;
+   }
+   size_t size = std::min(fChunkSize, fMappedSize - fMappedOffset);
+   size -= size % gLstRecordSize;
+
+   char*                 data    = fMappedFile.get() + fMappedOffset;
+   std::shared_ptr<char> mapping = fMappedFile;
+   std::shared_ptr<char> chunk(data, [mapping, size](char* ptr) {
+#ifdef MADV_DONTNEED
+      // only whole pages inside this chunk can be dropped, the ones at the edges are shared with the neighbours
+      uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+      uintptr_t begin    = (reinterpret_cast<uintptr_t>(ptr) + pageSize - 1) & ~(pageSize - 1);
+      uintptr_t end      = (reinterpret_cast<uintptr_t>(ptr) + size) & ~(pageSize - 1);
+      if(begin < end) {
+         madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
       }
-      fBytesRead = fFileSize;
-      return fFileSize;
+#else
+      (void)ptr;
+#endif
+   });
+   std::static_pointer_cast<TLstEvent>(lstEvent)->SetData(size, data, chunk);
+
+   fMappedOffset += size;
+   fBytesRead = fMappedOffset;
+   if(fMappedSize - fMappedOffset < gLstRecordSize) {
+      // count any trailing partial record as read, so the progress ends at 100%
+      fBytesRead = fMappedSize;
    }
-   return 0;
+
+   return size;
 }
 
 int TLstFile::GetRunNumber()
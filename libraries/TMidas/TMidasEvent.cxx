@@ -89,6 +89,7 @@ void TMidasEvent::Clear(Option_t*)
       free(fData);
    }
    fData = nullptr;
+   fDataOwner.reset();
 
    fAllocatedByUs = false;
    fBanksN        = 0;
@@ -114,6 +115,15 @@ void TMidasEvent::SetData(uint32_t size, char* data)
    SwapBytes(false);
 }
 
+void TMidasEvent::SetData(uint32_t size, char* data, const std::shared_ptr<char>& owner)
+{
+   // Sets the data in the TMidasEvent to point into an external buffer
+   // without copying it. The owner keeps the buffer alive for as long as
+   // this event references it (used for memory mapped midas files).
+   fDataOwner = owner;
+   SetData(size, data);
+}
+
 uint16_t TMidasEvent::GetEventId() const
 {
    return fEventHeader.fEventId;
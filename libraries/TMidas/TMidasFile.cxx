@@ -5,6 +5,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <cerrno>
 #include <cassert>
 #include <cstdlib>
@@ -17,6 +19,8 @@
 
 #include "TMidasFile.h"
 #include "TMidasEvent.h"
+#include "TDecompressor.h"
+#include "TGRSIOptions.h"
 #include "TGRSIRunInfo.h"
 #include "GVersion.h"
 
@@ -44,6 +48,8 @@ TMidasFile::TMidasFile()
    fOutFile   = -1;
    fOutGzFile = nullptr;
 
+   fDecompressor = nullptr;
+
    fMaxBufferSize = 1E6;
 
    currentEventNumber = 0;
@@ -74,7 +80,17 @@ TMidasFile::~TMidasFile()
 std::string TMidasFile::Status(bool)
 {
    return Form(HIDE_CURSOR " Processing event %i have processed %.2fMB/%.2f MB              " SHOW_CURSOR "\r",
-               currentEventNumber, (fBytesRead / 1000000.0), (fFileSize / 1000000.0));
+               currentEventNumber, (GetBytesRead() / 1000000.0), (fFileSize / 1000000.0));
+}
+
+size_t TMidasFile::GetBytesRead()
+{
+   /// Returns the number of bytes read from the file. For compressed files this is
+   /// the number of compressed bytes read so far, so it can be compared to the file size.
+   if(fDecompressor != nullptr) {
+      return fDecompressor->GetCompressedBytesRead();
+   }
+   return fBytesRead;
 }
 
 static int hasSuffix(const char* name, const char* suffix)
@@ -111,13 +127,14 @@ static int hasSuffix(const char* name, const char* suffix)
 /// \returns "true" for succes, "false" for error, use GetLastError() to see why
 bool TMidasFile::Open(const char* filename)
 {
-   if(fFile > 0) {
+   if(fFile > 0 || fDecompressor != nullptr) {
       Close();
    }
 
    fFilename = filename;
 
-   std::string pipe;
+   std::string            pipe;
+   TDecompressor::EFormat format = TDecompressor::EFormat::kGzip;
 
    std::ifstream in(GetFilename(), std::ifstream::in | std::ifstream::binary);
    in.seekg(0, std::ifstream::end);
@@ -175,9 +192,22 @@ bool TMidasFile::Open(const char* filename)
 		pipe = "gzip -dc ";
 		pipe += filename;
 #endif
+   } else if(TDecompressor::FormatFromName(filename, format) && TDecompressor::IsSupported(format)) {
+      // decompress the file on separate threads
+      fDecompressor = new TDecompressor(filename, format, TGRSIOptions::Get()->DecompressionThreads());
+      if(!fDecompressor->Good()) {
+         fLastErrno = -1;
+         fLastError.assign(fDecompressor->GetLastError());
+         delete fDecompressor;
+         fDecompressor = nullptr;
+         return false;
+      }
    } else if(hasSuffix(filename, ".bz2") != 0) {
       pipe = "bzip2 -dc ";
       pipe += filename;
+   } else if(hasSuffix(filename, ".zst") != 0) {
+      pipe = "zstd -dc ";
+      pipe += filename;
    }
    // Note: We cannot use "cat" in a similar way to offload, and must open it directly.
    //       "cat" ends immediately on end-of-file, making live histograms impossible.
@@ -194,7 +224,7 @@ bool TMidasFile::Open(const char* filename)
       }
 
       fFile = fileno(reinterpret_cast<FILE*>(fPoFile));
-   } else {
+   } else if(fDecompressor == nullptr) {
 #ifndef O_LARGEFILE
 #define O_LARGEFILE 0
 #endif
@@ -222,9 +252,18 @@ bool TMidasFile::Open(const char* filename)
          fLastError.assign("Do not know how to read compressed MIDAS files");
          return false;
 #endif
+      } else if(!MapFile()) {
+         fprintf(stderr, "TMidasFile::Open: failed to memory map %s (%s), using buffered reads\n", filename,
+                 GetLastError());
       }
    }
 
+   // build the index while reading the file sequentially
+   fIndex.clear();
+   fIndexInterval = TGRSIOptions::Get()->MidasIndexInterval();
+   fIndexing      = IsSeekable() && fIndexInterval > 0;
+   fEndOffset     = 0;
+
    Read(fFirstEvent);
    TGRSIRunInfo::SetRunInfo(GetRunNumber(), GetSubRunNumber());
    TGRSIRunInfo::SetGRSIVersion(GRSI_RELEASE);
@@ -323,12 +362,24 @@ int TMidasFile::Read(TRawEvent *event)
   if(event == nullptr) {
       return -1;
    }
-   TMidasEvent* midasEvent = (TMidasEvent*)event;
+   TMidasEvent* midasEvent = static_cast<TMidasEvent*>(event);
+   if(fEndOffset > 0 && GetOffset() >= fEndOffset) {
+      fEndOfFile = true;
+      return 0;
+   }
+   if(IsMapped()) {
+      return ReadMapped(midasEvent);
+   }
    if(fReadBuffer.size() < sizeof(TMidas_EVENT_HEADER)) {
-      ReadMoreBytes(sizeof(TMidas_EVENT_HEADER) - fReadBuffer.size());
+      if(!ReadMoreBytes(sizeof(TMidas_EVENT_HEADER) - fReadBuffer.size())) {
+         return -1;
+      }
    }
 
    if(fReadBuffer.size() < sizeof(TMidas_EVENT_HEADER)) {
+      if(fReadBuffer.empty()) {
+         EndOfFile();
+      }
       return 0;
    }
 
@@ -348,7 +399,9 @@ int TMidasFile::Read(TRawEvent *event)
    size_t total_size = sizeof(TMidas_EVENT_HEADER) + event_size;
 
    if(fReadBuffer.size() < total_size) {
-      ReadMoreBytes(total_size - fReadBuffer.size());
+      if(!ReadMoreBytes(total_size - fReadBuffer.size())) {
+         return -1;
+      }
    }
 
    if(fReadBuffer.size() < total_size) {
@@ -358,6 +411,8 @@ int TMidasFile::Read(TRawEvent *event)
    memcpy(midasEvent->GetData(), fReadBuffer.data() + sizeof(TMidas_EVENT_HEADER), event_size);
    midasEvent->SwapBytes(false);
 
+   AddIndexEntry(fBytesRead, midasEvent);
+
    size_t bytes_read = fReadBuffer.size();
    fBytesRead += bytes_read;
    currentEventNumber++;
@@ -367,22 +422,118 @@ int TMidasFile::Read(TRawEvent *event)
 }
 
 
-int TMidasFile::Read(std::shared_ptr<TRawEvent> event) {
+int TMidasFile::Read(std::shared_ptr<TRawEvent> event)
+{
+   return Read(event.get());
+}
 
-   if(event == nullptr) {
-      return -1;
+bool TMidasFile::MapFile()
+{
+   /// Memory maps the whole input file. The mapping is private, so in-place
+   /// byte swapping of an event only touches a copy-on-write page and never
+   /// the file itself. The mapping is released once the file is closed and
+   /// the last event referencing it is gone.
+   struct stat fileStat;
+   if(fstat(fFile, &fileStat) != 0) {
+      fLastErrno = errno;
+      fLastError.assign(std::strerror(errno));
+      return false;
    }
-   std::shared_ptr<TMidasEvent> midasEvent = std::static_pointer_cast<TMidasEvent>(event);
-   if(fReadBuffer.size() < sizeof(TMidas_EVENT_HEADER)) {
-      ReadMoreBytes(sizeof(TMidas_EVENT_HEADER) - fReadBuffer.size());
+   if(!S_ISREG(fileStat.st_mode) || fileStat.st_size <= 0) {
+      fLastErrno = -1;
+      fLastError.assign("not a regular, non-empty file");
+      return false;
    }
 
-   if(fReadBuffer.size() < sizeof(TMidas_EVENT_HEADER)) {
+   size_t size = static_cast<size_t>(fileStat.st_size);
+   void*  addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fFile, 0);
+   if(addr == MAP_FAILED) {
+      fLastErrno = errno;
+      fLastError.assign(std::strerror(errno));
+      return false;
+   }
+#ifdef MADV_SEQUENTIAL
+   madvise(addr, size, MADV_SEQUENTIAL);
+#endif
+
+   fMappedFile.reset(static_cast<char*>(addr), [size](char* ptr) { munmap(ptr, size); });
+   fMappedSize = size;
+   fFileSize   = size;
+
+   return true;
+}
+
+void TMidasFile::Prefetch()
+{
+   /// Asks the kernel to start reading the mapped file in the background, so that it
+   /// is (at least partially) cached by the time we get to it.
+#ifdef MADV_WILLNEED
+   if(IsMapped()) {
+      madvise(fMappedFile.get(), fMappedSize, MADV_WILLNEED);
+   }
+#endif
+}
+
+void TMidasFile::UnmapFile()
+{
+   fMappedFile.reset();
+   fMappedSize   = 0;
+   fMappedOffset = 0;
+}
+
+bool TMidasFile::EnsureMapped(size_t bytes)
+{
+   /// Checks that the next "bytes" bytes are inside the mapping. If they aren't, the file might
+   /// still be written to (online sorting), so we check if it has grown and re-map it.
+   if(fMappedOffset + bytes <= fMappedSize) {
+      return true;
+   }
+   struct stat fileStat;
+   if(fstat(fFile, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < fMappedOffset + bytes) {
+      fLastErrno = 0;
+      fLastError.assign("EOF");
+      return false;
+   }
+   size_t offset = fMappedOffset;
+   UnmapFile();
+   if(!MapFile()) {
+      // fall back to reading the file, from where we stopped reading the mapping
+      if(lseek(fFile, offset, SEEK_SET) < 0) {
+         fLastErrno = errno;
+         fLastError.assign(std::strerror(errno));
+         std::cerr<<"Failed to re-map "<<fFilename<<" and to seek to offset "<<offset<<": "<<fLastError<<std::endl;
+         return false;
+      }
+      std::cerr<<"Failed to re-map "<<fFilename<<" ("<<fLastError<<"), continuing without memory mapping"<<std::endl;
+      fLastErrno = 0;
+      fLastError.clear();
+      fReadBuffer.clear();
+      fBytesRead = offset;
+      return false;
+   }
+   fMappedOffset = offset;
+
+   return fMappedOffset + bytes <= fMappedSize;
+}
+
+int TMidasFile::ReadMapped(TMidasEvent* midasEvent)
+{
+   /// Reads the next event from the memory mapped file. The event header is
+   /// copied, the data is referenced in place.
+   if(!EnsureMapped(sizeof(TMidas_EVENT_HEADER))) {
+      if(!IsMapped() && fLastErrno == 0) {
+         // re-mapping the file failed, so we continue reading it without the mapping (see EnsureMapped)
+         return Read(midasEvent);
+      }
+      if(fMappedOffset == fMappedSize) {
+         EndOfFile();
+      }
       return 0;
    }
 
    midasEvent->Clear();
-   memcpy(reinterpret_cast<char*>(midasEvent->GetEventHeader()), fReadBuffer.data(), sizeof(TMidas_EVENT_HEADER));
+   memcpy(reinterpret_cast<char*>(midasEvent->GetEventHeader()), fMappedFile.get() + fMappedOffset,
+          sizeof(TMidas_EVENT_HEADER));
    if(fDoByteSwap) {
       printf("Swapping bytes\n");
       midasEvent->SwapBytesEventHeader();
@@ -396,31 +547,303 @@ int TMidasFile::Read(std::shared_ptr<TRawEvent> event) {
    size_t event_size = midasEvent->GetDataSize();
    size_t total_size = sizeof(TMidas_EVENT_HEADER) + event_size;
 
-   if(fReadBuffer.size() < total_size) {
-      ReadMoreBytes(total_size - fReadBuffer.size());
-   }
-
-   if(fReadBuffer.size() < total_size) {
+   if(!EnsureMapped(total_size)) {
+      if(!IsMapped() && fLastErrno == 0) {
+         return Read(midasEvent);
+      }
       return 0;
    }
 
-   memcpy(midasEvent->GetData(), fReadBuffer.data() + sizeof(TMidas_EVENT_HEADER), event_size);
-   midasEvent->SwapBytes(false);
+   midasEvent->SetData(event_size, fMappedFile.get() + fMappedOffset + sizeof(TMidas_EVENT_HEADER), fMappedFile);
+   AddIndexEntry(fMappedOffset, midasEvent);
 
-   size_t bytes_read = fReadBuffer.size();
-   fBytesRead += bytes_read;
+   fMappedOffset += total_size;
+   fBytesRead += total_size;
    currentEventNumber++;
+
+   return total_size;
+}
+
+bool TMidasFile::IsSeekable() const
+{
+   /// Only uncompressed local files can be positioned, for compressed files and pipes we can only read sequentially.
+   return fFile > 0 && fPoFile == nullptr && fGzFile == nullptr && fDecompressor == nullptr;
+}
+
+size_t TMidasFile::GetOffset() const
+{
+   /// Returns the offset of the next event in the file (only meaningful for uncompressed files).
+   if(IsMapped()) {
+      return fMappedOffset;
+   }
+   return fBytesRead;
+}
+
+bool TMidasFile::SeekOffset(size_t offset)
+{
+   /// Positions the file at offset, which has to be the start of an event (e.g. from the index).
+   if(!IsSeekable()) {
+      fLastErrno = -1;
+      fLastError.assign("Can't seek in compressed files or pipes");
+      return false;
+   }
+   // we're not reading the file sequentially anymore
+   fIndexing  = false;
+   fEndOfFile = false;
+
+   if(IsMapped()) {
+      fMappedOffset = offset;
+      return true;
+   }
+   if(lseek(fFile, offset, SEEK_SET) < 0) {
+      fLastErrno = errno;
+      fLastError.assign(std::strerror(errno));
+      return false;
+   }
    fReadBuffer.clear();
+   fBytesRead = offset;
 
-   return bytes_read;
+   return true;
 }
 
-void TMidasFile::ReadMoreBytes(size_t bytes)
+bool TMidasFile::Seek(uint32_t serialNumber, uint16_t eventId)
+{
+   /// Positions the file at the first event with the given event id and a serial number of at least serialNumber.
+   if(!LoadIndex()) {
+      return false;
+   }
+   // find the last index entry before the event we're looking for, and scan the headers from there
+   size_t offset = 0;
+   for(const auto& entry : fIndex) {
+      if(entry.fEventId == eventId && entry.fSerialNumber <= serialNumber) {
+         offset = entry.fOffset;
+      }
+   }
+   TMidas_EVENT_HEADER header;
+   while(ReadHeaderAt(offset, header)) {
+      if(header.fEventId == eventId && header.fSerialNumber >= serialNumber) {
+         return SeekOffset(offset);
+      }
+      offset += sizeof(TMidas_EVENT_HEADER) + header.fDataSize;
+   }
+
+   fLastErrno = -1;
+   fLastError.assign(Form("No event with id %d and serial number %u found", eventId, serialNumber));
+   return false;
+}
+
+bool TMidasFile::SeekTime(uint32_t time)
+{
+   /// Positions the file at the first event with a midas time stamp of at least time.
+   if(!LoadIndex()) {
+      return false;
+   }
+   size_t offset = 0;
+   for(const auto& entry : fIndex) {
+      if(entry.fTimeStamp >= time) {
+         break;
+      }
+      offset = entry.fOffset;
+   }
+   TMidas_EVENT_HEADER header;
+   while(ReadHeaderAt(offset, header)) {
+      if(header.fTimeStamp >= time) {
+         return SeekOffset(offset);
+      }
+      offset += sizeof(TMidas_EVENT_HEADER) + header.fDataSize;
+   }
+
+   fLastErrno = -1;
+   fLastError.assign(Form("No event with time stamp %u or later found", time));
+   return false;
+}
+
+bool TMidasFile::ReadHeaderAt(size_t offset, TMidas_EVENT_HEADER& header)
+{
+   /// Reads the event header at offset without changing the current position, returns false if there is
+   /// no complete header at this offset or if the event size is invalid.
+   TMidasEvent event;
+   if(IsMapped()) {
+      if(offset + sizeof(TMidas_EVENT_HEADER) > fMappedSize) {
+         return false;
+      }
+      memcpy(reinterpret_cast<char*>(event.GetEventHeader()), fMappedFile.get() + offset, sizeof(TMidas_EVENT_HEADER));
+   } else if(pread(fFile, event.GetEventHeader(), sizeof(TMidas_EVENT_HEADER), offset) !=
+             static_cast<ssize_t>(sizeof(TMidas_EVENT_HEADER))) {
+      return false;
+   }
+   if(fDoByteSwap) {
+      event.SwapBytesEventHeader();
+   }
+   if(!event.IsGoodSize()) {
+      return false;
+   }
+   header = *event.GetEventHeader();
+
+   return true;
+}
+
+void TMidasFile::AddIndexEntry(size_t offset, TMidasEvent* midasEvent)
+{
+   if(!fIndexing) {
+      return;
+   }
+   if(currentEventNumber % fIndexInterval == 0) {
+      fIndex.push_back({offset, midasEvent->GetSerialNumber(), midasEvent->GetTimeStamp(), midasEvent->GetEventId()});
+   }
+}
+
+void TMidasFile::EndOfFile()
+{
+   /// Called when we reached the end of the file. If we read the whole file sequentially we have a
+   /// complete index, which we write to the sidecar file if requested.
+   fEndOfFile = true;
+   if(fIndexing && TGRSIOptions::Get()->WriteMidasIndex()) {
+      WriteIndex();
+   }
+   fIndexing = false;
+}
+
+bool TMidasFile::LoadIndex()
+{
+   /// Makes sure we have a complete index, either from the sidecar file or by scanning the event headers.
+   if(!IsSeekable()) {
+      fLastErrno = -1;
+      fLastError.assign("Can't seek in compressed files or pipes");
+      return false;
+   }
+   // an index that is still being built while reading isn't complete yet
+   if(!fIndexing && !fIndex.empty()) {
+      return true;
+   }
+   if(ReadIndex()) {
+      return true;
+   }
+   return BuildIndex(fIndexInterval > 0 ? fIndexInterval : 1000);
+}
+
+bool TMidasFile::BuildIndex(int interval)
+{
+   /// Builds the index by jumping from event header to event header. This is fast for memory mapped files,
+   /// as only the pages containing the headers need to be read.
+   if(!IsSeekable() || interval <= 0) {
+      fLastErrno = -1;
+      fLastError.assign("Can't build an index for compressed files or pipes");
+      return false;
+   }
+   fIndex.clear();
+   fIndexInterval = interval;
+   fIndexing      = false;
+
+   size_t              offset = 0;
+   int                 event  = 0;
+   TMidas_EVENT_HEADER header;
+   while(ReadHeaderAt(offset, header)) {
+      if(event % interval == 0) {
+         fIndex.push_back({offset, header.fSerialNumber, header.fTimeStamp, header.fEventId});
+      }
+      offset += sizeof(TMidas_EVENT_HEADER) + header.fDataSize;
+      ++event;
+   }
+
+   return !fIndex.empty();
+}
+
+static size_t CurrentFileSize(int fd)
+{
+   struct stat fileStat;
+   if(fstat(fd, &fileStat) != 0) {
+      return 0;
+   }
+   return static_cast<size_t>(fileStat.st_size);
+}
+
+static const char     indexMagic[4] = {'M', 'I', 'D', 'X'};
+static const uint32_t indexVersion  = 1;
+
+bool TMidasFile::ReadIndex()
+{
+   /// Reads the index from the sidecar file. The index is only used if it was written for a file of the
+   /// same size, i.e. not while the file was still being written.
+   std::ifstream in(IndexFilename(), std::ifstream::in | std::ifstream::binary);
+   if(!in.is_open()) {
+      return false;
+   }
+   char     magic[4];
+   uint32_t version  = 0;
+   uint32_t interval = 0;
+   uint64_t fileSize = 0;
+   uint64_t entries  = 0;
+   in.read(magic, sizeof(magic));
+   in.read(reinterpret_cast<char*>(&version), sizeof(version));
+   in.read(reinterpret_cast<char*>(&interval), sizeof(interval));
+   in.read(reinterpret_cast<char*>(&fileSize), sizeof(fileSize));
+   in.read(reinterpret_cast<char*>(&entries), sizeof(entries));
+   if(!in.good() || memcmp(magic, indexMagic, sizeof(magic)) != 0 || version != indexVersion) {
+      std::cerr<<"TMidasFile::ReadIndex: "<<IndexFilename()<<" is not a valid midas index file"<<std::endl;
+      return false;
+   }
+   if(fileSize != CurrentFileSize(fFile)) {
+      std::cerr<<"TMidasFile::ReadIndex: "<<IndexFilename()<<" is out of date, ignoring it"<<std::endl;
+      return false;
+   }
+
+   std::vector<TMidasIndexEntry> index(entries);
+   for(auto& entry : index) {
+      in.read(reinterpret_cast<char*>(&entry.fOffset), sizeof(entry.fOffset));
+      in.read(reinterpret_cast<char*>(&entry.fSerialNumber), sizeof(entry.fSerialNumber));
+      in.read(reinterpret_cast<char*>(&entry.fTimeStamp), sizeof(entry.fTimeStamp));
+      in.read(reinterpret_cast<char*>(&entry.fEventId), sizeof(entry.fEventId));
+   }
+   if(!in.good()) {
+      std::cerr<<"TMidasFile::ReadIndex: failed to read "<<entries<<" entries from "<<IndexFilename()<<std::endl;
+      return false;
+   }
+
+   fIndex.swap(index);
+   fIndexInterval = interval;
+   fIndexing      = false;
+
+   return true;
+}
+
+bool TMidasFile::WriteIndex()
+{
+   /// Writes the index to the sidecar file (<file name>.idx).
+   if(fIndex.empty()) {
+      return false;
+   }
+   std::ofstream out(IndexFilename(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+   if(!out.is_open()) {
+      std::cerr<<"TMidasFile::WriteIndex: failed to open "<<IndexFilename()<<std::endl;
+      return false;
+   }
+   uint32_t interval = fIndexInterval;
+   uint64_t fileSize = CurrentFileSize(fFile);
+   uint64_t entries  = fIndex.size();
+   out.write(indexMagic, sizeof(indexMagic));
+   out.write(reinterpret_cast<const char*>(&indexVersion), sizeof(indexVersion));
+   out.write(reinterpret_cast<const char*>(&interval), sizeof(interval));
+   out.write(reinterpret_cast<const char*>(&fileSize), sizeof(fileSize));
+   out.write(reinterpret_cast<const char*>(&entries), sizeof(entries));
+   for(const auto& entry : fIndex) {
+      out.write(reinterpret_cast<const char*>(&entry.fOffset), sizeof(entry.fOffset));
+      out.write(reinterpret_cast<const char*>(&entry.fSerialNumber), sizeof(entry.fSerialNumber));
+      out.write(reinterpret_cast<const char*>(&entry.fTimeStamp), sizeof(entry.fTimeStamp));
+      out.write(reinterpret_cast<const char*>(&entry.fEventId), sizeof(entry.fEventId));
+   }
+
+   return out.good();
+}
+
+bool TMidasFile::ReadMoreBytes(size_t bytes)
 {
    size_t initial_size = fReadBuffer.size();
    fReadBuffer.resize(initial_size + bytes);
    size_t rd = 0;
-   if(fGzFile != nullptr) {
+   if(fDecompressor != nullptr) {
+      rd = fDecompressor->Read(fReadBuffer.data() + initial_size, bytes);
+   } else if(fGzFile != nullptr) {
 #ifdef HAVE_ZLIB
       rd = gzread(*(gzFile*)fGzFile, fReadBuffer.data() + initial_size, bytes);
 #else
@@ -432,6 +855,13 @@ void TMidasFile::ReadMoreBytes(size_t bytes)
 
    fReadBuffer.resize(initial_size + rd);
 
+   if(rd < bytes && fDecompressor != nullptr && !fDecompressor->Good()) {
+      // the decompressor stopped at an error, so this isn't the end of the file
+      fLastErrno = EIO;
+      fLastError.assign(fDecompressor->GetLastError());
+      std::cerr<<"Error reading "<<GetFilename()<<": "<<fLastError<<std::endl;
+      return false;
+   }
    if(rd == 0) {
       fLastErrno = 0;
       fLastError.assign("EOF");
@@ -439,6 +869,7 @@ void TMidasFile::ReadMoreBytes(size_t bytes)
       fLastErrno = errno;
       fLastError.assign(std::strerror(errno));
    }
+   return true;
 }
 
 void TMidasFile::FillBuffer(const std::shared_ptr<TMidasEvent>& midasEvent, Option_t*)
@@ -563,6 +994,9 @@ void TMidasFile::Close()
    if(fGzFile) gzclose(*(gzFile*)fGzFile);
    fGzFile = nullptr;
 #endif
+   UnmapFile();
+   delete fDecompressor;
+   fDecompressor = nullptr;
    if(fFile > 0) {
       close(fFile);
    }
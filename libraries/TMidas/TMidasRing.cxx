@@ -0,0 +1,339 @@
+#include "TMidasRing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "TString.h"
+
+#include "Globals.h"
+
+#include "TGRSIRunInfo.h"
+#include "GVersion.h"
+
+/// \cond CLASSIMP
+ClassImp(TMidasRing)
+/// \endcond
+
+/// Layout of the shared memory, the data area follows directly after this header.
+/// The positions are the total number of bytes written/read, the position inside
+/// the data area is the position modulo the size.
+struct TMidasRingHeader {
+   char                  fMagic[4];      ///< "MRNG"
+   uint32_t              fVersion;       ///< version of the layout
+   uint64_t              fSize;          ///< size of the data area in bytes
+   std::atomic<uint64_t> fWritePosition; ///< advanced by the producer after it has written a complete event
+   std::atomic<uint64_t> fReadPosition;  ///< advanced by the reader after it has copied an event
+   std::atomic<uint32_t> fFinished;      ///< set by the producer after it wrote the last event
+   uint32_t              fPadding;
+};
+
+static const char     gRingMagic[4] = {'M', 'R', 'N', 'G'};
+static const uint32_t gRingVersion  = 1;
+
+static std::string RingName(const char* name)
+{
+   /// POSIX shared memory names have to start with a slash.
+   std::string result(name);
+   if(result.empty() || result[0] != '/') {
+      result.insert(0, "/");
+   }
+   return result;
+}
+
+TMidasRing::TMidasRing()
+   : fRing(nullptr), fData(nullptr), fMappedSize(0), fOwner(false), fBroken(false), fTimeout(100), fRunNumber(0),
+     fEventsRead(0)
+{
+}
+
+TMidasRing::TMidasRing(const char* name, EOpenType open_type) : TMidasRing()
+{
+   switch(open_type) {
+   case EOpenType::kRead: Open(name); break;
+   case EOpenType::kWrite: Create(name, 64 * 1024 * 1024); break;
+   }
+}
+
+TMidasRing::~TMidasRing()
+{
+   Close();
+}
+
+bool TMidasRing::Map(int fd, size_t size)
+{
+   void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if(ptr == MAP_FAILED) {
+      fLastError.assign(std::strerror(errno));
+      return false;
+   }
+   fRing       = static_cast<TMidasRingHeader*>(ptr);
+   fData       = static_cast<char*>(ptr) + sizeof(TMidasRingHeader);
+   fMappedSize = size;
+   return true;
+}
+
+bool TMidasRing::Create(const char* name, size_t size)
+{
+   /// Creates a new ring with a data area of size bytes. Any old ring of the same name is removed first.
+   Close();
+   fFilename = RingName(name);
+   shm_unlink(fFilename.c_str());
+
+   int fd = shm_open(fFilename.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+   if(fd < 0) {
+      fLastError.assign(std::strerror(errno));
+      return false;
+   }
+   if(ftruncate(fd, sizeof(TMidasRingHeader) + size) != 0 || !Map(fd, sizeof(TMidasRingHeader) + size)) {
+      if(fLastError.empty()) {
+         fLastError.assign(std::strerror(errno));
+      }
+      close(fd);
+      shm_unlink(fFilename.c_str());
+      return false;
+   }
+   close(fd);
+
+   // the new memory is zeroed, we only need to set the atomics properly and the magic last
+   new(&fRing->fWritePosition) std::atomic<uint64_t>(0);
+   new(&fRing->fReadPosition) std::atomic<uint64_t>(0);
+   new(&fRing->fFinished) std::atomic<uint32_t>(0);
+   fRing->fVersion = gRingVersion;
+   fRing->fSize    = size;
+   std::atomic_thread_fence(std::memory_order_release);
+   memcpy(fRing->fMagic, gRingMagic, sizeof(gRingMagic));
+
+   fOwner = true;
+   return true;
+}
+
+bool TMidasRing::Open(const char* name)
+{
+   /// Attaches to an existing ring as reader and reads the first event.
+   Close();
+   fFilename = RingName(name);
+
+   int fd = shm_open(fFilename.c_str(), O_RDWR, 0);
+   if(fd < 0) {
+      fLastError.assign(std::strerror(errno));
+      return false;
+   }
+   struct stat st;
+   if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TMidasRingHeader)) {
+      fLastError.assign("ring is too small");
+      close(fd);
+      return false;
+   }
+   if(!Map(fd, st.st_size)) {
+      close(fd);
+      return false;
+   }
+   close(fd);
+
+   if(memcmp(fRing->fMagic, gRingMagic, sizeof(gRingMagic)) != 0 || fRing->fVersion != gRingVersion ||
+      fRing->fSize + sizeof(TMidasRingHeader) > fMappedSize) {
+      fLastError.assign("not a midas ring (or wrong version)");
+      Close();
+      return false;
+   }
+
+   // the first event should be the begin-of-run ODB dump, this can take a while if the run hasn't started yet
+   std::cout<<"Waiting for the first event in ring "<<fFilename<<" ..."<<std::endl;
+   fFirstEvent = std::make_shared<TMidasEvent>();
+   while(Read(fFirstEvent.get()) <= 0) {
+      if(!IsLive()) {
+         fLastError.assign("no events in ring");
+         return false;
+      }
+   }
+   if(fFirstEvent->GetEventId() == 0x8000) {
+      fRunNumber = fFirstEvent->GetSerialNumber();
+   } else {
+      std::cout<<"First event in ring "<<fFilename<<" isn't a begin-of-run event, no ODB available!"<<std::endl;
+      fPendingEvent = fFirstEvent;
+      fFirstEvent   = std::make_shared<TMidasEvent>();
+   }
+   TGRSIRunInfo::SetRunInfo(GetRunNumber(), GetSubRunNumber());
+   TGRSIRunInfo::SetGRSIVersion(GRSI_RELEASE);
+
+   return true;
+}
+
+void TMidasRing::Close()
+{
+   if(fRing != nullptr) {
+      munmap(fRing, fMappedSize);
+      if(fOwner) {
+         shm_unlink(fFilename.c_str());
+      }
+   }
+   fRing       = nullptr;
+   fData       = nullptr;
+   fMappedSize = 0;
+   fOwner      = false;
+   fBroken     = false;
+   fPendingEvent.reset();
+}
+
+void TMidasRing::CopyIn(uint64_t position, const char* source, size_t size)
+{
+   size_t offset = position % fRing->fSize;
+   size_t first  = std::min(size, static_cast<size_t>(fRing->fSize - offset));
+   memcpy(fData + offset, source, first);
+   memcpy(fData, source + first, size - first);
+}
+
+void TMidasRing::CopyOut(uint64_t position, char* destination, size_t size) const
+{
+   size_t offset = position % fRing->fSize;
+   size_t first  = std::min(size, static_cast<size_t>(fRing->fSize - offset));
+   memcpy(destination, fData + offset, first);
+   memcpy(destination + first, fData, size - first);
+}
+
+bool TMidasRing::WaitForEvent()
+{
+   /// Waits up to fTimeout ms for an event. The producer only publishes complete events,
+   /// so any unread byte means a complete event is there.
+   auto start = std::chrono::steady_clock::now();
+   while(true) {
+      if(fRing->fWritePosition.load(std::memory_order_acquire) > fRing->fReadPosition.load(std::memory_order_relaxed)) {
+         return true;
+      }
+      if(fRing->fFinished.load(std::memory_order_acquire) != 0) {
+         // check again, the last event might have been written just before the flag was set
+         return fRing->fWritePosition.load(std::memory_order_acquire) >
+                fRing->fReadPosition.load(std::memory_order_relaxed);
+      }
+      if(std::chrono::steady_clock::now() - start > std::chrono::milliseconds(fTimeout)) {
+         return false;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+   }
+}
+
+int TMidasRing::Read(std::shared_ptr<TRawEvent> event)
+{
+   return Read(static_cast<TMidasEvent*>(event.get()));
+}
+
+int TMidasRing::Read(TMidasEvent* midasEvent)
+{
+   /// Copies the next event out of the ring. Returns the size of the event, or 0 if
+   /// no event arrived within the timeout (check IsLive() to see if more can come).
+   if(fRing == nullptr || fBroken || midasEvent == nullptr) {
+      return 0;
+   }
+   if(fPendingEvent != nullptr) {
+      *midasEvent = *fPendingEvent;
+      fPendingEvent.reset();
+      return sizeof(TMidas_EVENT_HEADER) + midasEvent->GetDataSize();
+   }
+   if(!WaitForEvent()) {
+      return 0;
+   }
+
+   uint64_t position = fRing->fReadPosition.load(std::memory_order_relaxed);
+   midasEvent->Clear();
+   CopyOut(position, reinterpret_cast<char*>(midasEvent->GetEventHeader()), sizeof(TMidas_EVENT_HEADER));
+   size_t eventSize = midasEvent->GetDataSize();
+   size_t totalSize = sizeof(TMidas_EVENT_HEADER) + eventSize;
+   if(!midasEvent->IsGoodSize() || position + totalSize > fRing->fWritePosition.load(std::memory_order_acquire)) {
+      fLastError.assign("Invalid event size");
+      std::cerr<<"TMidasRing: found corrupted event in ring "<<fFilename<<", stopping"<<std::endl;
+      fBroken = true;
+      return 0;
+   }
+
+   std::shared_ptr<char> data(new char[eventSize], std::default_delete<char[]>());
+   CopyOut(position + sizeof(TMidas_EVENT_HEADER), data.get(), eventSize);
+   midasEvent->SetData(eventSize, data.get(), data);
+
+   fRing->fReadPosition.store(position + totalSize, std::memory_order_release);
+   fBytesRead += totalSize;
+   ++fEventsRead;
+
+   return totalSize;
+}
+
+bool TMidasRing::Write(const std::shared_ptr<TMidasEvent>& midasEvent)
+{
+   /// Writes a complete event into the ring and then publishes it. Blocks while the ring is full.
+   if(fRing == nullptr) {
+      return false;
+   }
+   size_t totalSize = sizeof(TMidas_EVENT_HEADER) + midasEvent->GetDataSize();
+   if(totalSize > fRing->fSize) {
+      fLastError.assign("event is larger than the ring");
+      return false;
+   }
+   uint64_t position = fRing->fWritePosition.load(std::memory_order_relaxed);
+   while(position + totalSize - fRing->fReadPosition.load(std::memory_order_acquire) > fRing->fSize) {
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+   }
+   CopyIn(position, reinterpret_cast<const char*>(midasEvent->GetEventHeader()), sizeof(TMidas_EVENT_HEADER));
+   CopyIn(position + sizeof(TMidas_EVENT_HEADER), midasEvent->GetData(), midasEvent->GetDataSize());
+   fRing->fWritePosition.store(position + totalSize, std::memory_order_release);
+   fBytesRead += totalSize;
+
+   return true;
+}
+
+void TMidasRing::SetFinished()
+{
+   if(fRing != nullptr) {
+      fRing->fFinished.store(1, std::memory_order_release);
+   }
+}
+
+bool TMidasRing::IsLive() const
+{
+   /// The ring is live as long as the producer hasn't finished or there are unread events.
+   if(fRing == nullptr || fBroken) {
+      return false;
+   }
+   return fPendingEvent != nullptr || fRing->fFinished.load(std::memory_order_acquire) == 0 ||
+          fRing->fWritePosition.load(std::memory_order_acquire) > fRing->fReadPosition.load(std::memory_order_relaxed);
+}
+
+size_t TMidasRing::GetFileSize()
+{
+   if(fRing == nullptr) {
+      return 0;
+   }
+   return fRing->fWritePosition.load(std::memory_order_relaxed);
+}
+
+size_t TMidasRing::GetBytesUnread() const
+{
+   if(fRing == nullptr) {
+      return 0;
+   }
+   return fRing->fWritePosition.load(std::memory_order_relaxed) - fRing->fReadPosition.load(std::memory_order_acquire);
+}
+
+int TMidasRing::GetRunNumber()
+{
+   return fRunNumber;
+}
+
+std::string TMidasRing::Status(bool)
+{
+   size_t behind = 0;
+   if(fRing != nullptr) {
+      behind = fRing->fWritePosition.load(std::memory_order_relaxed) - fRing->fReadPosition.load(std::memory_order_relaxed);
+   }
+   return Form(HIDE_CURSOR " Processing event %i from ring %s, %.2f MB behind              " SHOW_CURSOR "\r",
+               fEventsRead, fFilename.c_str(), behind / 1000000.);
+}
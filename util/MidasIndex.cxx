@@ -0,0 +1,56 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "TMidasFile.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// This program writes the .mid.idx index file for each (uncompressed) midas
+/// file given. The index contains offset, serial number, time stamp, and
+/// event id of every N-th event (default 1000, can be changed with -n N), and
+/// lets TMidasFile::Seek/SeekTime jump into the file.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   if(argc == 1) {
+      std::cout<<"Usage: "<<argv[0]<<" [-n <events between entries>] <midas file(s)>"<<std::endl;
+      return -1;
+   }
+
+   int interval = 1000;
+   int result   = 0;
+   for(int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if(arg == "-n" && i + 1 < argc) {
+         interval = atoi(argv[++i]);
+         if(interval <= 0) {
+            std::cerr<<"Invalid interval "<<argv[i]<<std::endl;
+            return -1;
+         }
+         continue;
+      }
+
+      TMidasFile file;
+      if(!file.Open(arg.c_str())) {
+         std::cerr<<"Failed to open "<<arg<<": "<<file.GetLastError()<<std::endl;
+         result = 1;
+         continue;
+      }
+      if(!file.BuildIndex(interval)) {
+         std::cerr<<"Failed to build index for "<<arg<<": "<<file.GetLastError()<<std::endl;
+         result = 1;
+         continue;
+      }
+      if(!file.WriteIndex()) {
+         std::cerr<<"Failed to write index "<<file.IndexFilename()<<std::endl;
+         result = 1;
+         continue;
+      }
+      std::cout<<"Wrote "<<file.GetIndex().size()<<" entries to "<<file.IndexFilename()<<std::endl;
+   }
+
+   return result;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+#include "TMidasFile.h"
+#include "TMidasRing.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// This program creates a shared memory ring and replays midas files into it,
+/// so online sorting (grsisort --input-ring <name>) can be tested without a
+/// running DAQ. The ring size in MB can be set with -s (default 64), and the
+/// replay can be limited to a number of events per second with -r (default is
+/// as fast as the reader consumes them). Once all files have been written the
+/// program waits for the reader to read the remaining events, unless the
+/// reader hasn't read anything for the time set with -t (in seconds, default
+/// 30), e.g. because no reader is attached.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   if(argc < 3) {
+      std::cout<<"Usage: "<<argv[0]<<" [-s <ring size in MB>] [-r <events per second>] [-t <reader timeout in s>] "
+               <<"<ring name> <midas file(s)>"<<std::endl;
+      return -1;
+   }
+
+   size_t                   size    = 64;
+   double                   rate    = 0.;
+   double                   timeout = 30.;
+   std::vector<std::string> args;
+   for(int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if(arg == "-s" && i + 1 < argc) {
+         size = atoi(argv[++i]);
+      } else if(arg == "-r" && i + 1 < argc) {
+         rate = atof(argv[++i]);
+      } else if(arg == "-t" && i + 1 < argc) {
+         timeout = atof(argv[++i]);
+      } else {
+         args.push_back(arg);
+      }
+   }
+   if(args.size() < 2 || size == 0) {
+      std::cerr<<"Need a ring name, at least one midas file, and a non-zero ring size"<<std::endl;
+      return -1;
+   }
+
+   TMidasRing ring;
+   if(!ring.Create(args[0].c_str(), size * 1024 * 1024)) {
+      std::cerr<<"Failed to create ring "<<args[0]<<": "<<ring.GetLastError()<<std::endl;
+      return 1;
+   }
+   std::cout<<"Created ring "<<ring.GetFilename()<<" with "<<size<<" MB"<<std::endl;
+
+   auto start  = std::chrono::steady_clock::now();
+   long events = 0;
+   for(size_t f = 1; f < args.size(); ++f) {
+      TMidasFile file;
+      if(!file.Open(args[f].c_str())) {
+         std::cerr<<"Failed to open "<<args[f]<<": "<<file.GetLastError()<<std::endl;
+         continue;
+      }
+      // opening the file already read the first (begin-of-run) event, we only pass on the begin-of-run event of
+      // the first file
+      if((f == 1 || file.GetFirstEvent()->GetEventId() != 0x8000) && !ring.Write(file.GetFirstEvent())) {
+         std::cerr<<"Failed to write first event: "<<ring.GetLastError()<<std::endl;
+      }
+      auto event = std::make_shared<TMidasEvent>();
+      while(file.Read(event) > 0) {
+         if(!ring.Write(event)) {
+            std::cerr<<"Failed to write event "<<event->GetSerialNumber()<<": "<<ring.GetLastError()<<std::endl;
+         }
+         ++events;
+         if(rate > 0.) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(static_cast<long>(events * 1e6 / rate)));
+         }
+      }
+      std::cout<<"Replayed "<<args[f]<<", "<<events<<" events so far"<<std::endl;
+      file.Close();
+   }
+
+   ring.SetFinished();
+   std::cout<<"Waiting for the reader to finish ..."<<std::endl;
+   // the ring can't tell whether a reader is attached, so we give up once nothing has been read for a while
+   size_t unread       = ring.GetBytesUnread();
+   auto   lastProgress = std::chrono::steady_clock::now();
+   while(ring.IsLive()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      if(ring.GetBytesUnread() != unread) {
+         unread       = ring.GetBytesUnread();
+         lastProgress = std::chrono::steady_clock::now();
+      } else if(std::chrono::steady_clock::now() - lastProgress > std::chrono::duration<double>(timeout)) {
+         std::cerr<<"The reader didn't read anything for "<<timeout<<" s, "<<unread<<" bytes are left unread"<<std::endl;
+         break;
+      }
+   }
+   ring.Close();
+
+   return 0;
+}